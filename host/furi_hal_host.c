@@ -0,0 +1,279 @@
+#include "usb_hid_autofire_host.h"
+
+#include <bt/bt_service/bt.h>
+#include <extra_profiles/hid_profile.h>
+#include <furi_hal.h>
+#include <string.h>
+#include <time.h>
+
+#define HOST_HID_KEY_SLOTS 6U
+#define HOST_CORTEX_CYCLES_PER_US 64U
+
+struct FuriHalUsbInterface {
+  const char *name;
+};
+
+FuriHalUsbInterface usb_hid = {.name = "usb_hid"};
+static FuriHalUsbInterface usb_cdc_single = {.name = "usb_cdc_single"};
+static FuriHalUsbInterface *host_usb_config = &usb_cdc_single;
+
+static uint8_t host_mouse_buttons = 0U;
+static uint16_t host_keys[HOST_HID_KEY_SLOTS];
+static bool host_report_active = false;
+static bool host_polled_active = false;
+static bool host_poll_started = false;
+static uint32_t host_next_poll_tick = 0U;
+static HostHidStats host_hid = {
+    .interval_min_ms = UINT32_MAX,
+    .hold_min_ms = UINT32_MAX,
+};
+
+// The host only sees the report state at its own poll ticks, so changes
+// between two polls collapse. A poll at tick t runs before anything the
+// device sends at t, and every poll since the last report sees one state.
+static void host_hid_poll_until(uint32_t now) {
+  const HostSimConfig *config = host_sim_config();
+  uint32_t interval = config->poll_interval_ms;
+  if (interval == 0U) {
+    return;
+  }
+  if (!host_poll_started) {
+    host_next_poll_tick = config->poll_phase_ms % interval;
+    host_poll_started = true;
+  }
+  if ((int32_t)(host_next_poll_tick - now) > 0) {
+    return;
+  }
+
+  uint32_t polls = ((now - host_next_poll_tick) / interval) + 1U;
+  host_hid.polls += polls;
+  host_next_poll_tick += polls * interval;
+  if (host_report_active && !host_polled_active) {
+    host_hid.polled_press_edges++;
+  }
+  host_polled_active = host_report_active;
+}
+
+const HostHidStats *host_hid_stats(void) {
+  host_hid_poll_until(furi_get_tick());
+  return &host_hid;
+}
+
+FuriHalUsbInterface *furi_hal_usb_get_config(void) { return host_usb_config; }
+
+bool furi_hal_usb_set_config(FuriHalUsbInterface *new_if, void *ctx) {
+  UNUSED(ctx);
+  host_usb_config = new_if;
+  return true;
+}
+
+void furi_hal_usb_unlock(void) {}
+
+// Counts a click as the edge from "nothing held" to "something held", which
+// is what the host sees for a single autofire target.
+static void host_hid_send_report(void) {
+  bool active = host_mouse_buttons != 0U;
+  for (size_t i = 0; i < HOST_HID_KEY_SLOTS; i++) {
+    active = active || (host_keys[i] != 0U);
+  }
+
+  uint32_t now = furi_get_tick();
+  host_hid_poll_until(now);
+  host_hid.reports++;
+  if (active && !host_report_active) {
+    if (host_hid.press_edges == 0U) {
+      host_hid.first_press_tick = now;
+    } else {
+      uint32_t interval_ms = now - host_hid.last_press_tick;
+      if (interval_ms < host_hid.interval_min_ms) {
+        host_hid.interval_min_ms = interval_ms;
+      }
+      if (interval_ms > host_hid.interval_max_ms) {
+        host_hid.interval_max_ms = interval_ms;
+      }
+      host_hid.interval_sum_ms += interval_ms;
+    }
+    host_hid.press_edges++;
+    host_hid.last_press_tick = now;
+  } else if (!active && host_report_active) {
+    uint32_t hold_ms = now - host_hid.last_press_tick;
+    if (hold_ms < host_hid.hold_min_ms) {
+      host_hid.hold_min_ms = hold_ms;
+    }
+    if (hold_ms > host_hid.hold_max_ms) {
+      host_hid.hold_max_ms = hold_ms;
+    }
+    host_hid.hold_sum_ms += hold_ms;
+    host_hid.release_edges++;
+  }
+  host_report_active = active;
+}
+
+static void host_hid_count_usage(bool mouse, uint16_t code) {
+  uint32_t now = furi_get_tick();
+  for (uint32_t i = 0U; i < host_hid.usage_count; i++) {
+    HostHidUsage *usage = &host_hid.usages[i];
+    if ((usage->mouse == mouse) && (usage->code == code)) {
+      uint32_t interval_ms = now - usage->last_press_tick;
+      if (interval_ms < usage->interval_min_ms) {
+        usage->interval_min_ms = interval_ms;
+      }
+      if (interval_ms > usage->interval_max_ms) {
+        usage->interval_max_ms = interval_ms;
+      }
+      usage->presses++;
+      usage->last_press_tick = now;
+      return;
+    }
+  }
+  if (host_hid.usage_count < HOST_HID_USAGE_SLOTS) {
+    host_hid.usages[host_hid.usage_count++] = (HostHidUsage){
+        .mouse = mouse,
+        .code = code,
+        .presses = 1U,
+        .first_press_tick = now,
+        .last_press_tick = now,
+        .interval_min_ms = UINT32_MAX,
+    };
+  }
+}
+
+bool furi_hal_hid_mouse_press(uint8_t button) {
+  for (uint32_t bit = 0U; bit < 8U; bit++) {
+    uint8_t mask = (uint8_t)(1U << bit);
+    if ((button & mask) && !(host_mouse_buttons & mask)) {
+      host_hid_count_usage(true, mask);
+    }
+  }
+  host_mouse_buttons |= button;
+  host_hid_send_report();
+  return true;
+}
+
+bool furi_hal_hid_mouse_release(uint8_t button) {
+  host_mouse_buttons &= (uint8_t)~button;
+  host_hid_send_report();
+  return true;
+}
+
+bool furi_hal_hid_kb_press(uint16_t button) {
+  for (size_t i = 0; i < HOST_HID_KEY_SLOTS; i++) {
+    if (host_keys[i] == button) {
+      host_hid_send_report();
+      return true;
+    }
+  }
+  host_hid_count_usage(false, button);
+  for (size_t i = 0; i < HOST_HID_KEY_SLOTS; i++) {
+    if (host_keys[i] == 0U) {
+      host_keys[i] = button;
+      break;
+    }
+  }
+  host_hid_send_report();
+  return true;
+}
+
+bool furi_hal_hid_kb_release(uint16_t button) {
+  for (size_t i = 0; i < HOST_HID_KEY_SLOTS; i++) {
+    if (host_keys[i] == button) {
+      host_keys[i] = 0U;
+    }
+  }
+  host_hid_send_report();
+  return true;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+  return HOST_CORTEX_CYCLES_PER_US;
+}
+
+FuriHalCortexTimer furi_hal_cortex_timer_get(uint32_t timeout_us) {
+  struct timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  uint64_t ns =
+      ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+  FuriHalCortexTimer timer = {
+      .start = (uint32_t)((ns * HOST_CORTEX_CYCLES_PER_US) / 1000U),
+      .value = timeout_us * HOST_CORTEX_CYCLES_PER_US,
+  };
+  return timer;
+}
+
+bool furi_hal_hid_kb_release_all(void) {
+  memset(host_keys, 0, sizeof(host_keys));
+  host_hid_send_report();
+  return true;
+}
+
+// BLE
+
+struct FuriHalBleProfileBase {
+  const char *name;
+};
+
+struct FuriHalBleProfileTemplate {
+  const char *name;
+};
+
+static const FuriHalBleProfileTemplate host_ble_profile_hid_template = {
+    .name = "hid",
+};
+const FuriHalBleProfileTemplate *ble_profile_hid =
+    &host_ble_profile_hid_template;
+static FuriHalBleProfileBase host_ble_profile = {.name = "hid"};
+
+FuriHalBleProfileBase *bt_profile_start(
+    Bt *bt, const FuriHalBleProfileTemplate *profile_template,
+    FuriHalBleProfileParams params) {
+  UNUSED(bt);
+  UNUSED(params);
+  host_ble_profile.name = profile_template->name;
+  return &host_ble_profile;
+}
+
+bool bt_profile_restore_default(Bt *bt) {
+  UNUSED(bt);
+  host_ble_profile.name = "serial";
+  return true;
+}
+
+void bt_disconnect(Bt *bt) { UNUSED(bt); }
+
+void bt_keys_storage_set_storage_path(Bt *bt, const char *keys_storage_path) {
+  UNUSED(bt);
+  UNUSED(keys_storage_path);
+}
+
+void bt_keys_storage_set_default_path(Bt *bt) { UNUSED(bt); }
+
+void furi_hal_bt_start_advertising(void) {}
+
+bool ble_profile_hid_kb_press(FuriHalBleProfileBase *profile,
+                              uint16_t button) {
+  UNUSED(profile);
+  return furi_hal_hid_kb_press(button);
+}
+
+bool ble_profile_hid_kb_release(FuriHalBleProfileBase *profile,
+                                uint16_t button) {
+  UNUSED(profile);
+  return furi_hal_hid_kb_release(button);
+}
+
+bool ble_profile_hid_kb_release_all(FuriHalBleProfileBase *profile) {
+  UNUSED(profile);
+  return furi_hal_hid_kb_release_all();
+}
+
+bool ble_profile_hid_mouse_press(FuriHalBleProfileBase *profile,
+                                 uint8_t button) {
+  UNUSED(profile);
+  return furi_hal_hid_mouse_press(button);
+}
+
+bool ble_profile_hid_mouse_release(FuriHalBleProfileBase *profile,
+                                   uint8_t button) {
+  UNUSED(profile);
+  return furi_hal_hid_mouse_release(button);
+}
@@ -0,0 +1,742 @@
+#include "usb_hid_autofire_host.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+
+typedef bool (*HostWaitCondition)(const FuriThread *thread, void *context);
+
+typedef enum {
+  HostThreadStateCreated,
+  HostThreadStateReady,
+  HostThreadStateWaiting,
+  HostThreadStateRunning,
+  HostThreadStateFinished,
+} HostThreadState;
+
+struct FuriThread {
+  const char *name;
+  FuriThreadCallback callback;
+  void *context;
+  FuriThreadPriority priority;
+  HostThreadState state;
+  pthread_t pthread;
+  pthread_cond_t wake;
+  HostWaitCondition condition;
+  void *condition_context;
+  bool has_wake_tick;
+  uint32_t wake_tick;
+  uint32_t flags;
+  int32_t return_code;
+  FuriThread *next;
+};
+
+struct FuriMutex {
+  FuriThread *owner;
+  uint32_t depth;
+  FuriMutexType type;
+};
+
+struct FuriTimer {
+  FuriTimerCallback callback;
+  void *context;
+  FuriTimerType type;
+  uint32_t period;
+  uint32_t expiry;
+  bool running;
+  FuriTimer *next;
+};
+
+struct FuriMessageQueue {
+  uint8_t *buffer;
+  uint32_t msg_count;
+  uint32_t msg_size;
+  uint32_t head;
+  uint32_t count;
+};
+
+struct FuriString {
+  char *data;
+};
+
+typedef struct {
+  uint32_t tick;
+  InputEvent event;
+} HostScriptedInput;
+
+static HostSimConfig host_config = {
+    .dispatch_latency_ms = 0U,
+    .dispatch_jitter_ms = 0U,
+    .seed = 1U,
+    .max_tick = 0U,
+    .log_level = FuriLogLevelWarn,
+};
+static uint32_t host_now = 0U;
+static uint32_t host_random_state = 1U;
+static FuriTimer *host_timers = NULL;
+static HostScriptedInput *host_script = NULL;
+static size_t host_script_count = 0U;
+static size_t host_script_capacity = 0U;
+static size_t host_script_next = 0U;
+static uint32_t host_input_sequence = 0U;
+
+// Only the thread holding host_lock with host_current pointing at it runs;
+// the rest sit on their own condition variable until handed the baton.
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+static FuriThread host_main_thread = {
+    .name = "main",
+    .priority = FuriThreadPriorityNormal,
+    .state = HostThreadStateRunning,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+static FuriThread *host_threads = &host_main_thread;
+static FuriThread *host_current = &host_main_thread;
+static bool host_started = false;
+static HostQueueStats host_queues = {0};
+static bool host_in_event = false;
+static bool host_stalled = false;
+
+static bool host_tick_before_or_at(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) <= 0;
+}
+
+void host_sim_configure(const HostSimConfig *config) {
+  host_config = *config;
+  host_random_state = config->seed ? config->seed : 1U;
+  host_stalled = false;
+  if (!host_started) {
+    pthread_mutex_lock(&host_lock);
+    host_started = true;
+  }
+}
+
+const HostSimConfig *host_sim_config(void) { return &host_config; }
+
+static uint32_t host_random_below(uint32_t bound) {
+  host_random_state = (host_random_state * 1103515245U) + 12345U;
+  return (bound == 0U) ? 0U : ((host_random_state >> 8) % bound);
+}
+
+void furi_log_print_format(FuriLogLevel level, const char *tag,
+                           const char *format, ...) {
+  static const char level_chars[] = {' ', 'E', 'W', 'I', 'D', 'T'};
+  if ((level == FuriLogLevelNone) || (level > host_config.log_level)) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%lu [%c][%s] ", (unsigned long)host_now, level_chars[level],
+          tag);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+// Virtual clock and event dispatch
+
+static FuriTimer *host_next_timer(void) {
+  FuriTimer *next = NULL;
+  for (FuriTimer *timer = host_timers; timer; timer = timer->next) {
+    if (timer->running &&
+        (!next || ((int32_t)(timer->expiry - next->expiry) < 0))) {
+      next = timer;
+    }
+  }
+  return next;
+}
+
+static bool host_next_event_tick(uint32_t *tick) {
+  FuriTimer *timer = host_next_timer();
+  bool has_input = host_script_next < host_script_count;
+  if (!timer && !has_input) {
+    return false;
+  }
+
+  if (timer && has_input) {
+    uint32_t input_tick = host_script[host_script_next].tick;
+    *tick = host_tick_before_or_at(timer->expiry, input_tick) ? timer->expiry
+                                                              : input_tick;
+  } else {
+    *tick = timer ? timer->expiry : host_script[host_script_next].tick;
+  }
+  return true;
+}
+
+static void host_check_max_tick(void) {
+  if ((host_config.max_tick != 0U) && (host_now > host_config.max_tick)) {
+    fprintf(stderr, "host: virtual clock passed max tick %lu\n",
+            (unsigned long)host_config.max_tick);
+    exit(2);
+  }
+}
+
+static void host_run_next_event(void) {
+  FuriTimer *timer = host_next_timer();
+  bool has_input = host_script_next < host_script_count;
+
+  if (timer && (!has_input || host_tick_before_or_at(
+                                  timer->expiry,
+                                  host_script[host_script_next].tick))) {
+    if ((int32_t)(timer->expiry - host_now) > 0) {
+      host_now = timer->expiry;
+    }
+    if (timer->type == FuriTimerTypePeriodic) {
+      timer->expiry += timer->period;
+    } else {
+      timer->running = false;
+    }
+    timer->callback(timer->context);
+  } else if (has_input) {
+    HostScriptedInput *input = &host_script[host_script_next++];
+    if ((int32_t)(input->tick - host_now) > 0) {
+      host_now = input->tick;
+    }
+    host_gui_dispatch_input(&input->event);
+  }
+
+  host_check_max_tick();
+}
+
+// Scheduler
+
+static bool host_thread_is_ready(const FuriThread *thread) {
+  switch (thread->state) {
+  case HostThreadStateReady:
+    return true;
+  case HostThreadStateWaiting:
+    return (thread->condition &&
+            thread->condition(thread, thread->condition_context)) ||
+           (thread->has_wake_tick &&
+            host_tick_before_or_at(thread->wake_tick, host_now));
+  default:
+    return false;
+  }
+}
+
+// Highest priority ready thread; ties go to the oldest thread.
+static FuriThread *host_next_ready(FuriThreadPriority above) {
+  FuriThread *next = NULL;
+  for (FuriThread *thread = host_threads; thread; thread = thread->next) {
+    if ((thread->priority > above) && host_thread_is_ready(thread) &&
+        (!next || (thread->priority > next->priority))) {
+      next = thread;
+    }
+  }
+  return next;
+}
+
+static bool host_next_wake_tick(uint32_t *tick) {
+  bool found = false;
+  for (FuriThread *thread = host_threads; thread; thread = thread->next) {
+    if ((thread->state == HostThreadStateWaiting) && thread->has_wake_tick &&
+        (!found || ((int32_t)(thread->wake_tick - *tick) < 0))) {
+      *tick = thread->wake_tick;
+      found = true;
+    }
+  }
+  return found;
+}
+
+static void host_switch_to(FuriThread *self, FuriThread *next) {
+  next->state = HostThreadStateRunning;
+  host_current = next;
+  if (next == self) {
+    return;
+  }
+
+  pthread_cond_signal(&next->wake);
+  if (self->state == HostThreadStateFinished) {
+    return;
+  }
+  while (host_current != self) {
+    pthread_cond_wait(&self->wake, &host_lock);
+  }
+}
+
+// Hands the CPU to the best ready thread, advancing the virtual clock
+// through timers, scripted input and sleep deadlines while none is ready.
+static void host_schedule(FuriThread *self) {
+  for (;;) {
+    FuriThread *next = host_next_ready(FuriThreadPriorityNone);
+    if (next) {
+      host_switch_to(self, next);
+      return;
+    }
+
+    uint32_t event_tick = 0U;
+    uint32_t wake_tick = 0U;
+    bool has_event = host_next_event_tick(&event_tick);
+    bool has_wake = host_next_wake_tick(&wake_tick);
+    if (!has_event && !has_wake) {
+      fprintf(stderr, "host: simulation stalled at tick %lu\n",
+              (unsigned long)host_now);
+      for (FuriThread *thread = host_threads; thread; thread = thread->next) {
+        fprintf(stderr, "host:   thread %s state %d\n", thread->name,
+                (int)thread->state);
+      }
+      exit(2);
+    }
+
+    // Everything due during the stall runs late, at its end.
+    uint32_t next_tick =
+        (has_wake && (!has_event || ((int32_t)(wake_tick - event_tick) < 0)))
+            ? wake_tick
+            : event_tick;
+    if ((host_config.stall_ms > 0U) && !host_stalled &&
+        host_tick_before_or_at(host_config.stall_at_tick, next_tick)) {
+      host_stalled = true;
+      uint32_t end_tick = host_config.stall_at_tick + host_config.stall_ms;
+      if ((int32_t)(end_tick - host_now) > 0) {
+        host_now = end_tick;
+      }
+      host_check_max_tick();
+      continue;
+    }
+
+    if (has_wake && (!has_event || ((int32_t)(wake_tick - event_tick) < 0))) {
+      if ((int32_t)(wake_tick - host_now) > 0) {
+        host_now = wake_tick;
+      }
+      host_check_max_tick();
+    } else {
+      host_in_event = true;
+      host_run_next_event();
+      host_in_event = false;
+    }
+  }
+}
+
+// Called after waking another thread; timer and input callbacks stand in
+// for interrupt context and never switch.
+static void host_preempt(void) {
+  FuriThread *self = host_current;
+  if (host_in_event) {
+    return;
+  }
+
+  FuriThread *next = host_next_ready(self->priority);
+  if (next) {
+    self->state = HostThreadStateReady;
+    host_switch_to(self, next);
+  }
+}
+
+// Blocks the running thread until the condition holds or the timeout
+// passes; returns whether the condition held when it resumed.
+static bool host_wait(HostWaitCondition condition, void *context,
+                      uint32_t timeout) {
+  FuriThread *self = host_current;
+  if (condition && condition(self, context)) {
+    return true;
+  }
+  if (timeout == 0U) {
+    return false;
+  }
+  if (host_in_event) {
+    fprintf(stderr, "host: blocking call from a timer or input callback\n");
+    abort();
+  }
+
+  self->state = HostThreadStateWaiting;
+  self->condition = condition;
+  self->condition_context = context;
+  self->has_wake_tick = timeout != FuriWaitForever;
+  self->wake_tick = host_now + timeout;
+  host_schedule(self);
+  self->condition = NULL;
+  self->has_wake_tick = false;
+  return condition && condition(self, context);
+}
+
+void host_sim_advance_to(uint32_t tick) {
+  if ((int32_t)(tick - host_now) > 0) {
+    host_wait(NULL, NULL, tick - host_now);
+  }
+}
+
+uint32_t furi_get_tick(void) { return host_now; }
+
+uint32_t furi_ms_to_ticks(uint32_t milliseconds) { return milliseconds; }
+
+uint32_t furi_kernel_get_tick_frequency(void) { return 1000U; }
+
+void furi_delay_ms(uint32_t milliseconds) {
+  host_wait(NULL, NULL, milliseconds);
+}
+
+// Threads
+
+static void *host_thread_entry(void *context) {
+  FuriThread *thread = context;
+  pthread_mutex_lock(&host_lock);
+  while (host_current != thread) {
+    pthread_cond_wait(&thread->wake, &host_lock);
+  }
+
+  thread->return_code = thread->callback(thread->context);
+  thread->state = HostThreadStateFinished;
+  host_schedule(thread);
+  pthread_mutex_unlock(&host_lock);
+  return NULL;
+}
+
+FuriThread *furi_thread_alloc_ex(const char *name, uint32_t stack_size,
+                                 FuriThreadCallback callback, void *context) {
+  UNUSED(stack_size);
+  FuriThread *thread = calloc(1, sizeof(FuriThread));
+  furi_check(thread);
+  thread->name = name;
+  thread->callback = callback;
+  thread->context = context;
+  thread->priority = FuriThreadPriorityNormal;
+  thread->state = HostThreadStateCreated;
+  pthread_cond_init(&thread->wake, NULL);
+
+  FuriThread **link = &host_threads;
+  while (*link) {
+    link = &(*link)->next;
+  }
+  *link = thread;
+  return thread;
+}
+
+void furi_thread_free(FuriThread *thread) {
+  furi_check((thread->state == HostThreadStateCreated) ||
+             (thread->state == HostThreadStateFinished));
+  for (FuriThread **link = &host_threads; *link; link = &(*link)->next) {
+    if (*link == thread) {
+      *link = thread->next;
+      break;
+    }
+  }
+  pthread_cond_destroy(&thread->wake);
+  free(thread);
+}
+
+void furi_thread_set_priority(FuriThread *thread,
+                              FuriThreadPriority priority) {
+  thread->priority = priority;
+}
+
+void furi_thread_start(FuriThread *thread) {
+  furi_check(host_started && (thread->state == HostThreadStateCreated));
+  thread->state = HostThreadStateReady;
+  furi_check(pthread_create(&thread->pthread, NULL, host_thread_entry,
+                            thread) == 0);
+  host_preempt();
+}
+
+static bool host_thread_finished(const FuriThread *thread, void *context) {
+  UNUSED(thread);
+  return ((FuriThread *)context)->state == HostThreadStateFinished;
+}
+
+bool furi_thread_join(FuriThread *thread) {
+  furi_check(thread != host_current);
+  host_wait(host_thread_finished, thread, FuriWaitForever);
+  pthread_join(thread->pthread, NULL);
+  return true;
+}
+
+FuriThreadId furi_thread_get_id(FuriThread *thread) { return thread; }
+
+FuriThreadId furi_thread_get_current_id(void) { return host_current; }
+
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags) {
+  thread_id->flags |= flags;
+  uint32_t result = thread_id->flags;
+  host_preempt();
+  return result;
+}
+
+typedef struct {
+  uint32_t flags;
+  uint32_t options;
+} HostFlagsWait;
+
+static bool host_flags_ready(const FuriThread *thread, void *context) {
+  const HostFlagsWait *wait = context;
+  uint32_t flags = thread->flags & wait->flags;
+  return (wait->options & FuriFlagWaitAll) ? (flags == wait->flags)
+                                           : (flags != 0U);
+}
+
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options,
+                                uint32_t timeout) {
+  HostFlagsWait wait = {.flags = flags, .options = options};
+  if (!host_wait(host_flags_ready, &wait, timeout)) {
+    return (timeout == 0U) ? FuriFlagErrorResource : FuriFlagErrorTimeout;
+  }
+
+  uint32_t result = host_current->flags;
+  if (!(options & FuriFlagNoClear)) {
+    host_current->flags &= ~flags;
+  }
+  return result;
+}
+
+// Mutexes
+
+FuriMutex *furi_mutex_alloc(FuriMutexType type) {
+  FuriMutex *mutex = calloc(1, sizeof(FuriMutex));
+  furi_check(mutex);
+  mutex->type = type;
+  return mutex;
+}
+
+void furi_mutex_free(FuriMutex *instance) {
+  furi_check(instance->owner == NULL);
+  free(instance);
+}
+
+static bool host_mutex_available(const FuriThread *thread, void *context) {
+  const FuriMutex *mutex = context;
+  return (mutex->owner == NULL) ||
+         ((mutex->type == FuriMutexTypeRecursive) && (mutex->owner == thread));
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex *instance, uint32_t timeout) {
+  furi_check(host_in_event == false);
+  furi_check((instance->type == FuriMutexTypeRecursive) ||
+             (instance->owner != host_current));
+  if (!host_wait(host_mutex_available, instance, timeout)) {
+    return (timeout == 0U) ? FuriStatusErrorResource : FuriStatusErrorTimeout;
+  }
+  instance->owner = host_current;
+  instance->depth++;
+  return FuriStatusOk;
+}
+
+FuriStatus furi_mutex_release(FuriMutex *instance) {
+  if (instance->owner != host_current) {
+    return FuriStatusErrorResource;
+  }
+  if (--instance->depth == 0U) {
+    instance->owner = NULL;
+    host_preempt();
+  }
+  return FuriStatusOk;
+}
+
+// Scripted input
+
+void host_sim_input_at(uint32_t tick, InputKey key, InputType type) {
+  if (host_script_count == host_script_capacity) {
+    host_script_capacity = host_script_capacity ? host_script_capacity * 2U
+                                                : 64U;
+    host_script = realloc(host_script,
+                          host_script_capacity * sizeof(HostScriptedInput));
+    furi_check(host_script);
+  }
+
+  // Keep the script sorted by tick, preserving insertion order on ties.
+  size_t index = host_script_count;
+  while ((index > host_script_next) &&
+         ((int32_t)(host_script[index - 1U].tick - tick) > 0)) {
+    host_script[index] = host_script[index - 1U];
+    index--;
+  }
+
+  if (type == InputTypePress) {
+    host_input_sequence++;
+  }
+  host_script[index].tick = tick;
+  host_script[index].event.sequence = host_input_sequence;
+  host_script[index].event.key = key;
+  host_script[index].event.type = type;
+  host_script_count++;
+}
+
+void host_sim_input_tap(uint32_t tick, InputKey key) {
+  host_sim_input_at(tick, key, InputTypePress);
+  host_sim_input_at(tick + HOST_INPUT_TAP_MS, key, InputTypeShort);
+  host_sim_input_at(tick + HOST_INPUT_TAP_MS, key, InputTypeRelease);
+}
+
+void host_sim_input_hold(uint32_t tick, InputKey key, uint32_t duration_ms) {
+  host_sim_input_at(tick, key, InputTypePress);
+  if (duration_ms < HOST_INPUT_LONG_MS) {
+    host_sim_input_at(tick + duration_ms, key, InputTypeShort);
+  } else {
+    host_sim_input_at(tick + HOST_INPUT_LONG_MS, key, InputTypeLong);
+    for (uint32_t at = HOST_INPUT_LONG_MS + HOST_INPUT_REPEAT_MS;
+         at < duration_ms; at += HOST_INPUT_REPEAT_MS) {
+      host_sim_input_at(tick + at, key, InputTypeRepeat);
+    }
+  }
+  host_sim_input_at(tick + duration_ms, key, InputTypeRelease);
+}
+
+// Timers
+
+FuriTimer *furi_timer_alloc(FuriTimerCallback func, FuriTimerType type,
+                            void *context) {
+  FuriTimer *timer = calloc(1, sizeof(FuriTimer));
+  furi_check(timer);
+  timer->callback = func;
+  timer->context = context;
+  timer->type = type;
+  timer->next = host_timers;
+  host_timers = timer;
+  return timer;
+}
+
+void furi_timer_free(FuriTimer *instance) {
+  for (FuriTimer **link = &host_timers; *link; link = &(*link)->next) {
+    if (*link == instance) {
+      *link = instance->next;
+      break;
+    }
+  }
+  free(instance);
+}
+
+FuriStatus furi_timer_start(FuriTimer *instance, uint32_t ticks) {
+  furi_check(ticks > 0U);
+  instance->period = ticks;
+  instance->expiry = host_now + ticks;
+  instance->running = true;
+  return FuriStatusOk;
+}
+
+FuriStatus furi_timer_stop(FuriTimer *instance) {
+  instance->running = false;
+  return FuriStatusOk;
+}
+
+uint32_t furi_timer_is_running(FuriTimer *instance) {
+  return instance->running ? 1U : 0U;
+}
+
+// Message queues
+
+FuriMessageQueue *furi_message_queue_alloc(uint32_t msg_count,
+                                           uint32_t msg_size) {
+  FuriMessageQueue *queue = calloc(1, sizeof(FuriMessageQueue));
+  furi_check(queue);
+  queue->buffer = calloc(msg_count, msg_size);
+  furi_check(queue->buffer);
+  queue->msg_count = msg_count;
+  queue->msg_size = msg_size;
+  return queue;
+}
+
+void furi_message_queue_free(FuriMessageQueue *instance) {
+  free(instance->buffer);
+  free(instance);
+}
+
+static bool host_queue_has_space(const FuriThread *thread, void *context) {
+  UNUSED(thread);
+  const FuriMessageQueue *queue = context;
+  return queue->count < queue->msg_count;
+}
+
+static bool host_queue_has_message(const FuriThread *thread,
+                                   void *context) {
+  UNUSED(thread);
+  const FuriMessageQueue *queue = context;
+  return queue->count > 0U;
+}
+
+FuriStatus furi_message_queue_put(FuriMessageQueue *instance,
+                                  const void *msg_ptr, uint32_t timeout) {
+  host_queues.puts++;
+  if (!host_wait(host_queue_has_space, instance,
+                 host_in_event ? 0U : timeout)) {
+    host_queues.put_failures++;
+    return (timeout == 0U) ? FuriStatusErrorResource : FuriStatusErrorTimeout;
+  }
+
+  uint32_t tail = (instance->head + instance->count) % instance->msg_count;
+  memcpy(&instance->buffer[tail * instance->msg_size], msg_ptr,
+         instance->msg_size);
+  instance->count++;
+  if (instance->count > host_queues.max_depth) {
+    host_queues.max_depth = instance->count;
+  }
+  host_preempt();
+  return FuriStatusOk;
+}
+
+FuriStatus furi_message_queue_get(FuriMessageQueue *instance, void *msg_ptr,
+                                  uint32_t timeout) {
+  if (!host_wait(host_queue_has_message, instance, timeout)) {
+    return (timeout == 0U) ? FuriStatusErrorResource : FuriStatusErrorTimeout;
+  }
+
+  memcpy(msg_ptr, &instance->buffer[instance->head * instance->msg_size],
+         instance->msg_size);
+  instance->head = (instance->head + 1U) % instance->msg_count;
+  instance->count--;
+
+  // Dispatch latency models the app's main loop, so only the main thread
+  // pays it; worker threads keep their own timing.
+  if (host_current == &host_main_thread) {
+    uint32_t latency_ms =
+        host_config.dispatch_latency_ms +
+        host_random_below(host_config.dispatch_jitter_ms + 1U);
+    if (latency_ms > 0U) {
+      host_wait(NULL, NULL, latency_ms);
+    }
+  }
+  host_preempt();
+  return FuriStatusOk;
+}
+
+uint32_t furi_message_queue_get_count(FuriMessageQueue *instance) {
+  return instance->count;
+}
+
+const HostQueueStats *host_queue_stats(void) { return &host_queues; }
+
+// Records
+
+typedef struct {
+  const char *name;
+  uint8_t placeholder;
+} HostRecord;
+
+static HostRecord host_records[] = {
+    {"gui", 0U},
+    {"dialogs", 0U},
+    {"storage", 0U},
+    {"bt", 0U},
+};
+
+void *furi_record_open(const char *name) {
+  for (size_t i = 0; i < (sizeof(host_records) / sizeof(host_records[0]));
+       i++) {
+    if (strcmp(host_records[i].name, name) == 0) {
+      return &host_records[i];
+    }
+  }
+  return NULL;
+}
+
+void furi_record_close(const char *name) { UNUSED(name); }
+
+// Strings
+
+FuriString *furi_string_alloc(void) {
+  FuriString *string = calloc(1, sizeof(FuriString));
+  furi_check(string);
+  string->data = strdup("");
+  return string;
+}
+
+void furi_string_free(FuriString *string) {
+  free(string->data);
+  free(string);
+}
+
+void furi_string_set_str(FuriString *string, const char *cstr) {
+  free(string->data);
+  string->data = strdup(cstr);
+  furi_check(string->data);
+}
+
+const char *furi_string_get_cstr(const FuriString *string) {
+  return string->data;
+}
@@ -0,0 +1,198 @@
+#include "usb_hid_autofire_host.h"
+
+#include <dialogs/dialogs.h>
+#include <gui/gui.h>
+#include <string.h>
+#include <time.h>
+#include <usb_hid_autofire_icons.h>
+
+struct Canvas {
+  Font font;
+};
+
+struct ViewPort {
+  ViewPortDrawCallback draw_callback;
+  void *draw_context;
+  ViewPortInputCallback input_callback;
+  void *input_context;
+  bool attached;
+};
+
+struct DialogMessage {
+  const char *header;
+  const char *text;
+};
+
+const Icon I_ButtonDown_7x4 = {.width = 7U, .height = 4U};
+const Icon I_ButtonLeft_4x7 = {.width = 4U, .height = 7U};
+const Icon I_ButtonRight_4x7 = {.width = 4U, .height = 7U};
+const Icon I_ButtonUp_7x4 = {.width = 7U, .height = 4U};
+const Icon I_Ok_btn_9x9 = {.width = 9U, .height = 9U};
+const Icon I_Pin_back_arrow_10x8 = {.width = 10U, .height = 8U};
+
+static Canvas host_canvas;
+static ViewPort *host_view_port = NULL;
+static HostGuiStats host_gui;
+static const char *host_gui_watch_text = NULL;
+static bool host_gui_watch_in_frame = false;
+static bool host_gui_watch_shown = false;
+
+const HostGuiStats *host_gui_stats(void) { return &host_gui; }
+
+void host_gui_watch(const char *text) { host_gui_watch_text = text; }
+
+Canvas *host_gui_canvas(void) { return &host_canvas; }
+
+bool host_gui_dispatch_input(const InputEvent *event) {
+  if (!host_view_port || !host_view_port->attached ||
+      !host_view_port->input_callback) {
+    return false;
+  }
+
+  InputEvent copy = *event;
+  host_view_port->input_callback(&copy, host_view_port->input_context);
+  return true;
+}
+
+void canvas_clear(Canvas *canvas) {
+  UNUSED(canvas);
+  host_gui.primitives++;
+}
+
+void canvas_set_font(Canvas *canvas, Font font) { canvas->font = font; }
+
+void canvas_draw_str(Canvas *canvas, int32_t x, int32_t y, const char *str) {
+  UNUSED(canvas);
+  UNUSED(x);
+  UNUSED(y);
+  host_gui.primitives++;
+  if (host_gui_watch_text && strstr(str, host_gui_watch_text)) {
+    host_gui_watch_in_frame = true;
+  }
+}
+
+void canvas_draw_str_aligned(Canvas *canvas, int32_t x, int32_t y,
+                             Align horizontal, Align vertical,
+                             const char *str) {
+  UNUSED(horizontal);
+  UNUSED(vertical);
+  canvas_draw_str(canvas, x, y, str);
+}
+
+void canvas_draw_icon(Canvas *canvas, int32_t x, int32_t y, const Icon *icon) {
+  UNUSED(canvas);
+  UNUSED(x);
+  UNUSED(y);
+  UNUSED(icon);
+  host_gui.primitives++;
+}
+
+ViewPort *view_port_alloc(void) {
+  ViewPort *view_port = calloc(1, sizeof(ViewPort));
+  furi_check(view_port);
+  return view_port;
+}
+
+void view_port_free(ViewPort *view_port) {
+  if (host_view_port == view_port) {
+    host_view_port = NULL;
+  }
+  free(view_port);
+}
+
+void view_port_draw_callback_set(ViewPort *view_port,
+                                 ViewPortDrawCallback callback, void *context) {
+  view_port->draw_callback = callback;
+  view_port->draw_context = context;
+}
+
+void view_port_input_callback_set(ViewPort *view_port,
+                                  ViewPortInputCallback callback,
+                                  void *context) {
+  view_port->input_callback = callback;
+  view_port->input_context = context;
+}
+
+// The GUI thread would redraw asynchronously; drawing in place keeps the
+// simulation deterministic and still exercises the render path.
+void view_port_update(ViewPort *view_port) {
+  host_gui.view_port_updates++;
+  if (!view_port->attached || !view_port->draw_callback) {
+    return;
+  }
+
+  uint32_t redraws = host_sim_config()->redraws_per_update;
+  struct timespec start;
+  struct timespec end;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+  for (uint32_t i = 0U; i < ((redraws > 0U) ? redraws : 1U); i++) {
+    host_gui.draws++;
+    host_gui_watch_in_frame = false;
+    view_port->draw_callback(&host_canvas, view_port->draw_context);
+  }
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+  if (host_gui_watch_in_frame) {
+    host_gui.watch_frames++;
+  } else if (host_gui_watch_shown && (host_gui.watch_gone_tick == 0U)) {
+    host_gui.watch_gone_tick = furi_get_tick();
+  }
+  host_gui_watch_shown = host_gui_watch_in_frame;
+  host_gui.draw_ns += ((uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL) +
+                      (uint64_t)(end.tv_nsec - start.tv_nsec);
+}
+
+void gui_add_view_port(Gui *gui, ViewPort *view_port, GuiLayer layer) {
+  UNUSED(gui);
+  UNUSED(layer);
+  view_port->attached = true;
+  host_view_port = view_port;
+}
+
+void gui_remove_view_port(Gui *gui, ViewPort *view_port) {
+  UNUSED(gui);
+  view_port->attached = false;
+}
+
+DialogMessage *dialog_message_alloc(void) {
+  DialogMessage *message = calloc(1, sizeof(DialogMessage));
+  furi_check(message);
+  return message;
+}
+
+void dialog_message_free(DialogMessage *message) { free(message); }
+
+void dialog_message_set_header(DialogMessage *message, const char *text,
+                               uint8_t x, uint8_t y, Align horizontal,
+                               Align vertical) {
+  UNUSED(x);
+  UNUSED(y);
+  UNUSED(horizontal);
+  UNUSED(vertical);
+  message->header = text;
+}
+
+void dialog_message_set_text(DialogMessage *message, const char *text,
+                             uint8_t x, uint8_t y, Align horizontal,
+                             Align vertical) {
+  UNUSED(x);
+  UNUSED(y);
+  UNUSED(horizontal);
+  UNUSED(vertical);
+  message->text = text;
+}
+
+void dialog_message_set_buttons(DialogMessage *message, const char *left,
+                                const char *center, const char *right) {
+  UNUSED(message);
+  UNUSED(left);
+  UNUSED(center);
+  UNUSED(right);
+}
+
+// Simulated runs always confirm, the same as pressing "Yes" on the device.
+DialogMessageButton dialog_message_show(DialogsApp *context,
+                                        const DialogMessage *message) {
+  UNUSED(context);
+  FURI_LOG_D("host", "dialog: %s", message->header ? message->header : "");
+  return DialogMessageButtonRight;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Host stand-in for the Bluetooth service. Starting a profile always
+// succeeds; the HID profile feeds the same report model as USB.
+
+#include <furi_hal.h>
+
+#define RECORD_BT "bt"
+
+typedef struct Bt Bt;
+
+FuriHalBleProfileBase *bt_profile_start(
+    Bt *bt, const FuriHalBleProfileTemplate *profile_template,
+    FuriHalBleProfileParams params);
+bool bt_profile_restore_default(Bt *bt);
+void bt_disconnect(Bt *bt);
+void bt_keys_storage_set_storage_path(Bt *bt, const char *keys_storage_path);
+void bt_keys_storage_set_default_path(Bt *bt);
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host stand-in for the BLE HID profile library.
+
+#include <furi_hal.h>
+
+extern const FuriHalBleProfileTemplate *ble_profile_hid;
+
+bool ble_profile_hid_kb_press(FuriHalBleProfileBase *profile, uint16_t button);
+bool ble_profile_hid_kb_release(FuriHalBleProfileBase *profile,
+                                uint16_t button);
+bool ble_profile_hid_kb_release_all(FuriHalBleProfileBase *profile);
+bool ble_profile_hid_mouse_press(FuriHalBleProfileBase *profile,
+                                 uint8_t button);
+bool ble_profile_hid_mouse_release(FuriHalBleProfileBase *profile,
+                                   uint8_t button);
@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in for FlipperFormat. Files use the same "Key: value" text
+// layout as the firmware and live in the in-memory storage.
+
+#include <storage/storage.h>
+
+typedef struct FlipperFormat FlipperFormat;
+
+FlipperFormat *flipper_format_file_alloc(Storage *storage);
+void flipper_format_free(FlipperFormat *flipper_format);
+bool flipper_format_file_open_existing(FlipperFormat *flipper_format,
+                                       const char *path);
+bool flipper_format_file_open_always(FlipperFormat *flipper_format,
+                                     const char *path);
+bool flipper_format_rewind(FlipperFormat *flipper_format);
+
+bool flipper_format_read_header(FlipperFormat *flipper_format,
+                                FuriString *filetype, uint32_t *version);
+bool flipper_format_write_header_cstr(FlipperFormat *flipper_format,
+                                      const char *filetype, uint32_t version);
+bool flipper_format_read_uint32(FlipperFormat *flipper_format, const char *key,
+                                uint32_t *data, uint16_t data_size);
+bool flipper_format_write_uint32(FlipperFormat *flipper_format,
+                                 const char *key, const uint32_t *data,
+                                 uint16_t data_size);
+bool flipper_format_read_bool(FlipperFormat *flipper_format, const char *key,
+                              bool *data, uint16_t data_size);
+bool flipper_format_write_bool(FlipperFormat *flipper_format, const char *key,
+                               const bool *data, uint16_t data_size);
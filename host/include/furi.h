@@ -0,0 +1,160 @@
+#pragma once
+
+// Host stand-in for the subset of the furi API used by the app. Time is a
+// virtual millisecond clock that only advances while every thread of the
+// app is blocked, so long firing sessions simulate in a fraction of real
+// time.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UNUSED(x) (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+
+#define furi_check(x)                                                          \
+  do {                                                                         \
+    if (!(x)) {                                                                \
+      fprintf(stderr, "furi_check failed: %s (%s:%d)\n", #x, __FILE__,         \
+              __LINE__);                                                       \
+      abort();                                                                 \
+    }                                                                          \
+  } while (0)
+#define furi_assert(x) furi_check(x)
+
+#define FuriWaitForever 0xFFFFFFFFU
+
+#define APP_DATA_PATH(path) "/ext/apps_data/usb_hid_autofire/" path
+
+typedef enum {
+  FuriStatusOk = 0,
+  FuriStatusError = -1,
+  FuriStatusErrorTimeout = -2,
+  FuriStatusErrorResource = -3,
+  FuriStatusErrorParameter = -4,
+  FuriStatusErrorNoMemory = -5,
+  FuriStatusErrorISR = -6,
+} FuriStatus;
+
+typedef enum {
+  FuriLogLevelNone,
+  FuriLogLevelError,
+  FuriLogLevelWarn,
+  FuriLogLevelInfo,
+  FuriLogLevelDebug,
+  FuriLogLevelTrace,
+} FuriLogLevel;
+
+void furi_log_print_format(FuriLogLevel level, const char *tag,
+                           const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define FURI_LOG_E(tag, ...)                                                   \
+  furi_log_print_format(FuriLogLevelError, tag, __VA_ARGS__)
+#define FURI_LOG_W(tag, ...)                                                   \
+  furi_log_print_format(FuriLogLevelWarn, tag, __VA_ARGS__)
+#define FURI_LOG_I(tag, ...)                                                   \
+  furi_log_print_format(FuriLogLevelInfo, tag, __VA_ARGS__)
+#define FURI_LOG_D(tag, ...)                                                   \
+  furi_log_print_format(FuriLogLevelDebug, tag, __VA_ARGS__)
+#define FURI_LOG_T(tag, ...)                                                   \
+  furi_log_print_format(FuriLogLevelTrace, tag, __VA_ARGS__)
+
+uint32_t furi_get_tick(void);
+uint32_t furi_ms_to_ticks(uint32_t milliseconds);
+uint32_t furi_kernel_get_tick_frequency(void);
+void furi_delay_ms(uint32_t milliseconds);
+
+typedef void (*FuriTimerCallback)(void *context);
+
+typedef enum {
+  FuriTimerTypeOnce,
+  FuriTimerTypePeriodic,
+} FuriTimerType;
+
+typedef struct FuriTimer FuriTimer;
+
+FuriTimer *furi_timer_alloc(FuriTimerCallback func, FuriTimerType type,
+                            void *context);
+void furi_timer_free(FuriTimer *instance);
+FuriStatus furi_timer_start(FuriTimer *instance, uint32_t ticks);
+FuriStatus furi_timer_stop(FuriTimer *instance);
+uint32_t furi_timer_is_running(FuriTimer *instance);
+
+typedef enum {
+  FuriFlagWaitAny = 0x00000000U,
+  FuriFlagWaitAll = 0x00000001U,
+  FuriFlagNoClear = 0x00000002U,
+  FuriFlagError = 0x80000000U,
+  FuriFlagErrorUnknown = 0xFFFFFFFFU,
+  FuriFlagErrorTimeout = 0xFFFFFFFEU,
+  FuriFlagErrorResource = 0xFFFFFFFDU,
+  FuriFlagErrorParameter = 0xFFFFFFFCU,
+  FuriFlagErrorISR = 0xFFFFFFFAU,
+} FuriFlag;
+
+typedef enum {
+  FuriThreadPriorityNone = 0,
+  FuriThreadPriorityIdle = 1,
+  FuriThreadPriorityLowest = 14,
+  FuriThreadPriorityLow = 15,
+  FuriThreadPriorityNormal = 16,
+  FuriThreadPriorityHigh = 17,
+  FuriThreadPriorityHighest = 18,
+  FuriThreadPriorityIsr = 31,
+} FuriThreadPriority;
+
+typedef int32_t (*FuriThreadCallback)(void *context);
+
+typedef struct FuriThread FuriThread;
+typedef FuriThread *FuriThreadId;
+
+// Threads are real pthreads, but only one runs at a time: a thread keeps the
+// CPU until it blocks or wakes a higher priority thread, and the virtual
+// clock advances only when every thread is blocked.
+FuriThread *furi_thread_alloc_ex(const char *name, uint32_t stack_size,
+                                 FuriThreadCallback callback, void *context);
+void furi_thread_free(FuriThread *thread);
+void furi_thread_set_priority(FuriThread *thread, FuriThreadPriority priority);
+void furi_thread_start(FuriThread *thread);
+bool furi_thread_join(FuriThread *thread);
+FuriThreadId furi_thread_get_id(FuriThread *thread);
+FuriThreadId furi_thread_get_current_id(void);
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags);
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options,
+                                uint32_t timeout);
+
+typedef enum {
+  FuriMutexTypeNormal,
+  FuriMutexTypeRecursive,
+} FuriMutexType;
+
+typedef struct FuriMutex FuriMutex;
+
+FuriMutex *furi_mutex_alloc(FuriMutexType type);
+void furi_mutex_free(FuriMutex *instance);
+FuriStatus furi_mutex_acquire(FuriMutex *instance, uint32_t timeout);
+FuriStatus furi_mutex_release(FuriMutex *instance);
+
+typedef struct FuriMessageQueue FuriMessageQueue;
+
+FuriMessageQueue *furi_message_queue_alloc(uint32_t msg_count,
+                                           uint32_t msg_size);
+void furi_message_queue_free(FuriMessageQueue *instance);
+FuriStatus furi_message_queue_put(FuriMessageQueue *instance,
+                                  const void *msg_ptr, uint32_t timeout);
+FuriStatus furi_message_queue_get(FuriMessageQueue *instance, void *msg_ptr,
+                                  uint32_t timeout);
+uint32_t furi_message_queue_get_count(FuriMessageQueue *instance);
+
+void *furi_record_open(const char *name);
+void furi_record_close(const char *name);
+
+typedef struct FuriString FuriString;
+
+FuriString *furi_string_alloc(void);
+void furi_string_free(FuriString *string);
+void furi_string_set_str(FuriString *string, const char *cstr);
+const char *furi_string_get_cstr(const FuriString *string);
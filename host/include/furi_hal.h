@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in for the furi_hal USB/HID and BLE calls used by the app.
+// Reports are not sent anywhere; they update the report state kept by the
+// simulator so it can count delivered clicks against the virtual clock.
+
+#include <furi.h>
+
+#define HID_MOUSE_BTN_LEFT (1U << 0)
+#define HID_MOUSE_BTN_RIGHT (1U << 1)
+#define HID_MOUSE_BTN_WHEEL (1U << 2)
+
+#define HID_KEYBOARD_RETURN 0x28U
+#define HID_KEYBOARD_ESCAPE 0x29U
+#define HID_KEYBOARD_DELETE 0x2AU
+#define HID_KEYBOARD_TAB 0x2BU
+#define HID_KEYBOARD_SPACEBAR 0x2CU
+
+typedef struct FuriHalUsbInterface FuriHalUsbInterface;
+
+extern FuriHalUsbInterface usb_hid;
+
+FuriHalUsbInterface *furi_hal_usb_get_config(void);
+bool furi_hal_usb_set_config(FuriHalUsbInterface *new_if, void *ctx);
+void furi_hal_usb_unlock(void);
+
+bool furi_hal_hid_mouse_press(uint8_t button);
+bool furi_hal_hid_mouse_release(uint8_t button);
+bool furi_hal_hid_kb_press(uint16_t button);
+bool furi_hal_hid_kb_release(uint16_t button);
+bool furi_hal_hid_kb_release_all(void);
+
+typedef struct FuriHalBleProfileBase FuriHalBleProfileBase;
+typedef struct FuriHalBleProfileTemplate FuriHalBleProfileTemplate;
+typedef void *FuriHalBleProfileParams;
+
+void furi_hal_bt_start_advertising(void);
+
+// The DWT cycle counter, backed by the calling thread's CPU time scaled to
+// the 64 MHz core clock, so profiled sections report host CPU time.
+typedef struct {
+  uint32_t start;
+  uint32_t value;
+} FuriHalCortexTimer;
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
+FuriHalCortexTimer furi_hal_cortex_timer_get(uint32_t timeout_us);
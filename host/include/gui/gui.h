@@ -0,0 +1,66 @@
+#pragma once
+
+// Host stand-in for the GUI service. The canvas draws nothing; it only
+// counts primitives so the simulator can report redraw cost.
+
+#include <furi.h>
+#include <input/input.h>
+
+#define RECORD_GUI "gui"
+
+typedef enum {
+  FontPrimary,
+  FontSecondary,
+  FontKeyboard,
+  FontBigNumbers,
+  FontTotalNumber,
+} Font;
+
+typedef enum {
+  AlignLeft,
+  AlignRight,
+  AlignTop,
+  AlignBottom,
+  AlignCenter,
+} Align;
+
+typedef enum {
+  GuiLayerDesktop,
+  GuiLayerWindow,
+  GuiLayerStatusBarLeft,
+  GuiLayerStatusBarRight,
+  GuiLayerFullscreen,
+  GuiLayerMAX,
+} GuiLayer;
+
+typedef struct {
+  uint8_t width;
+  uint8_t height;
+} Icon;
+
+typedef struct Canvas Canvas;
+typedef struct ViewPort ViewPort;
+typedef struct Gui Gui;
+
+typedef void (*ViewPortDrawCallback)(Canvas *canvas, void *context);
+typedef void (*ViewPortInputCallback)(InputEvent *event, void *context);
+
+void canvas_clear(Canvas *canvas);
+void canvas_set_font(Canvas *canvas, Font font);
+void canvas_draw_str(Canvas *canvas, int32_t x, int32_t y, const char *str);
+void canvas_draw_str_aligned(Canvas *canvas, int32_t x, int32_t y,
+                             Align horizontal, Align vertical,
+                             const char *str);
+void canvas_draw_icon(Canvas *canvas, int32_t x, int32_t y, const Icon *icon);
+
+ViewPort *view_port_alloc(void);
+void view_port_free(ViewPort *view_port);
+void view_port_draw_callback_set(ViewPort *view_port,
+                                 ViewPortDrawCallback callback, void *context);
+void view_port_input_callback_set(ViewPort *view_port,
+                                  ViewPortInputCallback callback,
+                                  void *context);
+void view_port_update(ViewPort *view_port);
+
+void gui_add_view_port(Gui *gui, ViewPort *view_port, GuiLayer layer);
+void gui_remove_view_port(Gui *gui, ViewPort *view_port);
@@ -0,0 +1,12 @@
+#pragma once
+
+// Host stand-in for the icon header fbt generates from assets/.
+
+#include <gui/gui.h>
+
+extern const Icon I_ButtonDown_7x4;
+extern const Icon I_ButtonLeft_4x7;
+extern const Icon I_ButtonRight_4x7;
+extern const Icon I_ButtonUp_7x4;
+extern const Icon I_Ok_btn_9x9;
+extern const Icon I_Pin_back_arrow_10x8;
@@ -0,0 +1,406 @@
+#include "usb_hid_autofire_host.h"
+
+#include <flipper_format/flipper_format.h>
+#include <inttypes.h>
+#include <storage/storage.h>
+#include <string.h>
+
+#define HOST_STORAGE_MAX_FILES 16U
+#define HOST_STORAGE_PATH_MAX 128U
+
+typedef struct {
+  bool used;
+  char path[HOST_STORAGE_PATH_MAX];
+  char *data;
+  size_t size;
+  size_t capacity;
+} HostFile;
+
+struct File {
+  HostFile *file;
+  size_t position;
+};
+
+struct FlipperFormat {
+  HostFile *file;
+  size_t position;
+};
+
+static HostFile host_files[HOST_STORAGE_MAX_FILES];
+static HostStorageStats host_storage;
+
+static HostFile *host_storage_find(const char *path) {
+  for (size_t i = 0; i < HOST_STORAGE_MAX_FILES; i++) {
+    if (host_files[i].used && (strcmp(host_files[i].path, path) == 0)) {
+      return &host_files[i];
+    }
+  }
+  return NULL;
+}
+
+static HostFile *host_storage_create(const char *path) {
+  HostFile *file = host_storage_find(path);
+  if (file) {
+    file->size = 0U;
+    return file;
+  }
+
+  for (size_t i = 0; i < HOST_STORAGE_MAX_FILES; i++) {
+    if (!host_files[i].used) {
+      file = &host_files[i];
+      file->used = true;
+      snprintf(file->path, sizeof(file->path), "%s", path);
+      file->size = 0U;
+      return file;
+    }
+  }
+  return NULL;
+}
+
+static bool host_storage_append(HostFile *file, const void *data,
+                                size_t size) {
+  if ((file->size + size) > file->capacity) {
+    size_t capacity = file->capacity ? file->capacity : 256U;
+    while (capacity < (file->size + size)) {
+      capacity *= 2U;
+    }
+    char *grown = realloc(file->data, capacity);
+    if (!grown) {
+      return false;
+    }
+    file->data = grown;
+    file->capacity = capacity;
+  }
+
+  memcpy(&file->data[file->size], data, size);
+  file->size += size;
+  return true;
+}
+
+bool host_storage_write_file(const char *path, const void *data, size_t size) {
+  HostFile *file = host_storage_create(path);
+  return file && host_storage_append(file, data, size);
+}
+
+const HostStorageStats *host_storage_stats(void) { return &host_storage; }
+
+const void *host_storage_file_data(const char *path, size_t *size) {
+  HostFile *file = host_storage_find(path);
+  if (!file) {
+    return NULL;
+  }
+  *size = file->size;
+  return file->data;
+}
+
+// Files
+
+File *storage_file_alloc(Storage *storage) {
+  UNUSED(storage);
+  File *file = calloc(1, sizeof(File));
+  furi_check(file);
+  return file;
+}
+
+void storage_file_free(File *file) { free(file); }
+
+bool storage_file_open(File *file, const char *path, FS_AccessMode access_mode,
+                       FS_OpenMode open_mode) {
+  UNUSED(access_mode);
+  HostFile *existing = host_storage_find(path);
+  file->position = 0U;
+  host_storage.opens++;
+
+  switch (open_mode) {
+  case FSOM_OPEN_EXISTING:
+    file->file = existing;
+    break;
+  case FSOM_CREATE_NEW:
+    file->file = existing ? NULL : host_storage_create(path);
+    break;
+  case FSOM_CREATE_ALWAYS:
+    file->file = host_storage_create(path);
+    break;
+  case FSOM_OPEN_APPEND:
+    file->file = existing ? existing : host_storage_create(path);
+    file->position = file->file ? file->file->size : 0U;
+    break;
+  case FSOM_OPEN_ALWAYS:
+  default:
+    file->file = existing ? existing : host_storage_create(path);
+    break;
+  }
+  return file->file != NULL;
+}
+
+bool storage_file_close(File *file) {
+  bool was_open = file->file != NULL;
+  file->file = NULL;
+  return was_open;
+}
+
+size_t storage_file_read(File *file, void *buff, size_t bytes_to_read) {
+  if (!file->file || (file->position >= file->file->size)) {
+    return 0U;
+  }
+
+  uint32_t latency_ms = host_sim_config()->storage_read_latency_ms;
+  if (latency_ms > 0U) {
+    furi_delay_ms(latency_ms);
+  }
+
+  size_t available = file->file->size - file->position;
+  size_t count = (bytes_to_read < available) ? bytes_to_read : available;
+  memcpy(buff, &file->file->data[file->position], count);
+  host_storage.reads++;
+  host_storage.read_bytes += count;
+  file->position += count;
+  return count;
+}
+
+size_t storage_file_write(File *file, const void *buff,
+                          size_t bytes_to_write) {
+  HostFile *host_file = file->file;
+  if (!host_file) {
+    return 0U;
+  }
+  host_storage.writes++;
+  host_storage.write_bytes += bytes_to_write;
+  uint32_t latency_ms = host_sim_config()->storage_write_latency_ms;
+  if (latency_ms > 0U) {
+    furi_delay_ms(latency_ms);
+  }
+
+  // Overwrite in place, then grow the file with whatever is left.
+  size_t overlap = 0U;
+  if (file->position < host_file->size) {
+    size_t available = host_file->size - file->position;
+    overlap = (bytes_to_write < available) ? bytes_to_write : available;
+    memcpy(&host_file->data[file->position], buff, overlap);
+  }
+  if ((overlap < bytes_to_write) &&
+      !host_storage_append(host_file, (const uint8_t *)buff + overlap,
+                           bytes_to_write - overlap)) {
+    file->position += overlap;
+    return overlap;
+  }
+
+  file->position += bytes_to_write;
+  return bytes_to_write;
+}
+
+bool storage_file_seek(File *file, uint32_t offset, bool from_start) {
+  if (!file->file) {
+    return false;
+  }
+
+  size_t position = from_start ? offset : (file->position + offset);
+  if (position > file->file->size) {
+    position = file->file->size;
+  }
+  file->position = position;
+  return true;
+}
+
+uint64_t storage_file_size(File *file) {
+  return file->file ? file->file->size : 0U;
+}
+
+FS_Error storage_common_remove(Storage *storage, const char *path) {
+  UNUSED(storage);
+  HostFile *file = host_storage_find(path);
+  if (!file) {
+    return FSE_NOT_EXIST;
+  }
+
+  free(file->data);
+  memset(file, 0, sizeof(HostFile));
+  host_storage.removes++;
+  return FSE_OK;
+}
+
+// Like the device, rename does not replace an existing file.
+FS_Error storage_common_rename(Storage *storage, const char *old_path,
+                               const char *new_path) {
+  UNUSED(storage);
+  HostFile *file = host_storage_find(old_path);
+  if (!file) {
+    return FSE_NOT_EXIST;
+  }
+  if (host_storage_find(new_path)) {
+    return FSE_EXIST;
+  }
+
+  snprintf(file->path, sizeof(file->path), "%s", new_path);
+  host_storage.renames++;
+  return FSE_OK;
+}
+
+// FlipperFormat
+
+FlipperFormat *flipper_format_file_alloc(Storage *storage) {
+  UNUSED(storage);
+  FlipperFormat *flipper_format = calloc(1, sizeof(FlipperFormat));
+  furi_check(flipper_format);
+  return flipper_format;
+}
+
+void flipper_format_free(FlipperFormat *flipper_format) {
+  free(flipper_format);
+}
+
+bool flipper_format_file_open_existing(FlipperFormat *flipper_format,
+                                       const char *path) {
+  flipper_format->file = host_storage_find(path);
+  flipper_format->position = 0U;
+  host_storage.opens++;
+  return flipper_format->file != NULL;
+}
+
+bool flipper_format_file_open_always(FlipperFormat *flipper_format,
+                                     const char *path) {
+  flipper_format->file = host_storage_create(path);
+  flipper_format->position = 0U;
+  host_storage.opens++;
+  return flipper_format->file != NULL;
+}
+
+bool flipper_format_rewind(FlipperFormat *flipper_format) {
+  flipper_format->position = 0U;
+  return flipper_format->file != NULL;
+}
+
+// Scans forward from the current position for "key: " the way the firmware
+// does in non-strict mode; a miss leaves the position at the end of file.
+static bool host_flipper_format_seek_value(FlipperFormat *flipper_format,
+                                           const char *key, char *value,
+                                           size_t value_size) {
+  HostFile *file = flipper_format->file;
+  size_t key_length = strlen(key);
+  if (!file) {
+    return false;
+  }
+
+  host_storage.reads++;
+  while (flipper_format->position < file->size) {
+    const char *line = &file->data[flipper_format->position];
+    size_t remaining = file->size - flipper_format->position;
+    const char *end = memchr(line, '\n', remaining);
+    size_t line_length = end ? (size_t)(end - line) : remaining;
+    flipper_format->position += line_length + (end ? 1U : 0U);
+    host_storage.read_bytes += line_length + (end ? 1U : 0U);
+
+    if ((line_length > (key_length + 1U)) &&
+        (strncmp(line, key, key_length) == 0) && (line[key_length] == ':')) {
+      const char *start = &line[key_length + 1U];
+      size_t length = line_length - key_length - 1U;
+      while ((length > 0U) && (*start == ' ')) {
+        start++;
+        length--;
+      }
+      if (length >= value_size) {
+        return false;
+      }
+      memcpy(value, start, length);
+      value[length] = '\0';
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool host_flipper_format_write_line(FlipperFormat *flipper_format,
+                                           const char *key,
+                                           const char *value) {
+  char line[HOST_STORAGE_PATH_MAX];
+  int length = snprintf(line, sizeof(line), "%s: %s\n", key, value);
+  if (!flipper_format->file || (length < 0) ||
+      ((size_t)length >= sizeof(line))) {
+    return false;
+  }
+  host_storage.writes++;
+  host_storage.write_bytes += (uint32_t)length;
+  return host_storage_append(flipper_format->file, line, (size_t)length);
+}
+
+bool flipper_format_read_header(FlipperFormat *flipper_format,
+                                FuriString *filetype, uint32_t *version) {
+  char value[HOST_STORAGE_PATH_MAX];
+  if (!host_flipper_format_seek_value(flipper_format, "Filetype", value,
+                                      sizeof(value))) {
+    return false;
+  }
+  furi_string_set_str(filetype, value);
+  return flipper_format_read_uint32(flipper_format, "Version", version, 1U);
+}
+
+bool flipper_format_write_header_cstr(FlipperFormat *flipper_format,
+                                      const char *filetype, uint32_t version) {
+  return host_flipper_format_write_line(flipper_format, "Filetype",
+                                        filetype) &&
+         flipper_format_write_uint32(flipper_format, "Version", &version, 1U);
+}
+
+bool flipper_format_read_uint32(FlipperFormat *flipper_format, const char *key,
+                                uint32_t *data, uint16_t data_size) {
+  char value[HOST_STORAGE_PATH_MAX];
+  if (!host_flipper_format_seek_value(flipper_format, key, value,
+                                      sizeof(value))) {
+    return false;
+  }
+
+  char *cursor = value;
+  for (uint16_t i = 0; i < data_size; i++) {
+    char *end = NULL;
+    unsigned long parsed = strtoul(cursor, &end, 10);
+    if (end == cursor) {
+      return false;
+    }
+    data[i] = (uint32_t)parsed;
+    cursor = end;
+  }
+  return true;
+}
+
+bool flipper_format_write_uint32(FlipperFormat *flipper_format,
+                                 const char *key, const uint32_t *data,
+                                 uint16_t data_size) {
+  char value[HOST_STORAGE_PATH_MAX] = "";
+  size_t length = 0U;
+  for (uint16_t i = 0; i < data_size; i++) {
+    length += (size_t)snprintf(&value[length], sizeof(value) - length,
+                               "%s%" PRIu32, (i == 0U) ? "" : " ", data[i]);
+    if (length >= sizeof(value)) {
+      return false;
+    }
+  }
+  return host_flipper_format_write_line(flipper_format, key, value);
+}
+
+bool flipper_format_read_bool(FlipperFormat *flipper_format, const char *key,
+                              bool *data, uint16_t data_size) {
+  char value[HOST_STORAGE_PATH_MAX];
+  if ((data_size != 1U) ||
+      !host_flipper_format_seek_value(flipper_format, key, value,
+                                      sizeof(value))) {
+    return false;
+  }
+
+  if (strcmp(value, "true") == 0) {
+    *data = true;
+  } else if (strcmp(value, "false") == 0) {
+    *data = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool flipper_format_write_bool(FlipperFormat *flipper_format, const char *key,
+                               const bool *data, uint16_t data_size) {
+  if (data_size != 1U) {
+    return false;
+  }
+  return host_flipper_format_write_line(flipper_format, key,
+                                        *data ? "true" : "false");
+}
@@ -0,0 +1,474 @@
+// Times the app's hot paths in isolation against the host stand-in layer:
+// input handling on canned bursts, the click tick at the highest rate, the
+// draw callback on a null canvas and settings load and save on the
+// in-memory storage. Each result is the median of several rounds, printed
+// as one `bench=NAME ops=N ns_per_op=X` line; --baseline compares against a
+// saved run and fails on a regression.
+
+#include "usb_hid_autofire_host.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../usb_hid_autofire_i.h"
+
+#define BENCH_ROUNDS_DEFAULT 11U
+#define BENCH_ROUNDS_MAX 101U
+#define BENCH_THRESHOLD_DEFAULT_PERCENT 25U
+// A slowdown also has to be this many ns per operation to count; a few ns
+// on an input event is scheduler and cache noise on a shared host.
+#define BENCH_NOISE_DEFAULT_NS 5U
+#define BENCH_NAME_SIZE 32U
+#define BENCH_MAX_RESULTS 32U
+// Operations per round at scale 1, sized so a round takes 10 ms or more of
+// CPU time and a timer tick or a migration is a small part of it.
+#define BENCH_INPUT_OPS 1000000U
+#define BENCH_TICK_OPS 1000000U
+#define BENCH_RENDER_OPS 50000U
+#define BENCH_SETTINGS_OPS 20000U
+#define BENCH_SAVE_OPS 5000U
+
+typedef struct {
+  InputKey key;
+  InputType type;
+} BenchInput;
+
+typedef struct {
+  const char *name;
+  const BenchInput *events;
+  size_t count;
+} BenchBurst;
+
+typedef enum {
+  BenchKindInput,
+  BenchKindTick,
+  BenchKindRender,
+  BenchKindViewUpdate,
+  BenchKindSettingsSave,
+  BenchKindSettingsLoad,
+} BenchKind;
+
+typedef struct {
+  char name[BENCH_NAME_SIZE];
+  BenchKind kind;
+  // Burst or screen, for the kinds that take one.
+  uint32_t arg;
+  uint32_t ops;
+  double rounds[BENCH_ROUNDS_MAX];
+  double ns_per_op;
+} BenchResult;
+
+typedef struct {
+  uint32_t rounds;
+  uint32_t scale;
+  uint32_t threshold_percent;
+  uint32_t noise_ns;
+  const char *baseline_path;
+  BenchResult results[BENCH_MAX_RESULTS];
+  uint32_t result_count;
+} BenchState;
+
+#define BENCH_TAP(key)                                                         \
+  {(key), InputTypePress}, {(key), InputTypeShort}, {(key), InputTypeRelease}
+#define BENCH_REPEAT4(key)                                                     \
+  {(key), InputTypeRepeat}, {(key), InputTypeRepeat},                          \
+      {(key), InputTypeRepeat}, {(key), InputTypeRepeat}
+
+// Holding Right and then Left through the accelerated delay steps.
+static const BenchInput bench_delay_hold[] = {
+    {InputKeyRight, InputTypePress},  {InputKeyRight, InputTypeLong},
+    BENCH_REPEAT4(InputKeyRight),     BENCH_REPEAT4(InputKeyRight),
+    BENCH_REPEAT4(InputKeyRight),     BENCH_REPEAT4(InputKeyRight),
+    {InputKeyRight, InputTypeRelease}, {InputKeyLeft, InputTypePress},
+    {InputKeyLeft, InputTypeLong},    BENCH_REPEAT4(InputKeyLeft),
+    BENCH_REPEAT4(InputKeyLeft),      BENCH_REPEAT4(InputKeyLeft),
+    BENCH_REPEAT4(InputKeyLeft),      {InputKeyLeft, InputTypeRelease},
+};
+
+static const BenchInput bench_mode_taps[] = {
+    BENCH_TAP(InputKeyUp),   BENCH_TAP(InputKeyUp),   BENCH_TAP(InputKeyUp),
+    BENCH_TAP(InputKeyDown), BENCH_TAP(InputKeyDown), BENCH_TAP(InputKeyDown),
+};
+
+static const BenchInput bench_toggle[] = {
+    BENCH_TAP(InputKeyOk),
+    BENCH_TAP(InputKeyOk),
+};
+
+// Back held to the help screen, through every page and back to the main
+// screen.
+static const BenchInput bench_pages[] = {
+    {InputKeyBack, InputTypePress}, {InputKeyBack, InputTypeLong},
+    {InputKeyBack, InputTypeRelease}, BENCH_TAP(InputKeyRight),
+    BENCH_TAP(InputKeyRight),       BENCH_TAP(InputKeyRight),
+    BENCH_TAP(InputKeyRight),       BENCH_TAP(InputKeyRight),
+    {InputKeyBack, InputTypePress}, {InputKeyBack, InputTypeShort},
+    {InputKeyBack, InputTypeRelease},
+};
+
+static const BenchBurst bench_bursts[] = {
+    {"input_delay_hold", bench_delay_hold, COUNT_OF(bench_delay_hold)},
+    {"input_mode_taps", bench_mode_taps, COUNT_OF(bench_mode_taps)},
+    {"input_toggle", bench_toggle, COUNT_OF(bench_toggle)},
+    {"input_pages", bench_pages, COUNT_OF(bench_pages)},
+};
+
+static const char *const bench_screen_names[] = {
+    [AutofireScreenMain] = "main",       [AutofireScreenHelp] = "help",
+    [AutofireScreenStats] = "stats",     [AutofireScreenOptions] = "options",
+    [AutofireScreenBench] = "bench",     [AutofireScreenChannels] = "channels",
+    [AutofireScreenProfile] = "profile",
+};
+
+static void bench_usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -r, --rounds N        rounds per benchmark, the median counts "
+          "(default %u, at most %u)\n"
+          "  -s, --scale N         multiply the operations per round "
+          "(default 1)\n"
+          "  -b, --baseline FILE   compare against the output of an earlier "
+          "run\n"
+          "  -t, --threshold PCT   slowdown that fails the comparison "
+          "(default %u)\n"
+          "  -n, --noise NS        slowdown per operation below which it "
+          "never fails (default %u)\n"
+          "  -h, --help            show this help\n",
+          argv0, BENCH_ROUNDS_DEFAULT, BENCH_ROUNDS_MAX,
+          BENCH_THRESHOLD_DEFAULT_PERCENT, BENCH_NOISE_DEFAULT_NS);
+}
+
+static bool bench_parse_u32(const char *text, uint32_t *value) {
+  char *end = NULL;
+  unsigned long parsed = strtoul(text, &end, 10);
+  if ((end == text) || (*end != '\0')) {
+    return false;
+  }
+  *value = (uint32_t)parsed;
+  return true;
+}
+
+// Host CPU time of the calling thread, the clock the profile build uses.
+static uint64_t bench_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static int bench_compare_double(const void *a, const void *b) {
+  double left = *(const double *)a;
+  double right = *(const double *)b;
+  return (left > right) - (left < right);
+}
+
+// The middle round; unlike the best one it does not move with a single
+// lucky or unlucky round.
+static double bench_median(double *rounds, uint32_t count) {
+  qsort(rounds, count, sizeof(rounds[0]), bench_compare_double);
+  return ((count % 2U) != 0U)
+             ? rounds[count / 2U]
+             : (rounds[(count / 2U) - 1U] + rounds[count / 2U]) / 2.0;
+}
+
+static void bench_add(BenchState *state, const char *name, BenchKind kind,
+                      uint32_t arg, uint32_t ops) {
+  furi_check(state->result_count < BENCH_MAX_RESULTS);
+  BenchResult *result = &state->results[state->result_count++];
+  snprintf(result->name, sizeof(result->name), "%s", name);
+  result->kind = kind;
+  result->arg = arg;
+  result->ops = ops;
+}
+
+static double bench_input(UsbHidAutofireApp *app, const BenchBurst *burst,
+                          uint32_t ops) {
+  uint32_t repeats = ops / (uint32_t)burst->count;
+  uint64_t start = bench_now_ns();
+  for (uint32_t repeat = 0U; repeat < repeats; repeat++) {
+    for (size_t i = 0U; i < burst->count; i++) {
+      InputEvent event = {
+          .sequence = repeat,
+          .key = burst->events[i].key,
+          .type = burst->events[i].type,
+      };
+      bool should_exit = false;
+      usb_hid_autofire_handle_input_event(app, &event, &should_exit);
+    }
+  }
+  double ns_per_op = (double)(bench_now_ns() - start) / (double)ops;
+  // Leave the next benchmark on a stopped main screen.
+  usb_hid_autofire_stop(app);
+  app->screen = AutofireScreenMain;
+  return ns_per_op;
+}
+
+// Press and release at the shortest delay; the batch is dropped, so only
+// the engine's own work is timed. The engine is put back afterwards: the
+// clicks it counted would otherwise show on the stats pages the input
+// benchmarks format.
+static double bench_tick(UsbHidAutofireApp *app, uint32_t ops) {
+  static AutofireEngine saved;
+  static AutofireClickTrace saved_trace;
+  saved = app->engine;
+  saved_trace = *app->engine.trace;
+  app->autofire_delay_ms = AUTOFIRE_DELAY_MIN_MS;
+  usb_hid_autofire_engine_init(app);
+  app->engine.active = true;
+  app->engine.click_phase = ClickPhasePress;
+  app->engine.next_press_at = furi_get_tick();
+
+  AutofireHidBatch batch = {.count = 0U};
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0U; i < ops; i++) {
+    batch.count = 0U;
+    usb_hid_autofire_tick(app, &batch);
+  }
+  double ns_per_op = (double)(bench_now_ns() - start) / (double)ops;
+  app->autofire_delay_ms = AUTOFIRE_DELAY_DEFAULT_MS;
+  app->engine = saved;
+  *app->engine.trace = saved_trace;
+  return ns_per_op;
+}
+
+static double bench_render(UsbHidAutofireApp *app, AutofireScreen screen,
+                           uint32_t ops) {
+  Canvas *canvas = host_gui_canvas();
+  app->screen = screen;
+  usb_hid_autofire_view_update(app);
+
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0U; i < ops; i++) {
+    usb_hid_autofire_render_callback(canvas, app);
+  }
+  double ns_per_op = (double)(bench_now_ns() - start) / (double)ops;
+  app->screen = AutofireScreenMain;
+  return ns_per_op;
+}
+
+// Formatting every field of the main screen, what a redraw costs after a
+// change.
+static double bench_view_update(UsbHidAutofireApp *app, uint32_t ops) {
+  app->screen = AutofireScreenMain;
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0U; i < ops; i++) {
+    usb_hid_autofire_view_invalidate(app, AutofireViewAll);
+    usb_hid_autofire_view_update(app);
+  }
+  return (double)(bench_now_ns() - start) / (double)ops;
+}
+
+// Saves go through the writer thread the app uses; its profile entry has
+// the write time on the writer's own CPU clock. Every save changes the
+// delay so the writer never skips one as unchanged.
+static double bench_settings_save(UsbHidAutofireApp *app, uint32_t ops) {
+  AutofireProfileStat *stat = &app->profile[AutofireProfileSave];
+  memset(stat, 0, sizeof(*stat));
+  for (uint32_t i = 0U; i < ops; i++) {
+    app->autofire_delay_ms = AUTOFIRE_DELAY_DEFAULT_MS + (i & 1U);
+    app->settings_dirty = true;
+    usb_hid_autofire_settings_flush_if_dirty(app);
+    furi_delay_ms(1U);
+  }
+  app->autofire_delay_ms = AUTOFIRE_DELAY_DEFAULT_MS;
+  return ((double)stat->sum * 1000.0) /
+         ((double)stat->count *
+          (double)furi_hal_cortex_instructions_per_microsecond());
+}
+
+static double bench_settings_load(UsbHidAutofireApp *app, uint32_t ops) {
+  uint64_t start = bench_now_ns();
+  for (uint32_t i = 0U; i < ops; i++) {
+    usb_hid_autofire_settings_load(app);
+  }
+  return (double)(bench_now_ns() - start) / (double)ops;
+}
+
+static double bench_round(UsbHidAutofireApp *app, const BenchResult *result) {
+  switch (result->kind) {
+  case BenchKindInput:
+    return bench_input(app, &bench_bursts[result->arg], result->ops);
+  case BenchKindTick:
+    return bench_tick(app, result->ops);
+  case BenchKindRender:
+    return bench_render(app, (AutofireScreen)result->arg, result->ops);
+  case BenchKindViewUpdate:
+    return bench_view_update(app, result->ops);
+  case BenchKindSettingsSave:
+    return bench_settings_save(app, result->ops);
+  case BenchKindSettingsLoad:
+    return bench_settings_load(app, result->ops);
+  default:
+    return 0.0;
+  }
+}
+
+// One round of every benchmark per pass, so a slow spell of the host lands
+// on a round of each instead of on every round of one.
+static void bench_run(BenchState *state, UsbHidAutofireApp *app) {
+  for (uint32_t round = 0U; round < state->rounds; round++) {
+    for (uint32_t i = 0U; i < state->result_count; i++) {
+      BenchResult *result = &state->results[i];
+      result->rounds[round] = bench_round(app, result);
+    }
+  }
+  for (uint32_t i = 0U; i < state->result_count; i++) {
+    BenchResult *result = &state->results[i];
+    result->ns_per_op = bench_median(result->rounds, state->rounds);
+    printf("bench=%s ops=%" PRIu32 " ns_per_op=%.1f\n", result->name,
+           result->ops, result->ns_per_op);
+  }
+}
+
+// Fails on any benchmark more than the threshold and the noise floor slower
+// than the baseline; ones missing from either run are skipped.
+static bool bench_check_baseline(const BenchState *state) {
+  FILE *file = fopen(state->baseline_path, "r");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", state->baseline_path);
+    return false;
+  }
+
+  bool ok = true;
+  uint32_t compared = 0U;
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    char name[BENCH_NAME_SIZE];
+    uint32_t ops;
+    double baseline_ns;
+    if (sscanf(line, "bench=%31s ops=%" SCNu32 " ns_per_op=%lf", name, &ops,
+               &baseline_ns) != 3) {
+      continue;
+    }
+    for (uint32_t i = 0U; i < state->result_count; i++) {
+      const BenchResult *result = &state->results[i];
+      if (strcmp(result->name, name) != 0) {
+        continue;
+      }
+      double limit =
+          baseline_ns * (1.0 + ((double)state->threshold_percent / 100.0));
+      double change = ((result->ns_per_op / baseline_ns) - 1.0) * 100.0;
+      bool slower =
+          (result->ns_per_op > limit) &&
+          ((result->ns_per_op - baseline_ns) > (double)state->noise_ns);
+      printf("compare=%s baseline_ns=%.1f ns_per_op=%.1f change_pct=%+.1f%s\n",
+             name, baseline_ns, result->ns_per_op, change,
+             slower ? " REGRESSION" : "");
+      ok = ok && !slower;
+      compared++;
+    }
+  }
+  fclose(file);
+
+  printf("baseline_compared=%" PRIu32 " threshold_pct=%" PRIu32
+         " noise_ns=%" PRIu32 " result=%s\n",
+         compared, state->threshold_percent, state->noise_ns,
+         ok ? "pass" : "fail");
+  return ok && (compared > 0U);
+}
+
+int main(int argc, char **argv) {
+  BenchState state = {
+      .rounds = BENCH_ROUNDS_DEFAULT,
+      .scale = 1U,
+      .threshold_percent = BENCH_THRESHOLD_DEFAULT_PERCENT,
+      .noise_ns = BENCH_NOISE_DEFAULT_NS,
+  };
+
+  const struct option long_options[] = {
+      {"rounds", required_argument, NULL, 'r'},
+      {"scale", required_argument, NULL, 's'},
+      {"baseline", required_argument, NULL, 'b'},
+      {"threshold", required_argument, NULL, 't'},
+      {"noise", required_argument, NULL, 'n'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "r:s:b:t:n:h", long_options, NULL)) !=
+         -1) {
+    bool ok = true;
+    switch (opt) {
+    case 'r':
+      ok = bench_parse_u32(optarg, &state.rounds) && (state.rounds > 0U) &&
+           (state.rounds <= BENCH_ROUNDS_MAX);
+      break;
+    case 's':
+      ok = bench_parse_u32(optarg, &state.scale) && (state.scale > 0U);
+      break;
+    case 'b':
+      state.baseline_path = optarg;
+      break;
+    case 't':
+      ok = bench_parse_u32(optarg, &state.threshold_percent);
+      break;
+    case 'n':
+      ok = bench_parse_u32(optarg, &state.noise_ns);
+      break;
+    default:
+      ok = false;
+      break;
+    }
+    if (!ok) {
+      bench_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  HostSimConfig config = {
+      .seed = 1U,
+      .log_level = FuriLogLevelNone,
+  };
+  host_sim_configure(&config);
+
+  // The app as its entry point sets it up, minus the click worker: start
+  // and stop only change the app side, which is what input handling costs
+  // on the main loop.
+  static UsbHidAutofireApp app;
+  usb_hid_autofire_app_defaults(&app);
+  usb_hid_autofire_settings_load(&app);
+  usb_hid_autofire_transport_init(&app.transport, AutofireTransportLoopback);
+  usb_hid_autofire_engine_init(&app);
+  static AutofireClickTrace trace;
+  app.engine.trace = &trace;
+  app.view.mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+  app.engine_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+  if (!usb_hid_autofire_settings_writer_start(&app)) {
+    fprintf(stderr, "cannot start the settings writer\n");
+    return 1;
+  }
+
+  for (uint32_t i = 0U; i < COUNT_OF(bench_bursts); i++) {
+    const BenchBurst *burst = &bench_bursts[i];
+    uint32_t repeats = (BENCH_INPUT_OPS * state.scale) / burst->count;
+    bench_add(&state, burst->name, BenchKindInput, i,
+              repeats * (uint32_t)burst->count);
+  }
+  bench_add(&state, "tick", BenchKindTick, 0U, BENCH_TICK_OPS * state.scale);
+  for (uint32_t screen = AutofireScreenMain; screen <= AUTOFIRE_SCREEN_LAST;
+       screen++) {
+    char name[BENCH_NAME_SIZE];
+    snprintf(name, sizeof(name), "render_%s", bench_screen_names[screen]);
+    bench_add(&state, name, BenchKindRender, screen,
+              BENCH_RENDER_OPS * state.scale);
+  }
+  bench_add(&state, "view_update_main", BenchKindViewUpdate, 0U,
+            BENCH_RENDER_OPS * state.scale);
+  bench_add(&state, "settings_save", BenchKindSettingsSave, 0U,
+            BENCH_SAVE_OPS * state.scale);
+  bench_add(&state, "settings_load", BenchKindSettingsLoad, 0U,
+            BENCH_SETTINGS_OPS * state.scale);
+  bench_run(&state, &app);
+
+  usb_hid_autofire_settings_writer_stop(&app);
+  furi_mutex_free(app.engine_mutex);
+  furi_mutex_free(app.view.mutex);
+
+  if (state.baseline_path && !bench_check_baseline(&state)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+// Decodes report capture files copied off the SD card (capture.old.bin,
+// then capture.bin) and prints per-target interval histograms and a
+// lateness histogram of the scheduled HID changes.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../usb_hid_autofire_i.h"
+
+#define DECODE_TARGET_SLOTS 16U
+// Values below this get a bin each, larger ones one bin per power of two.
+#define DECODE_LINEAR_BINS 64U
+#define DECODE_BINS (DECODE_LINEAR_BINS + 32U)
+#define DECODE_BAR_WIDTH 40U
+
+typedef struct {
+  uint32_t counts[DECODE_BINS];
+  uint32_t samples;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} DecodeHistogram;
+
+typedef struct {
+  uint8_t channel;
+  uint8_t mouse;
+  uint16_t code;
+  uint32_t presses;
+  uint32_t last_press_tick;
+  DecodeHistogram intervals;
+} DecodeTarget;
+
+typedef struct {
+  uint32_t records;
+  uint32_t dropped;
+  uint32_t first_tick;
+  uint32_t last_tick;
+  bool has_sequence;
+  uint16_t next_sequence;
+  DecodeTarget targets[DECODE_TARGET_SLOTS];
+  uint32_t target_count;
+  DecodeHistogram lateness;
+} DecodeState;
+
+static uint32_t decode_bin(uint32_t value) {
+  if (value < DECODE_LINEAR_BINS) {
+    return value;
+  }
+  uint32_t bin = DECODE_LINEAR_BINS;
+  for (uint32_t limit = DECODE_LINEAR_BINS * 2U;
+       (value >= limit) && (bin < (DECODE_BINS - 1U)); limit *= 2U) {
+    bin++;
+  }
+  return bin;
+}
+
+static void decode_histogram_add(DecodeHistogram *histogram, uint32_t value) {
+  if ((histogram->samples == 0U) || (value < histogram->min)) {
+    histogram->min = value;
+  }
+  if (value > histogram->max) {
+    histogram->max = value;
+  }
+  histogram->counts[decode_bin(value)]++;
+  histogram->sum += value;
+  histogram->samples++;
+}
+
+static void decode_histogram_print(const DecodeHistogram *histogram) {
+  if (histogram->samples == 0U) {
+    printf("    (none)\n");
+    return;
+  }
+  printf("    n=%" PRIu32 " min=%" PRIu32 " mean=%.3f max=%" PRIu32 "\n",
+         histogram->samples, histogram->min,
+         (double)histogram->sum / (double)histogram->samples, histogram->max);
+
+  uint32_t peak = 0U;
+  for (uint32_t bin = 0U; bin < DECODE_BINS; bin++) {
+    peak = (histogram->counts[bin] > peak) ? histogram->counts[bin] : peak;
+  }
+  for (uint32_t bin = 0U; bin < DECODE_BINS; bin++) {
+    uint32_t count = histogram->counts[bin];
+    if (count == 0U) {
+      continue;
+    }
+    char label[24];
+    if (bin < DECODE_LINEAR_BINS) {
+      snprintf(label, sizeof(label), "%" PRIu32, bin);
+    } else {
+      uint64_t low = (uint64_t)DECODE_LINEAR_BINS
+                     << (bin - DECODE_LINEAR_BINS);
+      snprintf(label, sizeof(label), "%" PRIu64 "-%" PRIu64, low,
+               (low * 2U) - 1U);
+    }
+    uint32_t width =
+        (uint32_t)(((uint64_t)count * DECODE_BAR_WIDTH + peak - 1U) / peak);
+    printf("    %12s ms %10" PRIu32 " ", label, count);
+    for (uint32_t i = 0U; i < width; i++) {
+      putchar('#');
+    }
+    putchar('\n');
+  }
+}
+
+static DecodeTarget *decode_target(DecodeState *state,
+                                   const AutofireCaptureRecord *record) {
+  uint8_t mouse = (record->flags & AutofireCaptureFlagMouse) ? 1U : 0U;
+  for (uint32_t i = 0U; i < state->target_count; i++) {
+    DecodeTarget *target = &state->targets[i];
+    if ((target->channel == record->channel) && (target->mouse == mouse) &&
+        (target->code == record->code)) {
+      return target;
+    }
+  }
+  if (state->target_count == DECODE_TARGET_SLOTS) {
+    return NULL;
+  }
+  DecodeTarget *target = &state->targets[state->target_count++];
+  target->channel = record->channel;
+  target->mouse = mouse;
+  target->code = record->code;
+  return target;
+}
+
+static void decode_record(DecodeState *state,
+                          const AutofireCaptureRecord *record) {
+  if (state->has_sequence) {
+    state->dropped += (uint16_t)(record->sequence - state->next_sequence);
+  }
+  state->has_sequence = true;
+  state->next_sequence = record->sequence + 1U;
+  if (state->records == 0U) {
+    state->first_tick = record->tick;
+  }
+  state->last_tick = record->tick;
+  state->records++;
+  decode_histogram_add(&state->lateness, record->late_ms);
+
+  if ((record->flags & AutofireCaptureFlagPress) == 0U) {
+    return;
+  }
+  DecodeTarget *target = decode_target(state, record);
+  if (!target) {
+    return;
+  }
+  if (target->presses > 0U) {
+    decode_histogram_add(&target->intervals,
+                         record->tick - target->last_press_tick);
+  }
+  target->last_press_tick = record->tick;
+  target->presses++;
+}
+
+static bool decode_file(DecodeState *state, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+
+  AutofireCaptureHeader header;
+  bool ok = (fread(&header, sizeof(header), 1U, file) == 1U) &&
+            (header.magic == USB_HID_AUTOFIRE_CAPTURE_MAGIC) &&
+            (header.version == USB_HID_AUTOFIRE_CAPTURE_VERSION) &&
+            (header.record_size == sizeof(AutofireCaptureRecord));
+  if (!ok) {
+    fprintf(stderr, "%s is not a version %u capture file\n", path,
+            USB_HID_AUTOFIRE_CAPTURE_VERSION);
+  }
+
+  AutofireCaptureRecord record;
+  while (ok && (fread(&record, sizeof(record), 1U, file) == 1U)) {
+    decode_record(state, &record);
+  }
+  fclose(file);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s [capture.old.bin] capture.bin\n", argv[0]);
+    return 1;
+  }
+
+  DecodeState *state = calloc(1U, sizeof(DecodeState));
+  for (int i = 1; i < argc; i++) {
+    if (!decode_file(state, argv[i])) {
+      free(state);
+      return 1;
+    }
+  }
+
+  printf("records=%" PRIu32 " dropped=%" PRIu32 " span_ms=%" PRIu32 "\n",
+         state->records, state->dropped, state->last_tick - state->first_tick);
+  for (uint32_t i = 0U; i < state->target_count; i++) {
+    const DecodeTarget *target = &state->targets[i];
+    printf("channel %u %s 0x%02" PRIX16 " presses=%" PRIu32
+           ", press-to-press interval:\n",
+           target->channel, target->mouse ? "mouse" : "key", target->code,
+           target->presses);
+    decode_histogram_print(&target->intervals);
+  }
+  printf("lateness past deadline:\n");
+  decode_histogram_print(&state->lateness);
+
+  free(state);
+  return 0;
+}
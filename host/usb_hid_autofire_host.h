@@ -0,0 +1,123 @@
+#pragma once
+
+// Simulator-side API of the host stand-in layer. The app only sees the
+// regular furi headers in include/; the simulator driver uses these calls to
+// script input, inject latency and read back what the app sent.
+
+#include <furi.h>
+#include <gui/gui.h>
+#include <input/input.h>
+
+#define HOST_INPUT_TAP_MS 50U
+#define HOST_INPUT_LONG_MS 300U
+#define HOST_INPUT_REPEAT_MS 150U
+#define HOST_HID_USAGE_SLOTS 8U
+
+typedef struct {
+  // Extra virtual time between a queued event and the app receiving it,
+  // standing in for queue wait and processing cost on the device.
+  uint32_t dispatch_latency_ms;
+  // Uniform random extra latency in [0, dispatch_jitter_ms].
+  uint32_t dispatch_jitter_ms;
+  uint32_t seed;
+  // Abort the run if the virtual clock passes this tick (0 disables).
+  uint32_t max_tick;
+  // Host interrupt-endpoint poll clock; 0 disables the poll model.
+  uint32_t poll_interval_ms;
+  uint32_t poll_phase_ms;
+  // Virtual time each storage write blocks its caller, standing in for SD
+  // card latency.
+  uint32_t storage_write_latency_ms;
+  uint32_t storage_read_latency_ms;
+  // Draws per view_port_update, standing in for redraws the GUI does for
+  // other reasons; 0 counts as 1.
+  uint32_t redraws_per_update;
+  // Once the clock reaches stall_at_tick nothing runs for stall_ms, standing
+  // in for the CPU being held elsewhere; 0 ms disables.
+  uint32_t stall_at_tick;
+  uint32_t stall_ms;
+  FuriLogLevel log_level;
+} HostSimConfig;
+
+// Presses of one mouse button or key, counted per usage so channels and
+// sequence steps firing at the same time can be told apart.
+typedef struct {
+  bool mouse;
+  uint16_t code;
+  uint32_t presses;
+  uint32_t first_press_tick;
+  uint32_t last_press_tick;
+  uint32_t interval_min_ms;
+  uint32_t interval_max_ms;
+} HostHidUsage;
+
+typedef struct {
+  uint32_t reports;
+  uint32_t press_edges;
+  uint32_t release_edges;
+  uint32_t first_press_tick;
+  uint32_t last_press_tick;
+  uint32_t interval_min_ms;
+  uint32_t interval_max_ms;
+  uint64_t interval_sum_ms;
+  uint32_t hold_min_ms;
+  uint32_t hold_max_ms;
+  uint64_t hold_sum_ms;
+  // Press edges as seen by the polling host.
+  uint32_t polls;
+  uint32_t polled_press_edges;
+  HostHidUsage usages[HOST_HID_USAGE_SLOTS];
+  uint32_t usage_count;
+} HostHidStats;
+
+typedef struct {
+  uint32_t puts;
+  uint32_t put_failures;
+  uint32_t max_depth;
+} HostQueueStats;
+
+// Storage work done by the app; FlipperFormat key lookups count as reads
+// of every byte they scan.
+typedef struct {
+  uint32_t opens;
+  uint32_t reads;
+  uint32_t read_bytes;
+  uint32_t writes;
+  uint32_t write_bytes;
+  uint32_t removes;
+  uint32_t renames;
+} HostStorageStats;
+
+typedef struct {
+  uint32_t view_port_updates;
+  uint32_t draws;
+  uint32_t primitives;
+  // Host CPU time spent in the draw callback.
+  uint64_t draw_ns;
+  // Frames showing the text given to host_gui_watch, and the tick of the
+  // first frame that no longer did.
+  uint32_t watch_frames;
+  uint32_t watch_gone_tick;
+} HostGuiStats;
+
+void host_sim_configure(const HostSimConfig *config);
+void host_sim_advance_to(uint32_t tick);
+
+void host_sim_input_at(uint32_t tick, InputKey key, InputType type);
+void host_sim_input_tap(uint32_t tick, InputKey key);
+void host_sim_input_hold(uint32_t tick, InputKey key, uint32_t duration_ms);
+
+const HostQueueStats *host_queue_stats(void);
+const HostHidStats *host_hid_stats(void);
+const HostGuiStats *host_gui_stats(void);
+void host_gui_watch(const char *text);
+// The canvas view port updates draw on; every primitive is a no-op.
+Canvas *host_gui_canvas(void);
+const HostStorageStats *host_storage_stats(void);
+
+bool host_storage_write_file(const char *path, const void *data, size_t size);
+const void *host_storage_file_data(const char *path, size_t *size);
+
+// Internal hooks between the stand-in modules.
+const HostSimConfig *host_sim_config(void);
+bool host_gui_dispatch_input(const InputEvent *event);
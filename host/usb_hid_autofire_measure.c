@@ -0,0 +1,508 @@
+// Measures what a Linux host actually receives from the autofire device:
+// reads key presses from an evdev node and reports the delivered click rate,
+// the interval jitter and the clicks lost or merged against the configured
+// delay. --synthetic replays a generated stream through a uinput device to
+// check the tool itself, --replay reads events captured earlier with
+// `cat /dev/input/eventN > FILE`.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../usb_hid_autofire_i.h"
+
+#define MEASURE_DEVICE_NAME_DEFAULT "Flipper"
+#define MEASURE_SYNTHETIC_NAME "USB HID Autofire synthetic"
+#define MEASURE_IDLE_DEFAULT_MS 2000U
+// udev may take a moment to create the event node of a new uinput device.
+#define MEASURE_NODE_WAIT_MS 2000U
+#define MEASURE_NODE_POLL_MS 10U
+#define MEASURE_SYNTHETIC_LEAD_MS 100U
+
+typedef struct {
+  const char *device_path;
+  const char *device_name;
+  const char *replay_path;
+  uint32_t delay_ms;
+  uint32_t code;
+  uint32_t count;
+  uint32_t idle_ms;
+  bool grab;
+  bool synthetic;
+  uint32_t synthetic_count;
+  uint32_t synthetic_delay_ms;
+  uint32_t synthetic_jitter_ms;
+  uint32_t synthetic_drop_every;
+} MeasureOptions;
+
+typedef struct {
+  int fd;
+  const MeasureOptions *options;
+  uint32_t emitted;
+} MeasureSynthetic;
+
+typedef struct {
+  uint64_t *press_us;
+  uint32_t presses;
+  uint32_t capacity;
+  uint32_t releases;
+  // Releases stamped in the same report as their press: the host merged a
+  // whole click into one poll.
+  uint32_t same_frame;
+  uint64_t last_press_us;
+  bool held;
+} MeasureStats;
+
+static void measure_usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -D, --device PATH     evdev node to read (default: the first "
+          "device\n"
+          "                        whose name contains --name)\n"
+          "  -N, --name TEXT       device name to look for (default %s)\n"
+          "  -d, --delay MS        configured autofire_delay_ms (default %u)\n"
+          "  -c, --code CODE       key or button code to count (default "
+          "BTN_LEFT)\n"
+          "  -n, --count N         stop after N presses (default: when idle)\n"
+          "  -i, --idle MS         stop after MS without events (default %u)\n"
+          "  -g, --grab            keep the clicks from reaching the desktop\n"
+          "  -s, --synthetic N:MS[:JITTER[:DROP]]\n"
+          "                        replay N clicks MS apart through uinput, "
+          "+-JITTER ms,\n"
+          "                        leaving out every DROP-th click\n"
+          "  -r, --replay FILE     read raw input_event records from FILE\n"
+          "  -h, --help            show this help\n",
+          argv0, MEASURE_DEVICE_NAME_DEFAULT, AUTOFIRE_DELAY_DEFAULT_MS,
+          MEASURE_IDLE_DEFAULT_MS);
+}
+
+static bool measure_parse_u32(const char *text, uint32_t *value) {
+  char *end = NULL;
+  unsigned long parsed = strtoul(text, &end, 0);
+  if ((end == text) || (*end != '\0')) {
+    return false;
+  }
+  *value = (uint32_t)parsed;
+  return true;
+}
+
+// Parses N:MS[:JITTER[:DROP]].
+static bool measure_parse_synthetic(const char *text,
+                                    MeasureOptions *options) {
+  char copy[64];
+  snprintf(copy, sizeof(copy), "%s", text);
+  char *count = strtok(copy, ":");
+  char *delay = strtok(NULL, ":");
+  char *jitter = strtok(NULL, ":");
+  char *drop = strtok(NULL, ":");
+  options->synthetic = true;
+  return count && delay &&
+         measure_parse_u32(count, &options->synthetic_count) &&
+         measure_parse_u32(delay, &options->synthetic_delay_ms) &&
+         (options->synthetic_delay_ms > 0U) &&
+         (!jitter ||
+          measure_parse_u32(jitter, &options->synthetic_jitter_ms)) &&
+         (!drop || measure_parse_u32(drop, &options->synthetic_drop_every));
+}
+
+static uint64_t measure_event_us(const struct input_event *event) {
+  return ((uint64_t)event->input_event_sec * 1000000ULL) +
+         (uint64_t)event->input_event_usec;
+}
+
+static void measure_add_event(MeasureStats *stats,
+                              const struct input_event *event,
+                              uint32_t code) {
+  if ((event->type != EV_KEY) || (event->code != code)) {
+    return;
+  }
+  uint64_t now_us = measure_event_us(event);
+  if (event->value == 1) {
+    if (stats->presses == stats->capacity) {
+      uint32_t capacity = stats->capacity ? (stats->capacity * 2U) : 1024U;
+      uint64_t *press_us =
+          realloc(stats->press_us, capacity * sizeof(*press_us));
+      if (!press_us) {
+        return;
+      }
+      stats->press_us = press_us;
+      stats->capacity = capacity;
+    }
+    stats->press_us[stats->presses++] = now_us;
+    stats->last_press_us = now_us;
+    stats->held = true;
+  } else if ((event->value == 0) && stats->held) {
+    stats->releases++;
+    stats->same_frame += (now_us == stats->last_press_us) ? 1U : 0U;
+    stats->held = false;
+  }
+}
+
+static int measure_compare_double(const void *a, const void *b) {
+  double left = *(const double *)a;
+  double right = *(const double *)b;
+  return (left > right) - (left < right);
+}
+
+static void measure_report(const MeasureStats *stats,
+                           const MeasureOptions *options) {
+  printf("presses=%" PRIu32 " releases=%" PRIu32 " same_frame=%" PRIu32 "\n",
+         stats->presses, stats->releases, stats->same_frame);
+  if (stats->presses < 2U) {
+    printf("not enough presses to measure intervals\n");
+    return;
+  }
+
+  uint32_t intervals = stats->presses - 1U;
+  double delay_ms = (double)options->delay_ms;
+  double span_ms =
+      (double)(stats->press_us[intervals] - stats->press_us[0]) / 1000.0;
+  double *deviation = malloc(intervals * sizeof(*deviation));
+  double min = 0.0;
+  double max = 0.0;
+  double sum = 0.0;
+  double sum_squares = 0.0;
+  uint32_t lost = 0U;
+  uint32_t merged = 0U;
+
+  for (uint32_t i = 0U; i < intervals; i++) {
+    double interval =
+        (double)(stats->press_us[i + 1U] - stats->press_us[i]) / 1000.0;
+    min = ((i == 0U) || (interval < min)) ? interval : min;
+    max = ((i == 0U) || (interval > max)) ? interval : max;
+    sum += interval;
+    sum_squares += interval * interval;
+    if (deviation) {
+      deviation[i] = fabs(interval - delay_ms);
+    }
+    // A gap of several periods hides clicks the host never saw; a gap under
+    // half a period means two clicks arrived bunched up.
+    double periods = interval / delay_ms;
+    if (periods >= 1.5) {
+      lost += (uint32_t)lround(periods) - 1U;
+    } else if (periods < 0.5) {
+      merged++;
+    }
+  }
+
+  double mean = sum / (double)intervals;
+  double variance = (sum_squares / (double)intervals) - (mean * mean);
+  double stddev = (variance > 0.0) ? sqrt(variance) : 0.0;
+  double p99 = 0.0;
+  if (deviation) {
+    qsort(deviation, intervals, sizeof(*deviation), measure_compare_double);
+    p99 = deviation[(uint32_t)(((uint64_t)intervals * 99U) / 100U)];
+    free(deviation);
+  }
+
+  printf("span_ms=%.3f delivered_cps=%.2f expected_cps=%.2f\n", span_ms,
+         ((double)intervals * 1000.0) / span_ms, 1000.0 / delay_ms);
+  printf("interval_ms min=%.3f mean=%.3f max=%.3f jitter_ms=%.3f "
+         "p99_deviation_ms=%.3f\n",
+         min, mean, max, stddev, p99);
+  printf("lost_clicks=%" PRIu32 " merged_clicks=%" PRIu32 "\n", lost, merged);
+}
+
+static bool measure_node_has_name(const char *path, const char *name,
+                                  bool exact) {
+  int fd = open(path, O_RDONLY | O_NONBLOCK);
+  if (fd < 0) {
+    return false;
+  }
+  char device_name[256] = {0};
+  bool match = ioctl(fd, EVIOCGNAME(sizeof(device_name) - 1U),
+                     device_name) >= 0;
+  close(fd);
+  return match && (exact ? (strcmp(device_name, name) == 0)
+                         : (strstr(device_name, name) != NULL));
+}
+
+// Picks the lowest numbered event node whose device name matches.
+static bool measure_find_device(const char *name, bool exact, char *path,
+                                size_t path_size) {
+  DIR *dir = opendir("/dev/input");
+  if (!dir) {
+    return false;
+  }
+  long best = -1;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strncmp(entry->d_name, "event", 5U) != 0) {
+      continue;
+    }
+    long number = strtol(entry->d_name + 5, NULL, 10);
+    char candidate[300];
+    snprintf(candidate, sizeof(candidate), "/dev/input/%s", entry->d_name);
+    if (((best < 0) || (number < best)) &&
+        measure_node_has_name(candidate, name, exact)) {
+      best = number;
+      snprintf(path, path_size, "%s", candidate);
+    }
+  }
+  closedir(dir);
+  return best >= 0;
+}
+
+static bool measure_emit(int fd, uint16_t type, uint16_t code,
+                         int32_t value) {
+  struct input_event event = {.type = type, .code = code, .value = value};
+  return write(fd, &event, sizeof(event)) == (ssize_t)sizeof(event);
+}
+
+static void measure_sleep_until(struct timespec *deadline, uint32_t ms) {
+  deadline->tv_nsec += (long)ms * 1000000L;
+  while (deadline->tv_nsec >= 1000000000L) {
+    deadline->tv_nsec -= 1000000000L;
+    deadline->tv_sec++;
+  }
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) ==
+         EINTR) {
+  }
+}
+
+// Plays the clicks on absolute deadlines so the jitter does not accumulate.
+static void *measure_synthetic_run(void *ctx) {
+  MeasureSynthetic *synthetic = ctx;
+  const MeasureOptions *options = synthetic->options;
+  uint16_t code = (uint16_t)options->code;
+  unsigned int seed = 1U;
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  measure_sleep_until(&deadline, MEASURE_SYNTHETIC_LEAD_MS);
+
+  for (uint32_t i = 0U; i < options->synthetic_count; i++) {
+    struct timespec at = deadline;
+    uint32_t offset = 0U;
+    if (options->synthetic_jitter_ms > 0U) {
+      offset = (uint32_t)rand_r(&seed) % (options->synthetic_jitter_ms + 1U);
+    }
+    measure_sleep_until(&at, offset);
+    bool dropped = (options->synthetic_drop_every > 0U) &&
+                   (((i + 1U) % options->synthetic_drop_every) == 0U);
+    if (!dropped) {
+      measure_emit(synthetic->fd, EV_KEY, code, 1);
+      measure_emit(synthetic->fd, EV_SYN, SYN_REPORT, 0);
+      measure_emit(synthetic->fd, EV_KEY, code, 0);
+      measure_emit(synthetic->fd, EV_SYN, SYN_REPORT, 0);
+      synthetic->emitted++;
+    }
+    measure_sleep_until(&deadline, options->synthetic_delay_ms);
+  }
+  return NULL;
+}
+
+static int measure_synthetic_open(const MeasureOptions *options) {
+  int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+  if (fd < 0) {
+    fprintf(stderr, "cannot open /dev/uinput: %s\n", strerror(errno));
+    return -1;
+  }
+  struct uinput_setup setup = {
+      .id = {.bustype = BUS_VIRTUAL, .vendor = 0x0483U, .product = 0x5740U},
+  };
+  snprintf(setup.name, sizeof(setup.name), "%s", MEASURE_SYNTHETIC_NAME);
+  if ((ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0) ||
+      (ioctl(fd, UI_SET_KEYBIT, options->code) < 0) ||
+      (ioctl(fd, UI_DEV_SETUP, &setup) < 0) ||
+      (ioctl(fd, UI_DEV_CREATE) < 0)) {
+    fprintf(stderr, "cannot create the uinput device: %s\n",
+            strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int measure_open_input(const MeasureOptions *options) {
+  char path[300];
+  if (options->device_path) {
+    snprintf(path, sizeof(path), "%s", options->device_path);
+  } else {
+    const char *name = options->synthetic ? MEASURE_SYNTHETIC_NAME
+                                          : options->device_name;
+    bool found = false;
+    for (uint32_t waited = 0U;
+         !found && (waited <= MEASURE_NODE_WAIT_MS);
+         waited += MEASURE_NODE_POLL_MS) {
+      found = measure_find_device(name, options->synthetic, path,
+                                  sizeof(path));
+      if (!found && options->synthetic) {
+        usleep(MEASURE_NODE_POLL_MS * 1000U);
+      } else if (!found) {
+        break;
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "no input device named \"%s\"\n", name);
+      return -1;
+    }
+  }
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  // Stamp events with the monotonic clock the synthetic stream is paced on.
+  int clock = CLOCK_MONOTONIC;
+  ioctl(fd, EVIOCSCLOCKID, &clock);
+  if (options->grab && (ioctl(fd, EVIOCGRAB, 1) < 0)) {
+    fprintf(stderr, "cannot grab %s: %s\n", path, strerror(errno));
+  }
+  fprintf(stderr, "reading %s\n", path);
+  return fd;
+}
+
+static void measure_read(int fd, bool is_device, MeasureStats *stats,
+                         const MeasureOptions *options) {
+  struct input_event events[64];
+  while ((options->count == 0U) || (stats->presses < options->count)) {
+    if (is_device) {
+      // Before the first press, wait as long as it takes.
+      struct pollfd poll_fd = {.fd = fd, .events = POLLIN};
+      int timeout = (stats->presses > 0U) ? (int)options->idle_ms : -1;
+      if (poll(&poll_fd, 1U, timeout) <= 0) {
+        break;
+      }
+    }
+    ssize_t length = read(fd, events, sizeof(events));
+    if (length < (ssize_t)sizeof(events[0])) {
+      break;
+    }
+    size_t count = (size_t)length / sizeof(events[0]);
+    for (size_t i = 0U; i < count; i++) {
+      measure_add_event(stats, &events[i], options->code);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  MeasureOptions options = {
+      .device_name = MEASURE_DEVICE_NAME_DEFAULT,
+      .delay_ms = AUTOFIRE_DELAY_DEFAULT_MS,
+      .code = BTN_LEFT,
+      .idle_ms = MEASURE_IDLE_DEFAULT_MS,
+  };
+
+  const struct option long_options[] = {
+      {"device", required_argument, NULL, 'D'},
+      {"name", required_argument, NULL, 'N'},
+      {"delay", required_argument, NULL, 'd'},
+      {"code", required_argument, NULL, 'c'},
+      {"count", required_argument, NULL, 'n'},
+      {"idle", required_argument, NULL, 'i'},
+      {"grab", no_argument, NULL, 'g'},
+      {"synthetic", required_argument, NULL, 's'},
+      {"replay", required_argument, NULL, 'r'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "D:N:d:c:n:i:gs:r:h", long_options,
+                            NULL)) != -1) {
+    bool ok = true;
+    switch (opt) {
+    case 'D':
+      options.device_path = optarg;
+      break;
+    case 'N':
+      options.device_name = optarg;
+      break;
+    case 'd':
+      ok = measure_parse_u32(optarg, &options.delay_ms) &&
+           (options.delay_ms > 0U);
+      break;
+    case 'c':
+      ok = measure_parse_u32(optarg, &options.code) &&
+           (options.code <= KEY_MAX);
+      break;
+    case 'n':
+      ok = measure_parse_u32(optarg, &options.count);
+      break;
+    case 'i':
+      ok = measure_parse_u32(optarg, &options.idle_ms);
+      break;
+    case 'g':
+      options.grab = true;
+      break;
+    case 's':
+      ok = measure_parse_synthetic(optarg, &options);
+      break;
+    case 'r':
+      options.replay_path = optarg;
+      break;
+    default:
+      ok = false;
+      break;
+    }
+    if (!ok) {
+      measure_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  MeasureStats stats = {0};
+  if (options.replay_path) {
+    int fd = open(options.replay_path, O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "cannot open %s: %s\n", options.replay_path,
+              strerror(errno));
+      return 1;
+    }
+    measure_read(fd, false, &stats, &options);
+    close(fd);
+    measure_report(&stats, &options);
+    free(stats.press_us);
+    return 0;
+  }
+
+  MeasureSynthetic synthetic = {.fd = -1, .options = &options};
+  pthread_t thread;
+  if (options.synthetic) {
+    synthetic.fd = measure_synthetic_open(&options);
+    if (synthetic.fd < 0) {
+      return 1;
+    }
+  }
+
+  int fd = measure_open_input(&options);
+  if (fd < 0) {
+    if (synthetic.fd >= 0) {
+      ioctl(synthetic.fd, UI_DEV_DESTROY);
+      close(synthetic.fd);
+    }
+    return 1;
+  }
+
+  if (options.synthetic) {
+    pthread_create(&thread, NULL, measure_synthetic_run, &synthetic);
+  }
+  measure_read(fd, true, &stats, &options);
+  close(fd);
+  if (options.synthetic) {
+    pthread_join(thread, NULL);
+    ioctl(synthetic.fd, UI_DEV_DESTROY);
+    close(synthetic.fd);
+    printf("synthetic_clicks=%" PRIu32 " synthetic_left_out=%" PRIu32 "\n",
+           synthetic.emitted, options.synthetic_count - synthetic.emitted);
+  }
+
+  measure_report(&stats, &options);
+  free(stats.press_us);
+  return 0;
+}
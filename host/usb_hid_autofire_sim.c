@@ -0,0 +1,936 @@
+// Runs the unmodified app entry point against the host stand-in layer: the
+// settings file is seeded in memory, OK starts autofire, and after the
+// requested virtual duration OK stops it and Back exits the app.
+
+#include "usb_hid_autofire_host.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "../usb_hid_autofire_i.h"
+
+#define SIM_START_TICK 100U
+// Reads at launch besides the sequence text: settings and the first chunks.
+#define SIM_LAUNCH_READS 8U
+#define SIM_EXIT_GAP_MS 200U
+#define SIM_MASH_LEAD_MS 1000U
+// Matches the bInterval of the firmware's HID interrupt endpoint.
+#define SIM_POLL_DEFAULT_MS 2U
+
+int32_t usb_hid_autofire_app(void *p);
+
+// An input log as the app writes it, read from a local file or back from
+// the simulated SD card.
+typedef struct {
+  uint8_t *data;
+  AutofireInputLogHeader header;
+  const uint8_t *settings;
+  const uint8_t *records;
+  uint32_t count;
+} SimInputLog;
+
+typedef struct {
+  uint32_t delay_ms;
+  uint32_t duration_ms;
+  uint32_t mode;
+  uint32_t key_code;
+  uint32_t key_modifiers;
+  uint32_t late_policy;
+  uint32_t duty_percent;
+  uint32_t frame_align_ms;
+  uint32_t target_cps_x10;
+  uint32_t mash_ms;
+  uint32_t burst_count;
+  uint32_t burst_interval_ms;
+  AutofireChannelConfig channels[AUTOFIRE_EXTRA_CHANNEL_COUNT];
+  uint32_t channel_count;
+  const char *sequence_path;
+  size_t sequence_size;
+  uint32_t start_tick;
+  uint32_t stall_at_ms;
+  uint32_t stall_ms;
+  bool legacy_settings;
+  bool export_trace;
+  bool hold_to_fire;
+  uint32_t transport;
+  const char *capture_path;
+  const char *record_input_path;
+  const char *replay_path;
+  SimInputLog replay;
+} SimOptions;
+
+static void sim_usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -d, --delay MS        autofire delay (default %u)\n"
+          "  -t, --duration MS     virtual firing time (default 60000)\n"
+          "  -m, --mode N          fire target index (default 0)\n"
+          "  -k, --key-code N      HID usage for the custom key target "
+          "(default %u)\n"
+          "  -K, --modifiers MASK  1 Ctrl, 2 Shift, 4 Alt, 8 GUI (default "
+          "0)\n"
+          "  -p, --late-policy N   0 catch up, 1 skip, 2 slide (default 0)\n"
+          "  -u, --duty PCT        press-hold share of the cycle (default "
+          "%u)\n"
+          "  -f, --frame-align MS  align clicks to an assumed poll interval "
+          "(default 0)\n"
+          "  -c, --target-cps X10  closed-loop target rate in 0.1 CPS, 0 "
+          "uses\n"
+          "                        the delay (default 0)\n"
+          "  -o, --poll MS         host poll interval, 0 disables (default "
+          "%u)\n"
+          "  -O, --poll-phase MS   host poll offset (default 0)\n"
+          "  -l, --latency MS      event dispatch latency (default 0)\n"
+          "  -j, --jitter MS       random extra dispatch latency (default 0)\n"
+          "  -r, --redraws N       draws per view port update, to benchmark "
+          "the\n"
+          "                        draw callback (default 1)\n"
+          "  -w, --storage-latency MS  time each storage write takes "
+          "(default 0)\n"
+          "  -R, --read-latency MS time each storage read takes (default "
+          "0)\n"
+          "  -Z, --stall AT:MS     stop everything for MS, AT ms after the "
+          "OK press,\n"
+          "                        to make the click worker late\n"
+          "  -C, --channel M:D[:U] enable an extra channel firing target "
+          "M\n"
+          "                        every D ms at U%% duty; repeat for up "
+          "to %u\n"
+          "  -S, --sequence FILE   install FILE as the sequence program and "
+          "run\n"
+          "                        it instead of the click\n"
+          "  -B, --burst N[:MS]    fire bursts of N clicks, MS apart; "
+          "without\n"
+          "                        MS one burst that stops on its own\n"
+          "  -H, --hold            hold OK to fire instead of toggling "
+          "it\n"
+          "  -T, --transport NAME  usb, ble or loopback (default usb)\n"
+          "  -x, --capture FILE    capture reports and copy the capture to "
+          "FILE\n"
+          "                        (and FILE.old after a rollover)\n"
+          "  -i, --record-input FILE  log the input events and copy the "
+          "log to FILE\n"
+          "  -I, --replay-input FILE  replay an input log from the device "
+          "instead\n"
+          "                        of the scripted run, with the settings "
+          "it holds\n"
+          "  -s, --seed N          jitter seed (default 1)\n"
+          "  -b, --mash MS         page the info screens with Left/Right "
+          "taps\n"
+          "                        every MS while firing (default off)\n"
+          "  -L, --legacy-settings seed the old text settings file to run "
+          "the\n"
+          "                        migration\n"
+          "  -e, --export-trace    export the click trace from the stats "
+          "screen\n"
+          "  -v, --verbose         print app log output\n",
+          argv0, AUTOFIRE_DELAY_DEFAULT_MS, AUTOFIRE_KEY_CODE_DEFAULT,
+          AUTOFIRE_DUTY_DEFAULT_PERCENT, SIM_POLL_DEFAULT_MS,
+          AUTOFIRE_EXTRA_CHANNEL_COUNT);
+}
+
+static bool sim_parse_u32(const char *text, uint32_t *value) {
+  char *end = NULL;
+  unsigned long parsed = strtoul(text, &end, 10);
+  if ((end == text) || (*end != '\0')) {
+    return false;
+  }
+  *value = (uint32_t)parsed;
+  return true;
+}
+
+// Parses MODE:DELAY[:DUTY] into the next free extra channel.
+static bool sim_parse_channel(const char *text, SimOptions *options) {
+  if (options->channel_count >= AUTOFIRE_EXTRA_CHANNEL_COUNT) {
+    return false;
+  }
+
+  char copy[64];
+  snprintf(copy, sizeof(copy), "%s", text);
+  AutofireChannelConfig *channel = &options->channels[options->channel_count];
+  char *mode = strtok(copy, ":");
+  char *delay = strtok(NULL, ":");
+  char *duty = strtok(NULL, ":");
+  if (!mode || !delay || !sim_parse_u32(mode, &channel->mode) ||
+      !sim_parse_u32(delay, &channel->delay_ms) ||
+      (duty && !sim_parse_u32(duty, &channel->duty_percent))) {
+    return false;
+  }
+  channel->enabled = 1U;
+  if (!usb_hid_autofire_channel_is_valid(channel)) {
+    return false;
+  }
+  options->channel_count++;
+  return true;
+}
+
+// Parses AT:MS.
+static bool sim_parse_stall(const char *text, SimOptions *options) {
+  char copy[32];
+  snprintf(copy, sizeof(copy), "%s", text);
+  char *at = strtok(copy, ":");
+  char *duration = strtok(NULL, ":");
+  return at && duration && sim_parse_u32(at, &options->stall_at_ms) &&
+         sim_parse_u32(duration, &options->stall_ms) &&
+         (options->stall_ms > 0U);
+}
+
+// Parses COUNT[:INTERVAL].
+static bool sim_parse_burst(const char *text, SimOptions *options) {
+  char copy[32];
+  snprintf(copy, sizeof(copy), "%s", text);
+  char *count = strtok(copy, ":");
+  char *interval = strtok(NULL, ":");
+  return count && sim_parse_u32(count, &options->burst_count) &&
+         (options->burst_count > 0U) &&
+         usb_hid_autofire_burst_count_is_valid(options->burst_count) &&
+         (!interval ||
+          (sim_parse_u32(interval, &options->burst_interval_ms) &&
+           usb_hid_autofire_burst_interval_is_valid(
+               options->burst_interval_ms)));
+}
+
+static bool sim_parse_transport(const char *text, uint32_t *transport) {
+  for (uint32_t i = 0U; i < AutofireTransportCount; i++) {
+    if (strcasecmp(text, usb_hid_autofire_transport_label(i)) == 0) {
+      *transport = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Copies a local sequence file to where the app loads it from.
+static bool sim_install_sequence(const char *path, size_t *installed) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *text = malloc((size > 0) ? (size_t)size : 1U);
+  size_t read = fread(text, 1U, (size > 0) ? (size_t)size : 0U, file);
+  fclose(file);
+  bool ok = host_storage_write_file(USB_HID_AUTOFIRE_SEQUENCE_PATH, text, read);
+  free(text);
+  *installed = read;
+  return ok;
+}
+
+static void sim_seed_settings(const SimOptions *options) {
+  if (!options->legacy_settings) {
+    AutofireSettingsRecord record = {
+        .settings =
+            {
+                .delay_ms = options->delay_ms,
+                .mode = options->mode,
+                .preset = AutofirePresetCustom,
+                .startup_policy = AutofireStartupPolicyPausedOnLaunch,
+                .late_policy = options->late_policy,
+                .duty_percent = options->duty_percent,
+                .frame_align_ms = options->frame_align_ms,
+                .target_cps_x10 = options->target_cps_x10,
+                .key_code = options->key_code,
+                .key_modifiers = options->key_modifiers,
+            },
+    };
+    memcpy(record.settings.channels, options->channels,
+           sizeof(record.settings.channels));
+    record.settings.sequence_enabled = (options->sequence_path != NULL);
+    record.settings.burst_count = options->burst_count;
+    record.settings.burst_interval_ms = options->burst_interval_ms;
+    record.settings.hold_to_fire = options->hold_to_fire;
+    record.settings.transport = options->transport;
+    if (options->replay_path) {
+      size_t size = options->replay.header.settings_size;
+      memcpy(&record.settings, options->replay.settings,
+             (size < sizeof(record.settings)) ? size
+                                              : sizeof(record.settings));
+    }
+    record.settings.capture = (options->capture_path != NULL);
+    // A replay logs again, to check that it saw the same input.
+    record.settings.input_log =
+        (options->record_input_path != NULL) || (options->replay_path != NULL);
+    usb_hid_autofire_settings_seal(&record);
+    host_storage_write_file(USB_HID_AUTOFIRE_SETTINGS_PATH, &record,
+                            sizeof(record));
+    return;
+  }
+
+  char text[384];
+  int length = snprintf(text, sizeof(text),
+                        "Filetype: %s\n"
+                        "Version: %u\n"
+                        "delay_ms: %" PRIu32 "\n"
+                        "mode: %" PRIu32 "\n"
+                        "preset: 0\n"
+                        "startup_policy: 0\n"
+                        "last_active: false\n"
+                        "late_policy: %" PRIu32 "\n"
+                        "duty_percent: %" PRIu32 "\n"
+                        "frame_align_ms: %" PRIu32 "\n"
+                        "target_cps_x10: %" PRIu32 "\n"
+                        "key_code: %" PRIu32 "\n"
+                        "key_modifiers: %" PRIu32 "\n",
+                        USB_HID_AUTOFIRE_SETTINGS_FILE_TYPE,
+                        USB_HID_AUTOFIRE_SETTINGS_LEGACY_VERSION,
+                        options->delay_ms,
+                        options->mode, options->late_policy,
+                        options->duty_percent, options->frame_align_ms,
+                        options->target_cps_x10, options->key_code,
+                        options->key_modifiers);
+  furi_check((length > 0) && ((size_t)length < sizeof(text)));
+  host_storage_write_file(USB_HID_AUTOFIRE_SETTINGS_LEGACY_PATH, text,
+                          (size_t)length);
+}
+
+// Copies a file out of the in-memory storage; returns its size.
+static size_t sim_copy_file(const char *from, const char *to) {
+  size_t size = 0U;
+  const void *data = host_storage_file_data(from, &size);
+  if (!data) {
+    return 0U;
+  }
+  FILE *file = fopen(to, "wb");
+  if (!file) {
+    fprintf(stderr, "cannot write %s\n", to);
+    return 0U;
+  }
+  fwrite(data, 1U, size, file);
+  fclose(file);
+  return size;
+}
+
+// Tracks what the host would hold after a report; returns false for a press
+// of a held usage or a release of one that is not held.
+static bool sim_loopback_apply(uint8_t *mouse_held, uint16_t *keys_held,
+                               bool mouse, uint16_t code, bool press) {
+  if (mouse) {
+    bool ok = press ? ((*mouse_held & code) == 0U)
+                    : ((*mouse_held & code) == code);
+    *mouse_held = press ? (*mouse_held | code) : (*mouse_held & ~code);
+    return ok;
+  }
+  if (!press && (code == 0U)) {
+    memset(keys_held, 0, AUTOFIRE_SEQUENCE_MAX_KEYS * sizeof(uint16_t));
+    return true;
+  }
+  for (size_t i = 0U; i < AUTOFIRE_SEQUENCE_MAX_KEYS; i++) {
+    if (keys_held[i] == code) {
+      keys_held[i] = press ? code : 0U;
+      return !press;
+    }
+  }
+  for (size_t i = 0U; press && (i < AUTOFIRE_SEQUENCE_MAX_KEYS); i++) {
+    if (keys_held[i] == 0U) {
+      keys_held[i] = code;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Reads back the reports the loopback transport exported on exit. Their
+// ticks are exact, so the rate and the gaps need no poll model.
+static void sim_report_loopback(void) {
+  size_t size = 0U;
+  const char *data =
+      host_storage_file_data(USB_HID_AUTOFIRE_LOOPBACK_EXPORT_PATH, &size);
+  char *text = malloc(size + 1U);
+  memcpy(text, data ? data : "", data ? size : 0U);
+  text[data ? size : 0U] = '\0';
+
+  uint32_t reports = 0U;
+  uint32_t presses = 0U;
+  uint32_t release_alls = 0U;
+  uint32_t order_errors = 0U;
+  uint32_t first_tick = 0U;
+  uint32_t last_tick = 0U;
+  uint32_t gap_min_ms = UINT32_MAX;
+  uint32_t gap_max_ms = 0U;
+  uint8_t mouse_held = 0U;
+  uint16_t keys_held[AUTOFIRE_SEQUENCE_MAX_KEYS] = {0};
+  // The first line is the header.
+  const char *line = strchr(text, '\n');
+  while (line && (*++line != '\0')) {
+    unsigned long index;
+    unsigned long tick;
+    unsigned long code;
+    unsigned press;
+    char kind[8];
+    if (sscanf(line, "%lu,%lu,%7[^,],%lx,%u", &index, &tick, kind, &code,
+               &press) != 5) {
+      break;
+    }
+    bool mouse = strcmp(kind, "mouse") == 0;
+    line = strchr(line, '\n');
+    if (!mouse && (code == 0U)) {
+      // Release-all on stop, outside the firing window.
+      sim_loopback_apply(&mouse_held, keys_held, false, 0U, false);
+      release_alls++;
+      continue;
+    }
+    if (reports == 0U) {
+      first_tick = (uint32_t)tick;
+    } else {
+      uint32_t gap_ms = (uint32_t)tick - last_tick;
+      gap_min_ms = (gap_ms < gap_min_ms) ? gap_ms : gap_min_ms;
+      gap_max_ms = (gap_ms > gap_max_ms) ? gap_ms : gap_max_ms;
+    }
+    last_tick = (uint32_t)tick;
+    reports++;
+    presses += (press != 0U) ? 1U : 0U;
+    if (!sim_loopback_apply(&mouse_held, keys_held, mouse, (uint16_t)code,
+                            press != 0U)) {
+      order_errors++;
+    }
+  }
+  free(text);
+
+  uint32_t span_ms = last_tick - first_tick;
+  printf("loopback_reports=%" PRIu32 " presses=%" PRIu32
+         " release_alls=%" PRIu32 " capacity=%u span_ms=%" PRIu32
+         " reports_per_s=%.3f order_errors=%" PRIu32 "\n",
+         reports, presses, release_alls, AUTOFIRE_LOOPBACK_CAPACITY, span_ms,
+         (span_ms > 0U) ? (reports - 1U) * 1000.0 / span_ms : 0.0,
+         order_errors);
+  printf("loopback_gap_ms min=%" PRIu32 " max=%" PRIu32 "\n",
+         (reports > 1U) ? gap_min_ms : 0U, gap_max_ms);
+}
+
+// Opens the help screen while firing and pages between the info screens,
+// which floods the event queue without touching the click settings. Back
+// returns to the main screen before OK stops autofire.
+static void sim_script_mash(const SimOptions *options, uint32_t stop_tick) {
+  uint32_t tick = options->start_tick + SIM_MASH_LEAD_MS;
+  host_sim_input_hold(tick, InputKeyBack, HOST_INPUT_LONG_MS + 100U);
+  tick += HOST_INPUT_LONG_MS + 100U + SIM_EXIT_GAP_MS;
+
+  uint32_t end_tick = stop_tick - SIM_MASH_LEAD_MS;
+  for (uint32_t i = 0U; (int32_t)(tick - end_tick) < 0; i++) {
+    host_sim_input_tap(tick, (i & 1U) ? InputKeyRight : InputKeyLeft);
+    tick += options->mash_ms;
+  }
+  host_sim_input_tap(end_tick + SIM_EXIT_GAP_MS, InputKeyBack);
+}
+
+static bool sim_parse_input_log(uint8_t *data, size_t size,
+                                SimInputLog *log) {
+  *log = (SimInputLog){.data = data};
+  if (!data || (size < sizeof(log->header))) {
+    return false;
+  }
+  memcpy(&log->header, data, sizeof(log->header));
+  size_t records_offset = sizeof(log->header) + log->header.settings_size;
+  if ((log->header.magic != USB_HID_AUTOFIRE_INPUT_LOG_MAGIC) ||
+      (log->header.version != USB_HID_AUTOFIRE_INPUT_LOG_VERSION) ||
+      (log->header.record_size != sizeof(AutofireInputRecord)) ||
+      (size < records_offset)) {
+    return false;
+  }
+  log->settings = data + sizeof(log->header);
+  log->records = data + records_offset;
+  log->count = (uint32_t)((size - records_offset) /
+                          sizeof(AutofireInputRecord));
+  return true;
+}
+
+static bool sim_load_input_log(const char *path, SimInputLog *log) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t *data = malloc((size > 0) ? (size_t)size : 1U);
+  size_t read = fread(data, 1U, (size > 0) ? (size_t)size : 0U, file);
+  fclose(file);
+  if (!sim_parse_input_log(data, read, log) || (log->count == 0U)) {
+    fprintf(stderr, "%s is not an input log with events\n", path);
+    free(data);
+    log->data = NULL;
+    return false;
+  }
+  return true;
+}
+
+static AutofireInputRecord sim_input_record(const SimInputLog *log,
+                                            uint32_t index) {
+  AutofireInputRecord record;
+  memcpy(&record, &log->records[index * sizeof(record)], sizeof(record));
+  return record;
+}
+
+// Runs with the settings the log was recorded under, so the report below
+// describes the replayed run.
+static void sim_options_from_log(SimOptions *options) {
+  AutofireSettings settings = {0};
+  size_t size = options->replay.header.settings_size;
+  memcpy(&settings, options->replay.settings,
+         (size < sizeof(settings)) ? size : sizeof(settings));
+  options->delay_ms = settings.delay_ms;
+  options->mode = settings.mode;
+  options->key_code = settings.key_code;
+  options->key_modifiers = settings.key_modifiers;
+  options->late_policy = settings.late_policy;
+  options->duty_percent = settings.duty_percent;
+  options->frame_align_ms = settings.frame_align_ms;
+  options->target_cps_x10 = settings.target_cps_x10;
+  options->burst_count = settings.burst_count;
+  options->burst_interval_ms = settings.burst_interval_ms;
+  options->hold_to_fire = (settings.hold_to_fire != 0U);
+  options->transport = settings.transport;
+  memcpy(options->channels, settings.channels, sizeof(options->channels));
+}
+
+// Schedules the logged events at their time since launch, pushed back as a
+// whole when the simulated app takes input later than the device did.
+// Returns the tick of the last event.
+static uint32_t sim_script_replay(const SimOptions *options) {
+  const SimInputLog *log = &options->replay;
+  uint32_t first_ms =
+      sim_input_record(log, 0U).tick - log->header.start_tick;
+  uint32_t shift = (first_ms < options->start_tick)
+                       ? (options->start_tick - first_ms)
+                       : 0U;
+  uint32_t tick = options->start_tick;
+  for (uint32_t i = 0U; i < log->count; i++) {
+    AutofireInputRecord record = sim_input_record(log, i);
+    tick = (record.tick - log->header.start_tick) + shift;
+    if ((record.key < InputKeyMAX) && (record.type < InputTypeMAX)) {
+      host_sim_input_at(tick, (InputKey)record.key, (InputType)record.type);
+    }
+  }
+  return tick;
+}
+
+// Event counts and gaps of the replayed log, whether the app logged the
+// same events again, and the settings it left behind.
+static void sim_report_replay(const SimOptions *options, double wall_ms) {
+  const SimInputLog *log = &options->replay;
+  uint32_t types[InputTypeMAX] = {0};
+  uint32_t gap_min = 0U;
+  uint32_t gap_max = 0U;
+  AutofireInputRecord first = sim_input_record(log, 0U);
+  AutofireInputRecord previous = first;
+  for (uint32_t i = 0U; i < log->count; i++) {
+    AutofireInputRecord record = sim_input_record(log, i);
+    if (record.type < InputTypeMAX) {
+      types[record.type]++;
+    }
+    if (i > 0U) {
+      uint32_t gap = record.tick - previous.tick;
+      gap_min = ((i == 1U) || (gap < gap_min)) ? gap : gap_min;
+      gap_max = (gap > gap_max) ? gap : gap_max;
+    }
+    previous = record;
+  }
+  uint32_t span_ms = previous.tick - first.tick;
+  printf("replay_events=%" PRIu32 " presses=%" PRIu32 " releases=%" PRIu32
+         " shorts=%" PRIu32 " longs=%" PRIu32 " repeats=%" PRIu32
+         " span_ms=%" PRIu32 "\n",
+         log->count, types[InputTypePress], types[InputTypeRelease],
+         types[InputTypeShort], types[InputTypeLong], types[InputTypeRepeat],
+         span_ms);
+  printf("replay_gap_ms min=%" PRIu32 " max=%" PRIu32 " mean=%.3f\n",
+         gap_min, gap_max,
+         (log->count > 1U) ? (double)span_ms / (double)(log->count - 1U)
+                           : 0.0);
+  printf("replay_speedup=%.0f\n",
+         (wall_ms > 0.0) ? (double)furi_get_tick() / wall_ms : 0.0);
+
+  // The run ends with Back taps of its own, so only the logged prefix
+  // counts.
+  size_t size = 0U;
+  SimInputLog again;
+  uint8_t *data = (uint8_t *)host_storage_file_data(
+      USB_HID_AUTOFIRE_INPUT_LOG_PATH, &size);
+  if (sim_parse_input_log(data, size, &again) && (again.count > 0U)) {
+    uint32_t compared = (again.count < log->count) ? again.count : log->count;
+    uint32_t mismatches = log->count - compared;
+    uint32_t again_first = sim_input_record(&again, 0U).tick;
+    for (uint32_t i = 0U; i < compared; i++) {
+      AutofireInputRecord a = sim_input_record(log, i);
+      AutofireInputRecord b = sim_input_record(&again, i);
+      if ((a.key != b.key) || (a.type != b.type) ||
+          ((a.tick - first.tick) != (b.tick - again_first))) {
+        mismatches++;
+      }
+    }
+    printf("replay_logged=%" PRIu32 " replay_mismatches=%" PRIu32 "\n",
+           again.count, mismatches);
+  }
+
+  const AutofireSettingsRecord *record = host_storage_file_data(
+      USB_HID_AUTOFIRE_SETTINGS_PATH, &size);
+  if (record && (size == sizeof(*record))) {
+    const AutofireSettings *settings = &record->settings;
+    printf("final delay_ms=%" PRIu32 " mode=%" PRIu32 " key_code=0x%02" PRIX32
+           " modifiers=%" PRIu32 " preset=%" PRIu32 " duty_percent=%" PRIu32
+           " last_active=%" PRIu32 " hold_to_fire=%" PRIu32 "\n",
+           settings->delay_ms, settings->mode, settings->key_code,
+           settings->key_modifiers, settings->preset, settings->duty_percent,
+           settings->last_active, settings->hold_to_fire);
+  }
+}
+
+int main(int argc, char **argv) {
+  SimOptions options = {
+      .delay_ms = AUTOFIRE_DELAY_DEFAULT_MS,
+      .duration_ms = 60000U,
+      .mode = AutofireModeMouseLeftClick,
+      .key_code = AUTOFIRE_KEY_CODE_DEFAULT,
+      .late_policy = AutofireLatePolicyCatchUp,
+      .duty_percent = AUTOFIRE_DUTY_DEFAULT_PERCENT,
+      .frame_align_ms = AUTOFIRE_FRAME_ALIGN_DEFAULT_MS,
+  };
+  usb_hid_autofire_channel_defaults(options.channels);
+  HostSimConfig config = {
+      .dispatch_latency_ms = 0U,
+      .dispatch_jitter_ms = 0U,
+      .seed = 1U,
+      .max_tick = 0U,
+      .poll_interval_ms = SIM_POLL_DEFAULT_MS,
+      .poll_phase_ms = 0U,
+      .log_level = FuriLogLevelNone,
+  };
+
+  static const struct option long_options[] = {
+      {"delay", required_argument, NULL, 'd'},
+      {"duration", required_argument, NULL, 't'},
+      {"mode", required_argument, NULL, 'm'},
+      {"key-code", required_argument, NULL, 'k'},
+      {"modifiers", required_argument, NULL, 'K'},
+      {"late-policy", required_argument, NULL, 'p'},
+      {"duty", required_argument, NULL, 'u'},
+      {"target-cps", required_argument, NULL, 'c'},
+      {"frame-align", required_argument, NULL, 'f'},
+      {"poll", required_argument, NULL, 'o'},
+      {"poll-phase", required_argument, NULL, 'O'},
+      {"latency", required_argument, NULL, 'l'},
+      {"jitter", required_argument, NULL, 'j'},
+      {"storage-latency", required_argument, NULL, 'w'},
+      {"read-latency", required_argument, NULL, 'R'},
+      {"stall", required_argument, NULL, 'Z'},
+      {"redraws", required_argument, NULL, 'r'},
+      {"channel", required_argument, NULL, 'C'},
+      {"sequence", required_argument, NULL, 'S'},
+      {"burst", required_argument, NULL, 'B'},
+      {"hold", no_argument, NULL, 'H'},
+      {"transport", required_argument, NULL, 'T'},
+      {"capture", required_argument, NULL, 'x'},
+      {"record-input", required_argument, NULL, 'i'},
+      {"replay-input", required_argument, NULL, 'I'},
+      {"seed", required_argument, NULL, 's'},
+      {"mash", required_argument, NULL, 'b'},
+      {"legacy-settings", no_argument, NULL, 'L'},
+      {"export-trace", no_argument, NULL, 'e'},
+      {"verbose", no_argument, NULL, 'v'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int opt;
+  const char *short_options =
+      "d:t:m:k:K:p:u:f:c:o:O:l:j:w:R:Z:r:C:S:B:HT:x:i:I:s:b:Levh";
+  while ((opt = getopt_long(argc, argv, short_options, long_options, NULL)) !=
+         -1) {
+    bool ok = true;
+    switch (opt) {
+    case 'd':
+      ok = sim_parse_u32(optarg, &options.delay_ms);
+      break;
+    case 't':
+      ok = sim_parse_u32(optarg, &options.duration_ms);
+      break;
+    case 'm':
+      ok = sim_parse_u32(optarg, &options.mode);
+      break;
+    case 'k':
+      ok = sim_parse_u32(optarg, &options.key_code);
+      break;
+    case 'K':
+      ok = sim_parse_u32(optarg, &options.key_modifiers);
+      break;
+    case 'p':
+      ok = sim_parse_u32(optarg, &options.late_policy);
+      break;
+    case 'u':
+      ok = sim_parse_u32(optarg, &options.duty_percent);
+      break;
+    case 'f':
+      ok = sim_parse_u32(optarg, &options.frame_align_ms);
+      break;
+    case 'c':
+      ok = sim_parse_u32(optarg, &options.target_cps_x10) &&
+           usb_hid_autofire_target_cps_is_valid(options.target_cps_x10);
+      break;
+    case 'o':
+      ok = sim_parse_u32(optarg, &config.poll_interval_ms);
+      break;
+    case 'O':
+      ok = sim_parse_u32(optarg, &config.poll_phase_ms);
+      break;
+    case 'l':
+      ok = sim_parse_u32(optarg, &config.dispatch_latency_ms);
+      break;
+    case 'j':
+      ok = sim_parse_u32(optarg, &config.dispatch_jitter_ms);
+      break;
+    case 'w':
+      ok = sim_parse_u32(optarg, &config.storage_write_latency_ms);
+      break;
+    case 'R':
+      ok = sim_parse_u32(optarg, &config.storage_read_latency_ms);
+      break;
+    case 'Z':
+      ok = sim_parse_stall(optarg, &options);
+      break;
+    case 'r':
+      ok = sim_parse_u32(optarg, &config.redraws_per_update);
+      break;
+    case 'C':
+      ok = sim_parse_channel(optarg, &options);
+      break;
+    case 'S':
+      options.sequence_path = optarg;
+      ok = sim_install_sequence(optarg, &options.sequence_size);
+      break;
+    case 'B':
+      ok = sim_parse_burst(optarg, &options);
+      break;
+    case 'H':
+      options.hold_to_fire = true;
+      break;
+    case 'T':
+      ok = sim_parse_transport(optarg, &options.transport);
+      break;
+    case 'x':
+      options.capture_path = optarg;
+      break;
+    case 'i':
+      options.record_input_path = optarg;
+      break;
+    case 'I':
+      options.replay_path = optarg;
+      ok = sim_load_input_log(optarg, &options.replay);
+      break;
+    case 's':
+      ok = sim_parse_u32(optarg, &config.seed);
+      break;
+    case 'b':
+      ok = sim_parse_u32(optarg, &options.mash_ms) && (options.mash_ms > 0U);
+      break;
+    case 'L':
+      options.legacy_settings = true;
+      break;
+    case 'e':
+      options.export_trace = true;
+      break;
+    case 'v':
+      config.log_level = FuriLogLevelTrace;
+      break;
+    case 'h':
+      sim_usage(argv[0]);
+      return 0;
+    default:
+      ok = false;
+      break;
+    }
+    if (!ok) {
+      sim_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (options.replay_path) {
+    sim_options_from_log(&options);
+  }
+
+  // Input before the view port is up is lost, so slow reads push the
+  // script back by the reads the launch needs.
+  uint32_t launch_reads =
+      SIM_LAUNCH_READS + (options.sequence_size / AUTOFIRE_SEQUENCE_READ_SIZE);
+  options.start_tick =
+      SIM_START_TICK + (launch_reads * config.storage_read_latency_ms);
+  if (options.transport == AutofireTransportBle) {
+    // Opening BLE waits for the old connection to drop.
+    options.start_tick += AUTOFIRE_BLE_DISCONNECT_WAIT_MS;
+  }
+  config.stall_at_tick = options.start_tick + options.stall_at_ms;
+  config.stall_ms = options.stall_ms;
+  uint32_t stop_tick =
+      options.start_tick + HOST_INPUT_TAP_MS + options.duration_ms;
+  uint32_t exit_tick = stop_tick + SIM_EXIT_GAP_MS;
+  if (options.replay_path) {
+    // The log may end anywhere, so a second Back closes a help screen or
+    // dialog left open.
+    exit_tick = sim_script_replay(&options) + SIM_EXIT_GAP_MS;
+    host_sim_input_tap(exit_tick, InputKeyBack);
+    exit_tick += SIM_EXIT_GAP_MS;
+  } else if (options.mash_ms > 0U) {
+    if (options.duration_ms < (4U * SIM_MASH_LEAD_MS)) {
+      fprintf(stderr, "--mash needs a duration of at least %u ms\n",
+              4U * SIM_MASH_LEAD_MS);
+      return 1;
+    }
+    sim_script_mash(&options, stop_tick);
+  }
+  if (options.export_trace && !options.replay_path) {
+    // Hold Back for help, page right to the stats screen, export, close it.
+    host_sim_input_hold(exit_tick, InputKeyBack, HOST_INPUT_LONG_MS + 100U);
+    exit_tick += 3U * SIM_EXIT_GAP_MS;
+    host_sim_input_tap(exit_tick, InputKeyRight);
+    exit_tick += SIM_EXIT_GAP_MS;
+    host_sim_input_tap(exit_tick, InputKeyOk);
+    exit_tick += SIM_EXIT_GAP_MS;
+    host_sim_input_tap(exit_tick, InputKeyBack);
+    exit_tick += SIM_EXIT_GAP_MS;
+  }
+  config.max_tick = exit_tick + (SIM_EXIT_GAP_MS * 4U) + options.stall_ms;
+  host_sim_configure(&config);
+  sim_seed_settings(&options);
+
+  if (options.replay_path) {
+    // The log holds every key the app saw.
+  } else if (options.hold_to_fire) {
+    host_sim_input_hold(options.start_tick, InputKeyOk,
+                        stop_tick - options.start_tick);
+  } else {
+    host_sim_input_tap(options.start_tick, InputKeyOk);
+    // A single burst stops by itself; OK would start it again.
+    if ((options.burst_count == 0U) || (options.burst_interval_ms > 0U)) {
+      host_sim_input_tap(stop_tick, InputKeyOk);
+    }
+  }
+  host_sim_input_tap(exit_tick, InputKeyBack);
+
+  struct timespec wall_start;
+  struct timespec wall_end;
+  clock_gettime(CLOCK_MONOTONIC, &wall_start);
+  int32_t ret = usb_hid_autofire_app(NULL);
+  clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+  const HostQueueStats *queues = host_queue_stats();
+  const HostHidStats *hid = host_hid_stats();
+  const HostGuiStats *gui = host_gui_stats();
+  const HostStorageStats *storage = host_storage_stats();
+  uint32_t delay_ms = usb_hid_autofire_delay_clamp(options.delay_ms);
+  uint32_t hold_ms;
+  uint32_t gap_ms;
+  usb_hid_autofire_phase_ms(
+      delay_ms, usb_hid_autofire_duty_clamp(options.duty_percent),
+      usb_hid_autofire_frame_align_is_valid(options.frame_align_ms)
+          ? options.frame_align_ms
+          : AUTOFIRE_FRAME_ALIGN_DEFAULT_MS,
+      &hold_ms, &gap_ms);
+  double configured_cps =
+      (options.target_cps_x10 > 0U)
+          ? options.target_cps_x10 / 10.0
+          : usb_hid_autofire_config_cps_x10_for_delay(hold_ms + gap_ms) / 10.0;
+  double measured_cps = 0.0;
+  double interval_mean_ms = 0.0;
+  if (hid->press_edges > 1U) {
+    interval_mean_ms =
+        (double)hid->interval_sum_ms / (double)(hid->press_edges - 1U);
+    measured_cps = 1000.0 / interval_mean_ms;
+  }
+  double wall_ms = ((double)(wall_end.tv_sec - wall_start.tv_sec) * 1000.0) +
+                   ((double)(wall_end.tv_nsec - wall_start.tv_nsec) / 1e6);
+
+  printf("delay_ms=%" PRIu32 " duty_percent=%" PRIu32
+         " frame_align_ms=%" PRIu32 " duration_ms=%" PRIu32
+         " target_cps_x10=%" PRIu32 " latency_ms=%" PRIu32
+         " jitter_ms=%" PRIu32 " late_policy=%" PRIu32 "\n",
+         delay_ms, options.duty_percent, options.frame_align_ms,
+         options.duration_ms, options.target_cps_x10,
+         config.dispatch_latency_ms, config.dispatch_jitter_ms,
+         options.late_policy);
+  printf("clicks=%" PRIu32 " releases=%" PRIu32 " reports=%" PRIu32 "\n",
+         hid->press_edges, hid->release_edges, hid->reports);
+  if (hid->press_edges > 0U) {
+    printf("first_report_ms=%" PRIu32 " after the OK press\n",
+           hid->first_press_tick - options.start_tick);
+  }
+  printf("configured_cps=%.1f measured_cps=%.3f drift_pct=%.3f\n",
+         configured_cps, measured_cps,
+         (configured_cps > 0.0)
+             ? ((measured_cps / configured_cps) - 1.0) * 100.0
+             : 0.0);
+  printf("interval_ms min=%" PRIu32 " max=%" PRIu32 " mean=%.3f\n",
+         (hid->press_edges > 1U) ? hid->interval_min_ms : 0U,
+         hid->interval_max_ms, interval_mean_ms);
+  printf("hold_ms min=%" PRIu32 " max=%" PRIu32 " mean=%.3f\n",
+         (hid->release_edges > 0U) ? hid->hold_min_ms : 0U, hid->hold_max_ms,
+         (hid->release_edges > 0U)
+             ? (double)hid->hold_sum_ms / (double)hid->release_edges
+             : 0.0);
+  for (uint32_t i = 0U; i < hid->usage_count; i++) {
+    const HostHidUsage *usage = &hid->usages[i];
+    printf("%s usage=0x%02" PRIx16 " presses=%" PRIu32
+           " first_ms=%" PRIu32 " interval_ms min=%" PRIu32 " max=%" PRIu32
+           "\n",
+           usage->mouse ? "mouse" : "key", usage->code, usage->presses,
+           usage->first_press_tick - hid->first_press_tick,
+           (usage->presses > 1U) ? usage->interval_min_ms : 0U,
+           usage->interval_max_ms);
+  }
+  if (config.poll_interval_ms > 0U) {
+    printf("poll_ms=%" PRIu32 " polls=%" PRIu32 " polled_clicks=%" PRIu32
+           " lost_clicks=%" PRIu32 "\n",
+           config.poll_interval_ms, hid->polls, hid->polled_press_edges,
+           hid->press_edges - hid->polled_press_edges);
+  }
+  printf("queue_puts=%" PRIu32 " queue_drops=%" PRIu32
+         " queue_max_depth=%" PRIu32 "\n",
+         queues->puts, queues->put_failures, queues->max_depth);
+  printf("view_port_updates=%" PRIu32 " draws=%" PRIu32 " primitives=%" PRIu32
+         " draw_ns_mean=%.0f\n",
+         gui->view_port_updates, gui->draws, gui->primitives,
+         (gui->draws > 0U) ? (double)gui->draw_ns / (double)gui->draws : 0.0);
+  printf("storage_opens=%" PRIu32 " reads=%" PRIu32 " read_bytes=%" PRIu32
+         " writes=%" PRIu32 " write_bytes=%" PRIu32 " removes=%" PRIu32
+         " renames=%" PRIu32 "\n",
+         storage->opens, storage->reads, storage->read_bytes, storage->writes,
+         storage->write_bytes, storage->removes, storage->renames);
+  if (options.export_trace) {
+    size_t export_size = 0U;
+    const char *export_data = host_storage_file_data(
+        USB_HID_AUTOFIRE_TRACE_EXPORT_PATH, &export_size);
+    uint32_t export_lines = 0U;
+    for (size_t i = 0U; export_data && (i < export_size); i++) {
+      export_lines += (export_data[i] == '\n') ? 1U : 0U;
+    }
+    printf("trace_export_bytes=%zu trace_export_lines=%" PRIu32 "\n",
+           export_size, export_lines);
+  }
+  if (options.transport == AutofireTransportLoopback) {
+    sim_report_loopback();
+  }
+  if (options.capture_path) {
+    char old_path[256];
+    snprintf(old_path, sizeof(old_path), "%s.old", options.capture_path);
+    size_t bytes =
+        sim_copy_file(USB_HID_AUTOFIRE_CAPTURE_PATH, options.capture_path);
+    size_t old_bytes =
+        sim_copy_file(USB_HID_AUTOFIRE_CAPTURE_OLD_PATH, old_path);
+    printf("capture_bytes=%zu capture_old_bytes=%zu\n", bytes, old_bytes);
+  }
+  if (options.record_input_path) {
+    printf("input_log_bytes=%zu\n",
+           sim_copy_file(USB_HID_AUTOFIRE_INPUT_LOG_PATH,
+                         options.record_input_path));
+  }
+  if (options.replay_path) {
+    sim_report_replay(&options, wall_ms);
+    free(options.replay.data);
+  }
+  printf("virtual_ms=%" PRIu32 " wall_ms=%.3f\n", furi_get_tick(), wall_ms);
+
+  return (ret == 0) ? 0 : 1;
+}
@@ -0,0 +1,574 @@
+// Runs fixed scenarios through the unmodified app on the virtual clock and
+// checks the exact timing of what it sent, failing on any mismatch. Every
+// case runs in a process of its own, since the stand-in layer keeps its
+// state in globals. With --measure the delivered-rate tool is checked on a
+// generated event stream as well.
+
+#include "usb_hid_autofire_host.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/input.h>
+#endif
+
+#include "../usb_hid_autofire_i.h"
+
+#define TEST_START_TICK 200U
+#define TEST_EXIT_GAP_MS 200U
+#define TEST_MAX_REPORTS AUTOFIRE_LOOPBACK_CAPACITY
+#define TEST_KEY_A 0x04U
+#define TEST_KEY_B 0x05U
+#define TEST_KEY_C 0x06U
+
+int32_t usb_hid_autofire_app(void *p);
+
+typedef struct {
+  uint32_t tick;
+  bool mouse;
+  uint16_t code;
+  bool press;
+} TestReport;
+
+// One step of a sequence pass: the change and its offset from the start of
+// the pass.
+typedef struct {
+  uint16_t code;
+  bool press;
+  uint32_t offset_ms;
+} TestStep;
+
+typedef struct {
+  const char *name;
+  bool (*run)(void);
+} TestCase;
+
+static const char *test_measure_path = NULL;
+
+static bool test_expect(bool ok, const char *format, ...) {
+  if (!ok) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "  ");
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+  }
+  return ok;
+}
+
+static AutofireSettings test_settings(void) {
+  return (AutofireSettings){
+      .delay_ms = AUTOFIRE_DELAY_DEFAULT_MS,
+      .preset = AutofirePresetCustom,
+      .startup_policy = AutofireStartupPolicyPausedOnLaunch,
+      .duty_percent = AUTOFIRE_DUTY_DEFAULT_PERCENT,
+      .transport = AutofireTransportUsb,
+  };
+}
+
+static void test_write_settings(const AutofireSettings *settings) {
+  AutofireSettingsRecord record = {.settings = *settings};
+  usb_hid_autofire_settings_seal(&record);
+  host_storage_write_file(USB_HID_AUTOFIRE_SETTINGS_PATH, &record,
+                          sizeof(record));
+}
+
+// Seeds the settings, taps OK at the start and stop ticks and Back after
+// that, and runs the app to its exit.
+static bool test_run_app(const AutofireSettings *settings,
+                         HostSimConfig *config, uint32_t stop_tick) {
+  uint32_t exit_tick = stop_tick + TEST_EXIT_GAP_MS + config->stall_ms;
+  config->max_tick = exit_tick + (TEST_EXIT_GAP_MS * 4U);
+  host_sim_configure(config);
+
+  test_write_settings(settings);
+  host_sim_input_tap(TEST_START_TICK, InputKeyOk);
+  host_sim_input_tap(stop_tick, InputKeyOk);
+  host_sim_input_tap(exit_tick, InputKeyBack);
+  return test_expect(usb_hid_autofire_app(NULL) == 0, "app failed");
+}
+
+static bool test_install_sequence(const char *text) {
+  return host_storage_write_file(USB_HID_AUTOFIRE_SEQUENCE_PATH, text,
+                                 strlen(text));
+}
+
+// Reads back the loopback export, leaving out the release-all on stop.
+static uint32_t test_loopback_reports(TestReport *reports) {
+  size_t size = 0U;
+  const char *data =
+      host_storage_file_data(USB_HID_AUTOFIRE_LOOPBACK_EXPORT_PATH, &size);
+  char *text = malloc(size + 1U);
+  memcpy(text, data ? data : "", data ? size : 0U);
+  text[data ? size : 0U] = '\0';
+
+  uint32_t count = 0U;
+  const char *line = strchr(text, '\n');
+  while (line && (*++line != '\0') && (count < TEST_MAX_REPORTS)) {
+    unsigned long index;
+    unsigned long tick;
+    unsigned long code;
+    unsigned press;
+    char kind[8];
+    if (sscanf(line, "%lu,%lu,%7[^,],%lx,%u", &index, &tick, kind, &code,
+               &press) != 5) {
+      break;
+    }
+    line = strchr(line, '\n');
+    bool mouse = strcmp(kind, "mouse") == 0;
+    if (mouse || (code != 0U)) {
+      reports[count++] = (TestReport){(uint32_t)tick, mouse, (uint16_t)code,
+                                      press != 0U};
+    }
+  }
+  free(text);
+  return count;
+}
+
+// Checks every report before `stop_tick` against the steps of a pass, and
+// that at least `min_passes` passes went out.
+static bool test_check_steps(const TestStep *steps, uint32_t step_count,
+                             uint32_t period_ms, uint32_t stop_tick,
+                             uint32_t min_passes) {
+  TestReport *reports = malloc(TEST_MAX_REPORTS * sizeof(TestReport));
+  uint32_t count = test_loopback_reports(reports);
+  bool ok = test_expect(count > 0U, "no reports");
+  uint32_t checked = 0U;
+  for (uint32_t i = 0U; ok && (i < count) && (reports[i].tick < stop_tick);
+       i++) {
+    const TestStep *step = &steps[i % step_count];
+    uint32_t tick = reports[0].tick + ((i / step_count) * period_ms) +
+                    step->offset_ms;
+    ok = test_expect(
+        (reports[i].code == step->code) && (reports[i].press == step->press) &&
+            (reports[i].tick == tick),
+        "report %" PRIu32 ": expected 0x%02X %s at %" PRIu32
+        ", got 0x%02X %s at %" PRIu32,
+        i, step->code, step->press ? "press" : "release", tick,
+        reports[i].code, reports[i].press ? "press" : "release",
+        reports[i].tick);
+    checked++;
+  }
+  ok = ok && test_expect(checked >= (min_passes * step_count),
+                         "only %" PRIu32 " reports checked", checked);
+  free(reports);
+  return ok;
+}
+
+// Press times and holds of every step of a resident sequence, loop
+// included.
+static bool test_sequence_steps(void) {
+  static const TestStep steps[] = {
+      {TEST_KEY_A, true, 0U},    {TEST_KEY_A, false, 10U},
+      {TEST_KEY_B, true, 50U},   {TEST_KEY_B, false, 70U},
+      {TEST_KEY_C, true, 100U},  {TEST_KEY_C, false, 105U},
+      {TEST_KEY_C, true, 120U},  {TEST_KEY_C, false, 125U},
+  };
+  bool ok = test_install_sequence("tap a 10\n"
+                                  "wait 40\n"
+                                  "tap b 20\n"
+                                  "wait 30\n"
+                                  "loop 2\n"
+                                  "  tap c 5\n"
+                                  "  wait 15\n"
+                                  "end\n"
+                                  "wait 100\n");
+  AutofireSettings settings = test_settings();
+  settings.sequence_enabled = 1U;
+  settings.transport = AutofireTransportLoopback;
+  HostSimConfig config = {.seed = 1U, .log_level = FuriLogLevelWarn};
+  uint32_t stop_tick = TEST_START_TICK + 5000U;
+  return ok && test_run_app(&settings, &config, stop_tick) &&
+         test_check_steps(steps, sizeof(steps) / sizeof(steps[0]), 240U,
+                          stop_tick, 20U);
+}
+
+// A streamed program whose loop body crosses a chunk boundary: the loop
+// start has to be back in memory each time round, so no stall may push the
+// grid even with slow reads.
+static bool test_sequence_stream_loop(void) {
+  static TestStep steps[1200];
+  char text[512];
+  size_t length = (size_t)snprintf(text, sizeof(text), "loop 50\n");
+  for (uint32_t i = 0U; i < 12U; i++) {
+    length += (size_t)snprintf(text + length, sizeof(text) - length,
+                               "  tap a 5\n  wait 5\n");
+  }
+  length += (size_t)snprintf(text + length, sizeof(text) - length, "end\n");
+  for (uint32_t i = 0U; i < 20U; i++) {
+    length +=
+        (size_t)snprintf(text + length, sizeof(text) - length, "wait 1\n");
+  }
+  for (uint32_t i = 0U; i < 600U; i++) {
+    steps[2U * i] = (TestStep){TEST_KEY_A, true, i * 10U};
+    steps[(2U * i) + 1U] = (TestStep){TEST_KEY_A, false, (i * 10U) + 5U};
+  }
+
+  AutofireSettings settings = test_settings();
+  settings.sequence_enabled = 1U;
+  settings.transport = AutofireTransportLoopback;
+  HostSimConfig config = {.seed = 1U,
+                          .storage_read_latency_ms = 3U,
+                          .log_level = FuriLogLevelWarn};
+  uint32_t stop_tick = TEST_START_TICK + 13000U;
+  return test_install_sequence(text) &&
+         test_run_app(&settings, &config, stop_tick) &&
+         test_check_steps(steps, sizeof(steps) / sizeof(steps[0]), 6020U,
+                          stop_tick, 2U);
+}
+
+// Frame-aligned clicks at the fastest setting: every change on a poll
+// boundary, one poll or more apart, and the polling host sees each click.
+// Without alignment the same delay loses clicks.
+static bool test_frame_align_case(uint32_t frame_align_ms, bool *lossless) {
+  AutofireSettings settings = test_settings();
+  settings.delay_ms = AUTOFIRE_DELAY_MIN_MS;
+  settings.duty_percent = AUTOFIRE_DUTY_MIN_PERCENT;
+  settings.frame_align_ms = frame_align_ms;
+  HostSimConfig config = {
+      .seed = 1U, .poll_interval_ms = 2U, .log_level = FuriLogLevelWarn};
+  if (!test_run_app(&settings, &config, TEST_START_TICK + 10000U)) {
+    return false;
+  }
+  const HostHidStats *hid = host_hid_stats();
+  *lossless = (hid->press_edges > 0U) &&
+              (hid->polled_press_edges == hid->press_edges);
+  if (frame_align_ms == 0U) {
+    return true;
+  }
+  return test_expect(*lossless,
+                     "polled %" PRIu32 " of %" PRIu32 " clicks",
+                     hid->polled_press_edges, hid->press_edges) &&
+         test_expect((hid->first_press_tick % frame_align_ms) == 0U,
+                     "first press at %" PRIu32, hid->first_press_tick) &&
+         test_expect((hid->interval_min_ms == 6U) &&
+                         (hid->interval_max_ms == 6U),
+                     "intervals %" PRIu32 "-%" PRIu32 " ms, expected 6",
+                     hid->interval_min_ms, hid->interval_max_ms) &&
+         test_expect((hid->hold_min_ms == 2U) && (hid->hold_max_ms == 2U),
+                     "holds %" PRIu32 "-%" PRIu32 " ms, expected 2",
+                     hid->hold_min_ms, hid->hold_max_ms);
+}
+
+static bool test_frame_align(void) {
+  bool lossless = false;
+  return test_frame_align_case(2U, &lossless);
+}
+
+static bool test_frame_align_off_loses(void) {
+  bool lossless = true;
+  return test_frame_align_case(0U, &lossless) &&
+         test_expect(!lossless, "no click lost without alignment");
+}
+
+// A 2.5 s stall at 1 CPS with the skip policy: the clicks after it stay on
+// the 1 s grid of the target rate, not of the 10 ms delay.
+static bool test_target_skip(void) {
+  AutofireSettings settings = test_settings();
+  settings.target_cps_x10 = 10U;
+  settings.late_policy = AutofireLatePolicySkip;
+  settings.transport = AutofireTransportLoopback;
+  HostSimConfig config = {.seed = 1U,
+                          .stall_at_tick = TEST_START_TICK + 3000U,
+                          .stall_ms = 2500U,
+                          .log_level = FuriLogLevelWarn};
+  uint32_t stop_tick = TEST_START_TICK + 10000U;
+  if (!test_run_app(&settings, &config, stop_tick)) {
+    return false;
+  }
+
+  TestReport *reports = malloc(TEST_MAX_REPORTS * sizeof(TestReport));
+  uint32_t count = test_loopback_reports(reports);
+  bool ok = test_expect(count > 0U, "no reports");
+  uint32_t presses = 0U;
+  for (uint32_t i = 0U; ok && (i < count); i++) {
+    // The press due in the stall goes out when it ends.
+    uint32_t offset = reports[i].tick - reports[0].tick;
+    bool in_stall = (reports[i].tick == (config.stall_at_tick +
+                                         config.stall_ms));
+    if (reports[i].press && !in_stall) {
+      ok = test_expect((offset % 1000U) == 0U,
+                       "press %" PRIu32 " ms after the first", offset);
+      presses++;
+    }
+  }
+  free(reports);
+  return ok && test_expect(presses >= 7U, "only %" PRIu32 " presses",
+                           presses);
+}
+
+// A 2 s stall at 200 CPS with catch up and a 10 s manual delay: the stall
+// is far past the catch-up limit, so the missed clicks are not sent.
+static bool test_target_catch_up(void) {
+  AutofireSettings settings = test_settings();
+  settings.delay_ms = AUTOFIRE_DELAY_MAX_MS;
+  settings.target_cps_x10 = 2000U;
+  settings.late_policy = AutofireLatePolicyCatchUp;
+  HostSimConfig config = {.seed = 1U,
+                          .stall_at_tick = TEST_START_TICK + 1000U,
+                          .stall_ms = 2000U,
+                          .log_level = FuriLogLevelWarn};
+  uint32_t firing_ms = 5000U;
+  if (!test_run_app(&settings, &config, TEST_START_TICK + firing_ms)) {
+    return false;
+  }
+  const HostHidStats *hid = host_hid_stats();
+  uint32_t most = ((firing_ms - config.stall_ms) / 5U) + 20U;
+  return test_expect((hid->press_edges > 0U) && (hid->press_edges <= most),
+                     "%" PRIu32 " clicks, at most %" PRIu32 " expected",
+                     hid->press_edges, most);
+}
+
+// A 5-click burst under a 3 s hold: the main screen stops showing FIRING
+// once the burst is out, not when OK is let go.
+static bool test_hold_burst_done(void) {
+  AutofireSettings settings = test_settings();
+  settings.delay_ms = 50U;
+  settings.hold_to_fire = 1U;
+  settings.burst_count = 5U;
+  uint32_t hold_ms = 3000U;
+  uint32_t exit_tick = TEST_START_TICK + hold_ms + TEST_EXIT_GAP_MS;
+  HostSimConfig config = {.seed = 1U,
+                          .max_tick = exit_tick + (TEST_EXIT_GAP_MS * 4U),
+                          .log_level = FuriLogLevelWarn};
+  host_sim_configure(&config);
+  test_write_settings(&settings);
+  host_gui_watch("FIRING");
+  host_sim_input_hold(TEST_START_TICK, InputKeyOk, hold_ms);
+  host_sim_input_tap(exit_tick, InputKeyBack);
+  if (!test_expect(usb_hid_autofire_app(NULL) == 0, "app failed")) {
+    return false;
+  }
+
+  const HostHidStats *hid = host_hid_stats();
+  const HostGuiStats *gui = host_gui_stats();
+  uint32_t gone = gui->watch_gone_tick;
+  return test_expect(hid->press_edges == settings.burst_count,
+                     "%" PRIu32 " clicks, expected %" PRIu32,
+                     hid->press_edges, settings.burst_count) &&
+         test_expect(gui->watch_frames > 0U, "FIRING never shown") &&
+         test_expect((gone > TEST_START_TICK) &&
+                         (gone < TEST_START_TICK + 1000U),
+                     "FIRING gone at %" PRIu32 ", burst ended by %" PRIu32,
+                     gone, TEST_START_TICK + 1000U);
+}
+
+// A long OK press under hold-to-fire is part of the hold: firing goes on
+// through it, the preset stays, and the help page says what OK does.
+static bool test_hold_long_press(void) {
+  AutofireSettings settings = test_settings();
+  settings.hold_to_fire = 1U;
+  uint32_t hold_ms = 1000U;
+  uint32_t help_tick = TEST_START_TICK + hold_ms + TEST_EXIT_GAP_MS;
+  uint32_t exit_tick = help_tick + 1000U;
+  HostSimConfig config = {.seed = 1U,
+                          .max_tick = exit_tick + (TEST_EXIT_GAP_MS * 4U),
+                          .log_level = FuriLogLevelWarn};
+  host_sim_configure(&config);
+  test_write_settings(&settings);
+  host_gui_watch("hold: fire");
+  host_sim_input_hold(TEST_START_TICK, InputKeyOk, hold_ms);
+  host_sim_input_hold(help_tick, InputKeyBack, HOST_INPUT_LONG_MS * 2U);
+  host_sim_input_tap(exit_tick - TEST_EXIT_GAP_MS, InputKeyBack);
+  host_sim_input_tap(exit_tick, InputKeyBack);
+  if (!test_expect(usb_hid_autofire_app(NULL) == 0, "app failed")) {
+    return false;
+  }
+
+  size_t size = 0U;
+  const AutofireSettingsRecord *record =
+      host_storage_file_data(USB_HID_AUTOFIRE_SETTINGS_PATH, &size);
+  const HostHidStats *hid = host_hid_stats();
+  uint32_t last_due = TEST_START_TICK + hold_ms - (settings.delay_ms * 2U);
+  return test_expect(hid->last_press_tick >= last_due,
+                     "last press at %" PRIu32 ", hold ended at %" PRIu32,
+                     hid->last_press_tick, TEST_START_TICK + hold_ms) &&
+         test_expect(record && (size == sizeof(*record)) &&
+                         (record->settings.preset == settings.preset),
+                     "preset changed by the long press") &&
+         test_expect(host_gui_stats()->watch_frames > 0U,
+                     "help page does not show the hold");
+}
+
+// Two minutes of firing with no key pressed: once the display times out
+// the refresh timer stops, so the main loop stops getting woken for it.
+static bool test_refresh_display_off(void) {
+  AutofireSettings settings = test_settings();
+  HostSimConfig config = {.seed = 1U, .log_level = FuriLogLevelWarn};
+  uint32_t firing_ms = 120000U;
+  if (!test_run_app(&settings, &config, TEST_START_TICK + firing_ms)) {
+    return false;
+  }
+  uint32_t most = ((UI_DISPLAY_OFF_MS + TEST_EXIT_GAP_MS) /
+                   UI_REFRESH_SLOW_PERIOD_MS) +
+                  20U;
+  uint32_t puts = host_queue_stats()->puts;
+  return test_expect(puts <= most,
+                     "%" PRIu32 " events queued, at most %" PRIu32
+                     " expected",
+                     puts, most);
+}
+
+// The shown rate at 100 CPS holds through a gap shorter than a click and
+// falls off once clicks stop.
+static bool test_cps_decay(void) {
+  AutofireCpsWindow window;
+  usb_hid_autofire_cps_window_reset(&window);
+  for (uint32_t i = 0U; i < AUTOFIRE_CPS_SHORT_WINDOW; i++) {
+    usb_hid_autofire_cps_window_push(&window, 10U);
+  }
+  uint32_t running = usb_hid_autofire_cps_window_cps_x10(&window, false, 5U);
+  uint32_t stopped =
+      usb_hid_autofire_cps_window_cps_x10(&window, false, 1010U);
+  uint32_t stopped_long =
+      usb_hid_autofire_cps_window_cps_x10(&window, true, 1010U);
+  return test_expect(running == 1000U, "%" PRIu32 " running, expected 1000",
+                     running) &&
+         test_expect(stopped == 74U, "%" PRIu32 " after 1 s, expected 74",
+                     stopped) &&
+         test_expect(stopped_long == 74U,
+                     "%" PRIu32 " after 1 s (long), expected 74",
+                     stopped_long);
+}
+
+#ifdef __linux__
+static void test_write_event(FILE *file, uint64_t us, uint16_t type,
+                             uint16_t code, int32_t value) {
+  struct input_event event = {
+      .input_event_sec = (time_t)(us / 1000000U),
+      .input_event_usec = (suseconds_t)(us % 1000000U),
+      .type = type,
+      .code = code,
+      .value = value,
+  };
+  fwrite(&event, sizeof(event), 1U, file);
+}
+
+// 200 clicks 10 ms apart with three left out, one extra click 3 ms after
+// another and one press and release in the same report.
+static bool test_measure(void) {
+  char path[] = "/tmp/usb_hid_autofire_test_XXXXXX";
+  int fd = mkstemp(path);
+  FILE *file = (fd >= 0) ? fdopen(fd, "wb") : NULL;
+  if (!test_expect(file != NULL, "cannot create %s", path)) {
+    return false;
+  }
+  for (uint32_t i = 0U; i < 200U; i++) {
+    uint64_t us = 1000000U + (i * 10000U);
+    if ((i == 50U) || (i == 51U) || (i == 120U)) {
+      continue;
+    }
+    uint64_t release_us = (i == 170U) ? us : (us + 5000U);
+    test_write_event(file, us, EV_KEY, BTN_LEFT, 1);
+    if (release_us != us) {
+      test_write_event(file, us, EV_SYN, SYN_REPORT, 0);
+    }
+    test_write_event(file, release_us, EV_KEY, BTN_LEFT, 0);
+    test_write_event(file, release_us, EV_SYN, SYN_REPORT, 0);
+    if (i == 150U) {
+      test_write_event(file, us + 6000U, EV_KEY, BTN_LEFT, 1);
+      test_write_event(file, us + 6000U, EV_SYN, SYN_REPORT, 0);
+      test_write_event(file, us + 8000U, EV_KEY, BTN_LEFT, 0);
+      test_write_event(file, us + 8000U, EV_SYN, SYN_REPORT, 0);
+    }
+  }
+  fclose(file);
+
+  char command[256];
+  snprintf(command, sizeof(command), "%s --delay 10 --replay %s",
+           test_measure_path, path);
+  FILE *output = popen(command, "r");
+  char line[160];
+  unsigned presses = 0U;
+  unsigned releases = 0U;
+  unsigned same_frame = 0U;
+  unsigned lost = 0U;
+  unsigned merged = 0U;
+  bool found = false;
+  while (output && fgets(line, sizeof(line), output)) {
+    sscanf(line, "presses=%u releases=%u same_frame=%u", &presses, &releases,
+           &same_frame);
+    found |= sscanf(line, "lost_clicks=%u merged_clicks=%u", &lost,
+                    &merged) == 2;
+  }
+  bool ok = test_expect(output && (pclose(output) == 0) && found,
+                        "%s failed", command);
+  remove(path);
+  return ok &&
+         test_expect((presses == 198U) && (releases == 198U) &&
+                         (same_frame == 1U),
+                     "presses=%u releases=%u same_frame=%u, expected "
+                     "198 198 1",
+                     presses, releases, same_frame) &&
+         test_expect((lost == 3U) && (merged == 1U),
+                     "lost_clicks=%u merged_clicks=%u, expected 3 1", lost,
+                     merged);
+}
+#endif
+
+static const TestCase test_cases[] = {
+    {"sequence_steps", test_sequence_steps},
+    {"sequence_stream_loop", test_sequence_stream_loop},
+    {"frame_align", test_frame_align},
+    {"frame_align_off_loses", test_frame_align_off_loses},
+    {"target_skip", test_target_skip},
+    {"target_catch_up", test_target_catch_up},
+    {"hold_burst_done", test_hold_burst_done},
+    {"hold_long_press", test_hold_long_press},
+    {"cps_decay", test_cps_decay},
+    {"refresh_display_off", test_refresh_display_off},
+};
+
+static bool test_run_case(const char *name, bool (*run)(void)) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    exit(run() ? 0 : 1);
+  }
+  int status = 0;
+  bool ok = (pid > 0) && (waitpid(pid, &status, 0) == pid) &&
+            WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+  printf("test=%s result=%s\n", name, ok ? "pass" : "fail");
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const struct option long_options[] = {
+      {"measure", required_argument, NULL, 'm'},
+      {"help", no_argument, NULL, 'h'},
+      {NULL, 0, NULL, 0},
+  };
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "m:h", long_options, NULL)) != -1) {
+    if (opt == 'm') {
+      test_measure_path = optarg;
+    } else {
+      fprintf(stderr,
+              "usage: %s [options]\n"
+              "  -m, --measure PATH    also check the delivered-rate tool "
+              "at PATH\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  uint32_t failures = 0U;
+  for (size_t i = 0U; i < (sizeof(test_cases) / sizeof(test_cases[0])); i++) {
+    failures +=
+        test_run_case(test_cases[i].name, test_cases[i].run) ? 0U : 1U;
+  }
+#ifdef __linux__
+  if (test_measure_path) {
+    failures += test_run_case("measure_replay", test_measure) ? 0U : 1U;
+  }
+#endif
+  printf("failures=%" PRIu32 "\n", failures);
+  return (failures == 0U) ? 0 : 1;
+}
@@ -1,31 +1,30 @@
 #include "usb_hid_autofire_i.h"
 
-int32_t usb_hid_autofire_app(void *p) {
-  UNUSED(p);
-  int32_t ret = -1;
-  bool gui_opened = false;
-  bool view_port_added = false;
-  bool usb_switched = false;
-
-  UsbHidAutofireApp app = {
+// App state before the settings are loaded.
+void usb_hid_autofire_app_defaults(UsbHidAutofireApp *app) {
+  *app = (UsbHidAutofireApp){
       .event_queue = NULL,
       .view_port = NULL,
       .gui = NULL,
       .dialogs = NULL,
-      .click_timer = NULL,
+      .click_worker = NULL,
+      .click_commands = NULL,
+      .engine_mutex = NULL,
       .ui_refresh_timer = NULL,
       .settings_save_timer = NULL,
-      .usb_mode_prev = NULL,
+      .event_pending = 0U,
       .active = false,
-      .mouse_pressed = false,
       .ui_dirty = true,
       .settings_dirty = false,
-      .show_help = false,
+      .screen = AutofireScreenMain,
+      .option = AutofireOptionTarget,
       .last_active_state = false,
       .autofire_delay_ms = AUTOFIRE_DELAY_DEFAULT_MS,
+      .duty_percent = AUTOFIRE_DUTY_DEFAULT_PERCENT,
+      .frame_align_ms = AUTOFIRE_FRAME_ALIGN_DEFAULT_MS,
+      .target_cps_x10 = 0U,
       .realtime_cps_x10 = 0U,
-      .last_click_release_tick_ms = 0U,
-      .last_click_interval_ms = 0U,
+      .realtime_long_cps_x10 = 0U,
       .adjust_hold_active = false,
       .adjust_hold_key = InputKeyMAX,
       .adjust_repeat_count = 0U,
@@ -34,159 +33,293 @@ int32_t usb_hid_autofire_app(void *p) {
       .ok_long_handled = false,
       .back_long_handled = false,
       .mode = AutofireModeMouseLeftClick,
+      .key_code = AUTOFIRE_KEY_CODE_DEFAULT,
+      .key_modifiers = 0U,
       .preset = AutofirePresetCustom,
       .startup_policy = AutofireStartupPolicyPausedOnLaunch,
-      .click_phase = ClickPhasePress,
+      .late_policy = AutofireLatePolicyCatchUp,
+      .engine =
+          {
+              .active = false,
+              .pressed = false,
+              .click_phase = ClickPhasePress,
+          },
+      .trace_export_result = AutofireExportResultNone,
+      .view =
+          {
+              .mutex = NULL,
+              .screen = AutofireScreenMain,
+              .dirty = AutofireViewAll,
+          },
   };
 
-  app.autofire_delay_ms = usb_hid_autofire_delay_clamp(app.autofire_delay_ms);
-  usb_hid_autofire_settings_load(&app);
-  usb_hid_autofire_reset_cps_tracking(&app);
+  usb_hid_autofire_channel_defaults(app->channels);
+  app->autofire_delay_ms =
+      usb_hid_autofire_delay_clamp(app->autofire_delay_ms);
+}
+
+// Hands the loaded settings to the engine before the worker starts.
+void usb_hid_autofire_engine_init(UsbHidAutofireApp *app) {
+  AutofireEngine *engine = &app->engine;
+  engine->sequence.program = &app->sequence;
+  engine->sequence.transport = &app->transport;
+  engine->mode = app->mode;
+  engine->kind = usb_hid_autofire_target(app->mode)->kind;
+  engine->hid_code = usb_hid_autofire_target_code(app->mode, app->key_code,
+                                                  app->key_modifiers);
+  engine->delay_ms = app->autofire_delay_ms;
+  engine->duty_percent = app->duty_percent;
+  engine->frame_align_ms = app->frame_align_ms;
+  engine->target_cps_x10 = app->target_cps_x10;
+  engine->late_policy = app->late_policy;
+  usb_hid_autofire_reset_cps_tracking(app);
+}
+
+int32_t usb_hid_autofire_app(void *p) {
+  UNUSED(p);
+  int32_t ret = -1;
+  bool gui_opened = false;
+  bool view_port_added = false;
+
+  // On the heap: the app state is bigger than the main thread's stack.
+  UsbHidAutofireApp *app = malloc(sizeof(UsbHidAutofireApp));
+  if (!app) {
+    FURI_LOG_E(TAG, "Failed to allocate app state");
+    return ret;
+  }
+  uint32_t start_tick = furi_get_tick();
+  usb_hid_autofire_app_defaults(app);
+  usb_hid_autofire_settings_load(app);
+  usb_hid_autofire_update_hold_armed(app);
+  uint32_t settings_ticks = furi_get_tick() - start_tick;
+  // Compiled once here; the worker only ever reads the ops.
+  if (!usb_hid_autofire_sequence_load(&app->sequence)) {
+    app->sequence_enabled = false;
+  }
+  usb_hid_autofire_transport_init(&app->transport, app->transport_type);
+  usb_hid_autofire_engine_init(app);
+
+  app->engine.trace = malloc(sizeof(AutofireClickTrace));
+  if (!app->engine.trace) {
+    FURI_LOG_E(TAG, "Failed to allocate click trace");
+    goto cleanup;
+  }
+  usb_hid_autofire_trace_reset(app->engine.trace);
 
-  app.event_queue = furi_message_queue_alloc(16, sizeof(UsbMouseEvent));
-  if (!app.event_queue) {
+  app->event_queue = furi_message_queue_alloc(16, sizeof(UsbMouseEvent));
+  if (!app->event_queue) {
     FURI_LOG_E(TAG, "Failed to allocate event queue");
     goto cleanup;
   }
 
-  app.view_port = view_port_alloc();
-  if (!app.view_port) {
+  app->view.mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+  if (!app->view.mutex) {
+    FURI_LOG_E(TAG, "Failed to allocate view model mutex");
+    goto cleanup;
+  }
+
+  app->view_port = view_port_alloc();
+  if (!app->view_port) {
     FURI_LOG_E(TAG, "Failed to allocate viewport");
     goto cleanup;
   }
 
-  app.click_timer = furi_timer_alloc(usb_hid_autofire_timer_callback,
-                                     FuriTimerTypeOnce, &app);
-  if (!app.click_timer) {
-    FURI_LOG_E(TAG, "Failed to allocate timer");
+  // Capture is a diagnostic; the app runs without it.
+  if (app->capture_enabled && !usb_hid_autofire_capture_start(&app->capture)) {
+    FURI_LOG_W(TAG, "Failed to start report capture, running without it");
+    app->capture_enabled = false;
+  }
+
+  AutofireSettings launch_settings;
+  usb_hid_autofire_settings_snapshot(app, &launch_settings);
+  // Like capture, the input log is optional.
+  if (app->input_log_enabled &&
+      !usb_hid_autofire_input_log_start(&app->input_log, &launch_settings)) {
+    FURI_LOG_W(TAG, "Failed to start input log, running without it");
+    app->input_log_enabled = false;
+  }
+
+  if (!usb_hid_autofire_worker_start(app)) {
+    FURI_LOG_E(TAG, "Failed to start click worker");
+    goto cleanup;
+  }
+  // A hold starts the engine without a command, so it needs the full
+  // configuration up front.
+  usb_hid_autofire_send_config(app);
+
+  if (!usb_hid_autofire_settings_writer_start(app)) {
+    FURI_LOG_E(TAG, "Failed to start settings writer");
     goto cleanup;
   }
 
-  app.ui_refresh_timer = furi_timer_alloc(usb_hid_autofire_ui_timer_callback,
-                                          FuriTimerTypePeriodic, &app);
-  if (!app.ui_refresh_timer) {
+  app->ui_refresh_timer = furi_timer_alloc(usb_hid_autofire_ui_timer_callback,
+                                          FuriTimerTypePeriodic, app);
+  if (!app->ui_refresh_timer) {
     FURI_LOG_E(TAG, "Failed to allocate UI refresh timer");
     goto cleanup;
   }
 
-  app.settings_save_timer = furi_timer_alloc(
-      usb_hid_autofire_settings_save_timer_callback, FuriTimerTypeOnce, &app);
-  if (!app.settings_save_timer) {
+  app->settings_save_timer = furi_timer_alloc(
+      usb_hid_autofire_settings_save_timer_callback, FuriTimerTypeOnce, app);
+  if (!app->settings_save_timer) {
     FURI_LOG_E(TAG, "Failed to allocate settings save timer");
     goto cleanup;
   }
 
-  app.usb_mode_prev = furi_hal_usb_get_config();
 #ifndef USB_HID_AUTOFIRE_SCREENSHOT
-  furi_hal_usb_unlock();
-  if (!furi_hal_usb_set_config(&usb_hid, NULL)) {
-    FURI_LOG_E(TAG, "Failed to switch USB to HID mode");
+  if (!usb_hid_autofire_transport_open(&app->transport)) {
+    FURI_LOG_E(TAG, "Failed to open %s transport",
+               usb_hid_autofire_transport_label(app->transport.type));
     goto cleanup;
   }
-  usb_switched = true;
 #endif
 
-  view_port_draw_callback_set(app.view_port, usb_hid_autofire_render_callback,
-                              &app);
-  view_port_input_callback_set(app.view_port, usb_hid_autofire_input_callback,
-                               app.event_queue);
+  view_port_draw_callback_set(app->view_port, usb_hid_autofire_render_callback,
+                              app);
+  view_port_input_callback_set(app->view_port, usb_hid_autofire_input_callback,
+                               app);
 
-  app.gui = furi_record_open(RECORD_GUI);
-  if (!app.gui) {
+  app->gui = furi_record_open(RECORD_GUI);
+  if (!app->gui) {
     FURI_LOG_E(TAG, "Failed to open GUI record");
     goto cleanup;
   }
   gui_opened = true;
-  gui_add_view_port(app.gui, app.view_port, GuiLayerFullscreen);
+  gui_add_view_port(app->gui, app->view_port, GuiLayerFullscreen);
   view_port_added = true;
 
-  app.dialogs = furi_record_open(RECORD_DIALOGS);
+  app->dialogs = furi_record_open(RECORD_DIALOGS);
 
-  if ((app.startup_policy == AutofireStartupPolicyRestoreLastState) &&
-      app.last_active_state) {
-    usb_hid_autofire_start(&app);
+  if ((app->startup_policy == AutofireStartupPolicyRestoreLastState) &&
+      app->last_active_state) {
+    usb_hid_autofire_start(app);
   }
 
-  view_port_update(app.view_port);
-  app.ui_dirty = false;
+  usb_hid_autofire_ui_redraw(app);
+  FURI_LOG_I(TAG, "Cold start: settings %lums, first frame %lums",
+             (unsigned long)settings_ticks,
+             (unsigned long)(furi_get_tick() - start_tick));
 
   UsbMouseEvent event;
   while (1) {
+    uint32_t timeout = FuriWaitForever;
+    if (app->ui_dirty) {
+      timeout = furi_ms_to_ticks(usb_hid_autofire_ui_redraw_wait_ms(app));
+    }
     FuriStatus event_status =
-        furi_message_queue_get(app.event_queue, &event, FuriWaitForever);
+        usb_hid_autofire_get_event(app, &event, timeout);
     if (event_status != FuriStatusOk) {
-      continue;
-    }
-
-    if (event.type == EventTypeTick) {
-      usb_hid_autofire_tick(&app);
+      // No event before a deferred redraw came due.
     } else if (event.type == EventTypeUiRefresh) {
-      uint32_t new_cps_x10 = usb_hid_autofire_realtime_cps_x10(&app);
-      if (new_cps_x10 != app.realtime_cps_x10) {
-        app.realtime_cps_x10 = new_cps_x10;
-        app.ui_dirty = true;
+      bool changed = false;
+      uint32_t new_cps_x10;
+      uint32_t new_long_cps_x10;
+      usb_hid_autofire_realtime_cps_x10(app, &new_cps_x10, &new_long_cps_x10);
+      if ((new_cps_x10 != app->realtime_cps_x10) ||
+          (new_long_cps_x10 != app->realtime_long_cps_x10)) {
+        app->realtime_cps_x10 = new_cps_x10;
+        app->realtime_long_cps_x10 = new_long_cps_x10;
+        usb_hid_autofire_view_invalidate(app,
+                                         AutofireViewRate | AutofireViewPage);
+        changed = true;
       }
+      if (app->screen == AutofireScreenStats) {
+        changed |= usb_hid_autofire_refresh_trace_stats(app);
+      } else if (app->screen == AutofireScreenBench) {
+        changed |= usb_hid_autofire_refresh_rate_stats(app);
+      } else if (app->screen == AutofireScreenProfile) {
+        usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+        changed = true;
+      }
+      usb_hid_autofire_ui_refresh_done(app, changed);
     } else if (event.type == EventTypeSettingsSave) {
-      usb_hid_autofire_settings_flush_if_dirty(&app);
+      usb_hid_autofire_settings_flush_if_dirty(app);
     } else if (event.type == EventTypeInput) {
       bool should_exit = false;
-      usb_hid_autofire_handle_input_event(&app, &event.input, &should_exit);
+      AUTOFIRE_PROFILE_BEGIN(input_start);
+      usb_hid_autofire_handle_input_event(app, &event.input, &should_exit);
+      AUTOFIRE_PROFILE_END(app, AutofireProfileInput, input_start);
       if (should_exit) {
         break;
       }
+      usb_hid_autofire_ui_refresh_update(app);
+      usb_hid_autofire_input_log_flush(&app->input_log, false);
     }
+    // Checked after every event, so a burst end whose event was dropped on
+    // a full queue is still picked up.
+    usb_hid_autofire_handle_burst_done(app);
 
-    if (app.ui_dirty) {
-      view_port_update(app.view_port);
-      app.ui_dirty = false;
+    if (app->ui_dirty) {
+      if (usb_hid_autofire_ui_redraw_wait_ms(app) == 0U) {
+        usb_hid_autofire_ui_redraw(app);
+      } else {
+        app->ui_stats.deferred_redraws++;
+      }
     }
   }
 
   ret = 0;
 
 cleanup:
-  usb_hid_autofire_settings_flush_if_dirty(&app);
-  usb_hid_autofire_stop(&app);
-
-#ifndef USB_HID_AUTOFIRE_SCREENSHOT
-  if (usb_switched) {
-    furi_hal_usb_set_config(app.usb_mode_prev, NULL);
+  // Input goes first: a hold press in the input callback wakes the worker,
+  // which is freed below.
+  __atomic_store_n(&app->hold_armed, false, __ATOMIC_RELEASE);
+  if (view_port_added && app->gui && app->view_port) {
+    gui_remove_view_port(app->gui, app->view_port);
   }
+  usb_hid_autofire_settings_flush_if_dirty(app);
+  usb_hid_autofire_stop(app);
+  FURI_LOG_I(TAG,
+             "UI refresh: %lu wakeups in %lums firing (fixed rate %lu), %lu "
+             "redraws, %lu deferred",
+             (unsigned long)app->ui_stats.refresh_wakeups,
+             (unsigned long)app->ui_stats.active_ms,
+             (unsigned long)(app->ui_stats.active_ms / UI_REFRESH_PERIOD_MS),
+             (unsigned long)app->ui_stats.redraws,
+             (unsigned long)app->ui_stats.deferred_redraws);
+#ifdef USB_HID_AUTOFIRE_PROFILE
+  usb_hid_autofire_profile_log(app);
 #endif
+  usb_hid_autofire_worker_stop(app);
+  usb_hid_autofire_capture_stop(&app->capture);
+  usb_hid_autofire_settings_writer_stop(app);
 
-  if (view_port_added && app.gui && app.view_port) {
-    gui_remove_view_port(app.gui, app.view_port);
-  }
+  usb_hid_autofire_transport_close(&app->transport);
 
-  if (app.click_timer) {
-    furi_timer_stop(app.click_timer);
-    furi_timer_free(app.click_timer);
+  usb_hid_autofire_input_log_stop(&app->input_log);
+
+  if (app->ui_refresh_timer) {
+    furi_timer_stop(app->ui_refresh_timer);
+    furi_timer_free(app->ui_refresh_timer);
   }
 
-  if (app.ui_refresh_timer) {
-    furi_timer_stop(app.ui_refresh_timer);
-    furi_timer_free(app.ui_refresh_timer);
+  if (app->settings_save_timer) {
+    furi_timer_stop(app->settings_save_timer);
+    furi_timer_free(app->settings_save_timer);
   }
 
-  if (app.settings_save_timer) {
-    furi_timer_stop(app.settings_save_timer);
-    furi_timer_free(app.settings_save_timer);
+  if (app->view_port) {
+    view_port_free(app->view_port);
   }
 
-  if (app.view_port) {
-    view_port_free(app.view_port);
+  if (app->view.mutex) {
+    furi_mutex_free(app->view.mutex);
   }
 
-  if (app.event_queue) {
-    furi_message_queue_free(app.event_queue);
+  usb_hid_autofire_sequence_free(&app->sequence);
+
+  if (app->event_queue) {
+    furi_message_queue_free(app->event_queue);
   }
 
   if (gui_opened) {
     furi_record_close(RECORD_GUI);
   }
-  if (app.dialogs) {
+  if (app->dialogs) {
     furi_record_close(RECORD_DIALOGS);
   }
 
+  free(app->engine.trace);
+  free(app);
   return ret;
 }
@@ -0,0 +1,195 @@
+#include "usb_hid_autofire_i.h"
+
+// Keeps the previous file as the old one, so the log holds between one and
+// two files' worth of the latest reports.
+static void usb_hid_autofire_capture_rotate(Storage *storage) {
+  storage_common_remove(storage, USB_HID_AUTOFIRE_CAPTURE_OLD_PATH);
+  storage_common_rename(storage, USB_HID_AUTOFIRE_CAPTURE_PATH,
+                        USB_HID_AUTOFIRE_CAPTURE_OLD_PATH);
+}
+
+static bool usb_hid_autofire_capture_open_file(AutofireCapture *capture,
+                                               Storage *storage, File *file) {
+  usb_hid_autofire_capture_rotate(storage);
+  const AutofireCaptureHeader header = {
+      .magic = USB_HID_AUTOFIRE_CAPTURE_MAGIC,
+      .version = USB_HID_AUTOFIRE_CAPTURE_VERSION,
+      .record_size = sizeof(AutofireCaptureRecord),
+  };
+  capture->file_bytes = 0U;
+  if (!storage_file_open(file, USB_HID_AUTOFIRE_CAPTURE_PATH, FSAM_WRITE,
+                         FSOM_CREATE_ALWAYS) ||
+      (storage_file_write(file, &header, sizeof(header)) != sizeof(header))) {
+    return false;
+  }
+  capture->file_bytes = sizeof(header);
+  return true;
+}
+
+static bool usb_hid_autofire_capture_write_block(AutofireCapture *capture,
+                                                 Storage *storage, File *file,
+                                                 uint32_t block) {
+  size_t size = capture->counts[block] * sizeof(AutofireCaptureRecord);
+  if ((capture->file_bytes + size) > AUTOFIRE_CAPTURE_FILE_MAX_BYTES) {
+    storage_file_close(file);
+    capture->rollovers++;
+    if (!usb_hid_autofire_capture_open_file(capture, storage, file)) {
+      return false;
+    }
+  }
+
+  const AutofireCaptureRecord *records =
+      &capture->blocks[block * AUTOFIRE_CAPTURE_BLOCK_RECORDS];
+  if (storage_file_write(file, records, size) != size) {
+    return false;
+  }
+  capture->file_bytes += size;
+  capture->blocks_written++;
+  return true;
+}
+
+static int32_t usb_hid_autofire_capture_writer(void *ctx) {
+  AutofireCapture *capture = ctx;
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  File *file = storage_file_alloc(storage);
+  bool ok = usb_hid_autofire_capture_open_file(capture, storage, file);
+  bool running = true;
+
+  while (running) {
+    uint32_t flags = furi_thread_flags_wait(CAPTURE_WRITER_FLAGS_ALL,
+                                            FuriFlagWaitAny, FuriWaitForever);
+    if (flags & FuriFlagError) {
+      continue;
+    }
+    running = (flags & CaptureWriterFlagExit) == 0U;
+
+    uint32_t pending = __atomic_load_n(&capture->pending, __ATOMIC_ACQUIRE);
+    for (uint32_t block = 0U; block < 2U; block++) {
+      if ((pending & (1UL << block)) == 0U) {
+        continue;
+      }
+      if (ok && !usb_hid_autofire_capture_write_block(capture, storage, file,
+                                                      block)) {
+        ok = false;
+        capture->failures++;
+      }
+      __atomic_fetch_and(&capture->pending, ~(1UL << block),
+                         __ATOMIC_RELEASE);
+    }
+  }
+
+  // The worker has stopped by now, so the part-filled block is ours.
+  capture->counts[capture->active] = capture->fill;
+  if (ok && (capture->fill > 0U) &&
+      !usb_hid_autofire_capture_write_block(capture, storage, file,
+                                            capture->active)) {
+    capture->failures++;
+  }
+  storage_file_close(file);
+  storage_file_free(file);
+  furi_record_close(RECORD_STORAGE);
+  return 0;
+}
+
+bool usb_hid_autofire_capture_start(AutofireCapture *capture) {
+  capture->blocks = malloc(2U * AUTOFIRE_CAPTURE_BLOCK_RECORDS *
+                           sizeof(AutofireCaptureRecord));
+  if (!capture->blocks) {
+    return false;
+  }
+
+  capture->thread = furi_thread_alloc_ex(
+      "AutofireCapture", CAPTURE_WRITER_STACK_SIZE,
+      usb_hid_autofire_capture_writer, capture);
+  if (!capture->thread) {
+    free(capture->blocks);
+    capture->blocks = NULL;
+    return false;
+  }
+  furi_thread_set_priority(capture->thread, FuriThreadPriorityLow);
+  furi_thread_start(capture->thread);
+  return true;
+}
+
+// Call after the click worker has stopped.
+void usb_hid_autofire_capture_stop(AutofireCapture *capture) {
+  if (capture->thread) {
+    furi_thread_flags_set(furi_thread_get_id(capture->thread),
+                          CaptureWriterFlagExit);
+    furi_thread_join(capture->thread);
+    furi_thread_free(capture->thread);
+    capture->thread = NULL;
+    FURI_LOG_I(TAG,
+               "Capture: %lu records, %lu dropped, %lu blocks written, %lu "
+               "rollovers, %lu failed",
+               (unsigned long)capture->records,
+               (unsigned long)capture->dropped,
+               (unsigned long)capture->blocks_written,
+               (unsigned long)capture->rollovers,
+               (unsigned long)capture->failures);
+  }
+
+  free(capture->blocks);
+  capture->blocks = NULL;
+}
+
+// Hands the active block to the writer unless it still holds the other.
+static bool usb_hid_autofire_capture_hand_over(AutofireCapture *capture) {
+  uint32_t other = capture->active ^ 1U;
+  if (__atomic_load_n(&capture->pending, __ATOMIC_ACQUIRE) & (1UL << other)) {
+    return false;
+  }
+
+  capture->counts[capture->active] = capture->fill;
+  __atomic_fetch_or(&capture->pending, 1UL << capture->active,
+                    __ATOMIC_RELEASE);
+  furi_thread_flags_set(furi_thread_get_id(capture->thread),
+                        CaptureWriterFlagFlush);
+  capture->active = other;
+  capture->fill = 0U;
+  return true;
+}
+
+// Runs on the click worker for every change of a scheduler pass.
+void usb_hid_autofire_capture_record(AutofireCapture *capture,
+                                     const AutofireHidChange *change,
+                                     uint8_t channel, uint32_t tick,
+                                     uint32_t late_ms) {
+  if (!capture->thread) {
+    return;
+  }
+
+  uint16_t sequence = capture->sequence++;
+  if ((capture->fill == AUTOFIRE_CAPTURE_BLOCK_RECORDS) &&
+      !usb_hid_autofire_capture_hand_over(capture)) {
+    capture->dropped++;
+    return;
+  }
+
+  capture->blocks[(capture->active * AUTOFIRE_CAPTURE_BLOCK_RECORDS) +
+                  capture->fill++] = (AutofireCaptureRecord){
+      .tick = tick,
+      .sequence = sequence,
+      .code = change->code,
+      .late_ms = (late_ms < AUTOFIRE_CAPTURE_LATE_MAX_MS)
+                     ? (uint16_t)late_ms
+                     : AUTOFIRE_CAPTURE_LATE_MAX_MS,
+      .channel = channel,
+      .flags = (change->press ? AutofireCaptureFlagPress : 0U) |
+               ((change->kind == AutofireTargetKindMouse)
+                    ? AutofireCaptureFlagMouse
+                    : 0U),
+  };
+  capture->records++;
+  if (capture->fill == AUTOFIRE_CAPTURE_BLOCK_RECORDS) {
+    usb_hid_autofire_capture_hand_over(capture);
+  }
+}
+
+// Puts a part-filled block on SD when firing stops, so a stop leaves the
+// run on the card.
+void usb_hid_autofire_capture_flush(AutofireCapture *capture) {
+  if (capture->thread && (capture->fill > 0U)) {
+    usb_hid_autofire_capture_hand_over(capture);
+  }
+}
@@ -0,0 +1,221 @@
+#include "usb_hid_autofire_i.h"
+
+// Delays the channel page steps through; a stored delay between two steps
+// moves on to the next larger one.
+static const uint32_t usb_hid_autofire_channel_delays_ms[] = {
+    50U,    100U,   200U,   500U,   1000U,   2000U,
+    5000U,  10000U, 30000U, 60000U, 300000U, AUTOFIRE_CHANNEL_DELAY_MAX_MS,
+};
+
+static const AutofireChannelConfig
+    usb_hid_autofire_channel_defaults_table[AUTOFIRE_EXTRA_CHANNEL_COUNT] = {
+        {0U, AutofireModeKeyboardSpace, 500U, AUTOFIRE_DUTY_DEFAULT_PERCENT},
+        {0U, AutofireModeKeyboardEnter, 30000U, AUTOFIRE_DUTY_DEFAULT_PERCENT},
+        {0U, AutofireModeMouseRightClick, 1000U,
+         AUTOFIRE_DUTY_DEFAULT_PERCENT},
+};
+
+void usb_hid_autofire_channel_defaults(AutofireChannelConfig *channels) {
+  memcpy(channels, usb_hid_autofire_channel_defaults_table,
+         sizeof(usb_hid_autofire_channel_defaults_table));
+}
+
+bool usb_hid_autofire_channel_is_valid(const AutofireChannelConfig *channel) {
+  return (channel->enabled <= 1U) &&
+         usb_hid_autofire_mode_is_valid(channel->mode) &&
+         (channel->delay_ms >= AUTOFIRE_DELAY_MIN_MS) &&
+         (channel->delay_ms <= AUTOFIRE_CHANNEL_DELAY_MAX_MS) &&
+         usb_hid_autofire_duty_is_valid(channel->duty_percent);
+}
+
+uint32_t usb_hid_autofire_channel_next_delay(uint32_t delay_ms) {
+  for (size_t i = 0; i < COUNT_OF(usb_hid_autofire_channel_delays_ms); i++) {
+    if (usb_hid_autofire_channel_delays_ms[i] > delay_ms) {
+      return usb_hid_autofire_channel_delays_ms[i];
+    }
+  }
+  return usb_hid_autofire_channel_delays_ms[0];
+}
+
+void usb_hid_autofire_format_channel_delay(char *out, size_t out_size,
+                                           uint32_t delay_ms) {
+  if ((delay_ms >= 60000U) && ((delay_ms % 60000U) == 0U)) {
+    snprintf(out, out_size, "%lumin", (unsigned long)(delay_ms / 60000U));
+  } else if ((delay_ms >= 1000U) && ((delay_ms % 1000U) == 0U)) {
+    snprintf(out, out_size, "%lus", (unsigned long)(delay_ms / 1000U));
+  } else {
+    snprintf(out, out_size, "%lums", (unsigned long)delay_ms);
+  }
+}
+
+// Slow channels tap: the hold is capped so a key fired every 30 s is not
+// held for 15 s and auto-repeated by the host.
+static uint32_t usb_hid_autofire_channel_hold_ticks(
+    const AutofireChannelConfig *config) {
+  uint32_t hold_ms =
+      usb_hid_autofire_hold_ms(config->delay_ms, config->duty_percent);
+  if (hold_ms > AUTOFIRE_CHANNEL_HOLD_MAX_MS) {
+    hold_ms = AUTOFIRE_CHANNEL_HOLD_MAX_MS;
+  }
+  return furi_ms_to_ticks(hold_ms);
+}
+
+static void usb_hid_autofire_channel_release(AutofireChannel *channel,
+                                             AutofireTransport *transport) {
+  if (channel->pressed) {
+    usb_hid_autofire_transport_send(transport, channel->kind,
+                                    channel->hid_code, false);
+    channel->pressed = false;
+  }
+  channel->click_phase = ClickPhasePress;
+}
+
+void usb_hid_autofire_channel_start(AutofireChannel *channel, uint32_t now) {
+  channel->click_phase = ClickPhasePress;
+  channel->next_at = now;
+  channel->clicks = 0U;
+}
+
+void usb_hid_autofire_channel_stop(AutofireChannel *channel,
+                                   AutofireTransport *transport) {
+  usb_hid_autofire_channel_release(channel, transport);
+}
+
+// Applies a new config. A running channel whose target or timing changed
+// lets go of its key and starts over on a fresh grid.
+void usb_hid_autofire_channel_configure(AutofireChannel *channel,
+                                        const AutofireChannelConfig *config,
+                                        uint16_t hid_code, bool active,
+                                        AutofireTransport *transport) {
+  AutofireTargetKind kind = usb_hid_autofire_target(config->mode)->kind;
+  bool changed =
+      (memcmp(config, &channel->config, sizeof(AutofireChannelConfig)) != 0) ||
+      (hid_code != channel->hid_code) || (kind != channel->kind);
+  if (!changed) {
+    return;
+  }
+
+  usb_hid_autofire_channel_release(channel, transport);
+  channel->config = *config;
+  channel->kind = kind;
+  channel->hid_code = hid_code;
+  if (active && config->enabled) {
+    usb_hid_autofire_channel_start(channel, furi_get_tick());
+  }
+}
+
+void usb_hid_autofire_channel_tick(AutofireChannel *channel,
+                                   AutofireHidBatch *batch) {
+  uint32_t hold_ticks = usb_hid_autofire_channel_hold_ticks(&channel->config);
+  uint32_t cycle_ticks = furi_ms_to_ticks(channel->config.delay_ms);
+
+  if (channel->click_phase == ClickPhasePress) {
+    usb_hid_autofire_hid_batch_add(batch, channel->kind, channel->hid_code,
+                                   true);
+    channel->pressed = true;
+    channel->next_at += hold_ticks;
+    channel->click_phase = ClickPhaseRelease;
+  } else {
+    usb_hid_autofire_hid_batch_add(batch, channel->kind, channel->hid_code,
+                                   false);
+    channel->pressed = false;
+    channel->clicks++;
+    channel->next_at += cycle_ticks - hold_ticks;
+    channel->click_phase = ClickPhasePress;
+
+    uint32_t late_ticks = furi_get_tick() - channel->next_at;
+    if ((int32_t)late_ticks >= (int32_t)cycle_ticks) {
+      channel->next_at += (late_ticks / cycle_ticks) * cycle_ticks;
+    }
+  }
+}
+
+static uint32_t usb_hid_autofire_channel_deadline(const AutofireEngine *engine,
+                                                  uint8_t channel) {
+  if ((channel == 0U) && engine->sequence_enabled) {
+    return engine->sequence.next_at;
+  }
+  if (channel == 0U) {
+    return (engine->click_phase == ClickPhasePress) ? engine->next_press_at
+                                                    : engine->next_release_at;
+  }
+  return engine->channels[channel - 1U].next_at;
+}
+
+static bool usb_hid_autofire_scheduler_before(const AutofireEngine *engine,
+                                              uint8_t a, uint8_t b) {
+  return (int32_t)(usb_hid_autofire_channel_deadline(engine, a) -
+                   usb_hid_autofire_channel_deadline(engine, b)) < 0;
+}
+
+void usb_hid_autofire_scheduler_push(AutofireEngine *engine, uint8_t channel) {
+  AutofireScheduler *scheduler = &engine->scheduler;
+  furi_check(scheduler->size < AUTOFIRE_CHANNEL_COUNT);
+
+  uint32_t index = scheduler->size++;
+  while (index > 0U) {
+    uint32_t parent = (index - 1U) / 2U;
+    if (!usb_hid_autofire_scheduler_before(engine, channel,
+                                           scheduler->heap[parent])) {
+      break;
+    }
+    scheduler->heap[index] = scheduler->heap[parent];
+    index = parent;
+  }
+  scheduler->heap[index] = channel;
+}
+
+uint8_t usb_hid_autofire_scheduler_pop(AutofireEngine *engine) {
+  AutofireScheduler *scheduler = &engine->scheduler;
+  furi_check(scheduler->size > 0U);
+
+  uint8_t top = scheduler->heap[0];
+  uint8_t last = scheduler->heap[--scheduler->size];
+  uint32_t index = 0U;
+  while (true) {
+    uint32_t child = (index * 2U) + 1U;
+    if (child >= scheduler->size) {
+      break;
+    }
+    if (((child + 1U) < scheduler->size) &&
+        usb_hid_autofire_scheduler_before(engine, scheduler->heap[child + 1U],
+                                          scheduler->heap[child])) {
+      child++;
+    }
+    if (!usb_hid_autofire_scheduler_before(engine, scheduler->heap[child],
+                                           last)) {
+      break;
+    }
+    scheduler->heap[index] = scheduler->heap[child];
+    index = child;
+  }
+  if (scheduler->size > 0U) {
+    scheduler->heap[index] = last;
+  }
+  return top;
+}
+
+bool usb_hid_autofire_scheduler_peek(const AutofireEngine *engine,
+                                     uint32_t *deadline) {
+  if (engine->scheduler.size == 0U) {
+    return false;
+  }
+  *deadline =
+      usb_hid_autofire_channel_deadline(engine, engine->scheduler.heap[0]);
+  return true;
+}
+
+// Refills the heap after a command changed which channels run or when.
+void usb_hid_autofire_scheduler_rebuild(AutofireEngine *engine) {
+  engine->scheduler.size = 0U;
+  if (!engine->active) {
+    return;
+  }
+
+  usb_hid_autofire_scheduler_push(engine, 0U);
+  for (uint8_t i = 0U; i < AUTOFIRE_EXTRA_CHANNEL_COUNT; i++) {
+    if (engine->channels[i].config.enabled) {
+      usb_hid_autofire_scheduler_push(engine, i + 1U);
+    }
+  }
+}
@@ -1,12 +1,16 @@
 #include "usb_hid_autofire_i.h"
 
 void usb_hid_autofire_input_callback(InputEvent *input_event, void *ctx) {
-  FuriMessageQueue *event_queue = ctx;
+  UsbHidAutofireApp *app = ctx;
+  usb_hid_autofire_input_log_record(&app->input_log, input_event);
+  if (input_event->key == InputKeyOk) {
+    usb_hid_autofire_hold_input(app, input_event->type);
+  }
 
   UsbMouseEvent event;
   event.type = EventTypeInput;
   event.input = *input_event;
-  furi_message_queue_put(event_queue, &event, 0);
+  usb_hid_autofire_post_event(app, &event);
 }
 
 uint32_t usb_hid_autofire_delay_clamp(uint32_t delay_ms) {
@@ -65,48 +69,102 @@ uint32_t usb_hid_autofire_accel_step_ms(uint16_t repeat_count) {
   return AUTOFIRE_DELAY_STEP_MS;
 }
 
-const char *usb_hid_autofire_mode_label(AutofireMode mode) {
-  switch (mode) {
-  case AutofireModeMouseLeftClick:
-    return "Mouse Left";
-  case AutofireModeMouseRightClick:
-    return "Mouse Right";
-  case AutofireModeKeyboardEnter:
-    return "Key Enter";
-  case AutofireModeKeyboardSpace:
-    return "Key Space";
-  default:
-    return "Unknown";
+uint32_t usb_hid_autofire_duty_clamp(uint32_t duty_percent) {
+  if (duty_percent < AUTOFIRE_DUTY_MIN_PERCENT) {
+    return AUTOFIRE_DUTY_MIN_PERCENT;
+  }
+  if (duty_percent > AUTOFIRE_DUTY_MAX_PERCENT) {
+    return AUTOFIRE_DUTY_MAX_PERCENT;
   }
+  return duty_percent;
 }
 
-AutofireMode usb_hid_autofire_next_mode(AutofireMode mode) {
-  switch (mode) {
-  case AutofireModeMouseLeftClick:
-    return AutofireModeMouseRightClick;
-  case AutofireModeMouseRightClick:
-    return AutofireModeKeyboardEnter;
-  case AutofireModeKeyboardEnter:
-    return AutofireModeKeyboardSpace;
-  case AutofireModeKeyboardSpace:
-  default:
-    return AutofireModeMouseLeftClick;
+// Press-hold part of one click cycle. Both the hold and the release gap stay
+// at least 1 ms, so the cycle always equals the configured delay.
+uint32_t usb_hid_autofire_hold_ms(uint32_t delay_ms, uint32_t duty_percent) {
+  uint32_t hold_ms = ((delay_ms * duty_percent) + 50U) / 100U;
+  if (hold_ms == 0U) {
+    hold_ms = 1U;
+  }
+  if (hold_ms >= delay_ms) {
+    hold_ms = (delay_ms > 1U) ? (delay_ms - 1U) : 1U;
   }
+  return hold_ms;
 }
 
-AutofireMode usb_hid_autofire_prev_mode(AutofireMode mode) {
-  switch (mode) {
-  case AutofireModeMouseLeftClick:
-    return AutofireModeKeyboardSpace;
-  case AutofireModeMouseRightClick:
-    return AutofireModeMouseLeftClick;
-  case AutofireModeKeyboardEnter:
-    return AutofireModeMouseRightClick;
-  case AutofireModeKeyboardSpace:
-    return AutofireModeKeyboardEnter;
-  default:
-    return AutofireModeMouseLeftClick;
+static uint32_t usb_hid_autofire_round_up(uint32_t value, uint32_t step) {
+  return ((value + step - 1U) / step) * step;
+}
+
+// Splits one click cycle into press hold and release gap. Frame alignment
+// rounds each phase up to whole poll intervals so the host sees every
+// state at least once, which can stretch the cycle past the delay.
+void usb_hid_autofire_phase_ms(uint32_t delay_ms, uint32_t duty_percent,
+                               uint32_t frame_align_ms, uint32_t *hold_ms,
+                               uint32_t *gap_ms) {
+  *hold_ms = usb_hid_autofire_hold_ms(delay_ms, duty_percent);
+  *gap_ms = delay_ms - *hold_ms;
+  if (frame_align_ms > 0U) {
+    *hold_ms = usb_hid_autofire_round_up(*hold_ms, frame_align_ms);
+    *gap_ms = usb_hid_autofire_round_up(*gap_ms, frame_align_ms);
+  }
+}
+
+// One press and one release poll per click is the best the host can see.
+uint32_t usb_hid_autofire_max_lossless_cps_x10(uint32_t poll_ms) {
+  return usb_hid_autofire_config_cps_x10_for_delay(2U * poll_ms);
+}
+
+uint32_t usb_hid_autofire_next_frame_align(uint32_t frame_align_ms) {
+  if (frame_align_ms == 0U) {
+    return 1U;
   }
+  if ((frame_align_ms * 2U) > AUTOFIRE_FRAME_ALIGN_MAX_MS) {
+    return 0U;
+  }
+  return frame_align_ms * 2U;
+}
+
+// Steps the options screen cycles through; a stored value between two
+// steps moves on to the next larger one, and the last wraps to off.
+static const uint32_t usb_hid_autofire_burst_counts[] = {
+    1U, 2U, 3U, 5U, 10U, 20U, 50U, 100U, 200U, 500U, 1000U,
+};
+
+static const uint32_t usb_hid_autofire_burst_intervals_ms[] = {
+    100U, 250U, 500U, 1000U, 2000U, 5000U, 10000U, 30000U, 60000U,
+};
+
+static uint32_t usb_hid_autofire_next_step(const uint32_t *steps, size_t count,
+                                           uint32_t value) {
+  for (size_t i = 0; i < count; i++) {
+    if (steps[i] > value) {
+      return steps[i];
+    }
+  }
+  return 0U;
+}
+
+uint32_t usb_hid_autofire_next_burst_count(uint32_t burst_count) {
+  return usb_hid_autofire_next_step(usb_hid_autofire_burst_counts,
+                                    COUNT_OF(usb_hid_autofire_burst_counts),
+                                    burst_count);
+}
+
+uint32_t usb_hid_autofire_next_burst_interval(uint32_t interval_ms) {
+  return usb_hid_autofire_next_step(
+      usb_hid_autofire_burst_intervals_ms,
+      COUNT_OF(usb_hid_autofire_burst_intervals_ms), interval_ms);
+}
+
+uint32_t usb_hid_autofire_target_cps_clamp(uint32_t target_cps_x10) {
+  if (target_cps_x10 < AUTOFIRE_TARGET_CPS_MIN_X10) {
+    return AUTOFIRE_TARGET_CPS_MIN_X10;
+  }
+  if (target_cps_x10 > AUTOFIRE_TARGET_CPS_MAX_X10) {
+    return AUTOFIRE_TARGET_CPS_MAX_X10;
+  }
+  return target_cps_x10;
 }
 
 const char *usb_hid_autofire_preset_label(AutofirePreset preset) {
@@ -152,8 +210,17 @@ AutofirePreset usb_hid_autofire_next_preset(AutofirePreset preset) {
   }
 }
 
-bool usb_hid_autofire_mode_is_valid(uint32_t mode_value) {
-  return mode_value <= (uint32_t)AutofireModeKeyboardSpace;
+const char *usb_hid_autofire_late_policy_label(AutofireLatePolicy late_policy) {
+  switch (late_policy) {
+  case AutofireLatePolicyCatchUp:
+    return "Catch up";
+  case AutofireLatePolicySkip:
+    return "Skip";
+  case AutofireLatePolicySlide:
+    return "Slide";
+  default:
+    return "Unknown";
+  }
 }
 
 bool usb_hid_autofire_preset_is_valid(uint32_t preset_value) {
@@ -165,24 +232,72 @@ bool usb_hid_autofire_startup_policy_is_valid(uint32_t startup_policy_value) {
          (uint32_t)AutofireStartupPolicyRestoreLastState;
 }
 
+bool usb_hid_autofire_late_policy_is_valid(uint32_t late_policy_value) {
+  return late_policy_value < (uint32_t)AutofireLatePolicyCount;
+}
+
+bool usb_hid_autofire_duty_is_valid(uint32_t duty_percent) {
+  return (duty_percent >= AUTOFIRE_DUTY_MIN_PERCENT) &&
+         (duty_percent <= AUTOFIRE_DUTY_MAX_PERCENT);
+}
+
+bool usb_hid_autofire_frame_align_is_valid(uint32_t frame_align_ms) {
+  return (frame_align_ms <= AUTOFIRE_FRAME_ALIGN_MAX_MS) &&
+         ((frame_align_ms & (frame_align_ms - 1U)) == 0U);
+}
+
+bool usb_hid_autofire_target_cps_is_valid(uint32_t target_cps_x10) {
+  return (target_cps_x10 == 0U) ||
+         ((target_cps_x10 >= AUTOFIRE_TARGET_CPS_MIN_X10) &&
+          (target_cps_x10 <= AUTOFIRE_TARGET_CPS_MAX_X10));
+}
+
+bool usb_hid_autofire_burst_count_is_valid(uint32_t burst_count) {
+  return burst_count <= AUTOFIRE_BURST_MAX_CLICKS;
+}
+
+bool usb_hid_autofire_burst_interval_is_valid(uint32_t interval_ms) {
+  return interval_ms <= AUTOFIRE_CHANNEL_DELAY_MAX_MS;
+}
+
 bool usb_hid_autofire_set_mode(UsbHidAutofireApp *app, AutofireMode new_mode) {
   if (new_mode == app->mode) {
     return false;
   }
 
-  if (app->mouse_pressed) {
-    usb_hid_autofire_release_mode_control(app);
-    app->mouse_pressed = false;
+  app->mode = new_mode;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewMode | AutofireViewPage);
+
+  return true;
+}
+
+bool usb_hid_autofire_set_key_code(UsbHidAutofireApp *app, uint32_t key_code) {
+  if ((key_code == app->key_code) ||
+      !usb_hid_autofire_key_code_is_valid(key_code)) {
+    return false;
   }
 
-  app->mode = new_mode;
-  app->click_phase = ClickPhasePress;
-  if (app->active) {
-    furi_timer_stop(app->click_timer);
-    usb_hid_autofire_schedule_next_tick(app);
+  app->key_code = key_code;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewMode | AutofireViewPage);
+
+  return true;
+}
+
+bool usb_hid_autofire_set_key_modifiers(UsbHidAutofireApp *app,
+                                        uint32_t key_modifiers) {
+  if ((key_modifiers == app->key_modifiers) ||
+      !usb_hid_autofire_key_modifiers_is_valid(key_modifiers)) {
+    return false;
   }
+
+  app->key_modifiers = key_modifiers;
+  usb_hid_autofire_send_config(app);
   usb_hid_autofire_mark_settings_dirty(app);
-  app->ui_dirty = true;
+  usb_hid_autofire_view_invalidate(app, AutofireViewMode | AutofireViewPage);
 
   return true;
 }
@@ -197,18 +312,94 @@ bool usb_hid_autofire_set_delay(UsbHidAutofireApp *app, uint32_t new_delay_ms,
   bool delay_changed = (new_delay_ms != app->autofire_delay_ms);
   app->autofire_delay_ms = new_delay_ms;
   app->preset = new_preset;
-  if (app->active && delay_changed) {
-    furi_timer_stop(app->click_timer);
-    usb_hid_autofire_schedule_next_tick(app);
+  if (delay_changed) {
+    usb_hid_autofire_send_config(app);
+  }
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(
+      app, AutofireViewPreset | AutofireViewRate | AutofireViewPage);
+
+  return true;
+}
+
+bool usb_hid_autofire_set_duty(UsbHidAutofireApp *app, uint32_t duty_percent) {
+  duty_percent = usb_hid_autofire_duty_clamp(duty_percent);
+  if (duty_percent == app->duty_percent) {
+    return false;
+  }
+
+  app->duty_percent = duty_percent;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+
+  return true;
+}
+
+bool usb_hid_autofire_set_late_policy(UsbHidAutofireApp *app,
+                                      AutofireLatePolicy late_policy) {
+  if (late_policy == app->late_policy) {
+    return false;
+  }
+
+  app->late_policy = late_policy;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+
+  return true;
+}
+
+bool usb_hid_autofire_set_frame_align(UsbHidAutofireApp *app,
+                                      uint32_t frame_align_ms) {
+  if ((frame_align_ms == app->frame_align_ms) ||
+      !usb_hid_autofire_frame_align_is_valid(frame_align_ms)) {
+    return false;
   }
+
+  app->frame_align_ms = frame_align_ms;
+  usb_hid_autofire_send_config(app);
   usb_hid_autofire_mark_settings_dirty(app);
-  app->ui_dirty = true;
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
 
   return true;
 }
 
+// Zero switches back to the open-loop delay.
+bool usb_hid_autofire_set_target_cps(UsbHidAutofireApp *app,
+                                     uint32_t target_cps_x10) {
+  if (target_cps_x10 > 0U) {
+    target_cps_x10 = usb_hid_autofire_target_cps_clamp(target_cps_x10);
+  }
+  if (target_cps_x10 == app->target_cps_x10) {
+    return false;
+  }
+
+  app->target_cps_x10 = target_cps_x10;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewRate | AutofireViewPage);
+
+  return true;
+}
+
+// In target mode the delay steps become 0.1, 0.5 and 1.0 CPS steps, with
+// Right raising the target like it raises the delay.
 void usb_hid_autofire_adjust_delay(UsbHidAutofireApp *app, InputKey key,
                                    uint32_t step_ms) {
+  if (app->target_cps_x10 > 0U) {
+    uint32_t step_x10 = step_ms / 10U;
+    if (key == InputKeyLeft) {
+      usb_hid_autofire_set_target_cps(
+          app, (app->target_cps_x10 > step_x10)
+                   ? (app->target_cps_x10 - step_x10)
+                   : AUTOFIRE_TARGET_CPS_MIN_X10);
+    } else if (key == InputKeyRight) {
+      usb_hid_autofire_set_target_cps(app, app->target_cps_x10 + step_x10);
+    }
+    return;
+  }
+
   if (key == InputKeyLeft) {
     usb_hid_autofire_set_delay(
         app, usb_hid_autofire_delay_decrease(app->autofire_delay_ms, step_ms),
@@ -273,11 +464,315 @@ void usb_hid_autofire_apply_preset_request(UsbHidAutofireApp *app,
 
   if (should_apply) {
     usb_hid_autofire_set_delay(app, preset_delay_ms, preset);
+    if (app->target_cps_x10 > 0U) {
+      usb_hid_autofire_set_target_cps(app, preset_cps_x10);
+    }
   }
 
   if (was_active) {
     usb_hid_autofire_start(app);
-    app->ui_dirty = true;
+    usb_hid_autofire_view_invalidate(app, AutofireViewStatus);
+  }
+}
+
+void usb_hid_autofire_set_screen(UsbHidAutofireApp *app,
+                                 AutofireScreen screen) {
+  if (screen == app->screen) {
+    return;
+  }
+
+  app->screen = screen;
+  usb_hid_autofire_update_hold_armed(app);
+  if (screen == AutofireScreenStats) {
+    usb_hid_autofire_refresh_trace_stats(app);
+  } else if (screen == AutofireScreenBench) {
+    usb_hid_autofire_refresh_rate_stats(app);
+  }
+  usb_hid_autofire_view_invalidate(app, AutofireViewAll);
+}
+
+static void usb_hid_autofire_change_option(UsbHidAutofireApp *app) {
+  switch (app->option) {
+  case AutofireOptionTarget:
+    usb_hid_autofire_set_target_cps(
+        app, (app->target_cps_x10 > 0U)
+                 ? 0U
+                 : usb_hid_autofire_config_cps_x10_for_delay(
+                       app->autofire_delay_ms));
+    break;
+  case AutofireOptionDuty: {
+    uint32_t duty_percent = app->duty_percent + AUTOFIRE_DUTY_STEP_PERCENT;
+    if (duty_percent > AUTOFIRE_DUTY_MAX_PERCENT) {
+      duty_percent = AUTOFIRE_DUTY_MIN_PERCENT;
+    }
+    usb_hid_autofire_set_duty(app, duty_percent);
+    break;
+  }
+  case AutofireOptionLatePolicy:
+    usb_hid_autofire_set_late_policy(
+        app, (AutofireLatePolicy)((app->late_policy + 1U) %
+                                  AutofireLatePolicyCount));
+    break;
+  case AutofireOptionFrameAlign:
+    usb_hid_autofire_set_frame_align(
+        app, usb_hid_autofire_next_frame_align(app->frame_align_ms));
+    break;
+  case AutofireOptionKeyCode:
+    usb_hid_autofire_set_key_code(app, (app->key_code < AUTOFIRE_KEY_CODE_MAX)
+                                           ? (app->key_code + 1U)
+                                           : AUTOFIRE_KEY_CODE_MIN);
+    break;
+  case AutofireOptionKeyModifiers:
+    usb_hid_autofire_set_key_modifiers(
+        app, (app->key_modifiers + 1U) & AUTOFIRE_KEY_MODIFIERS_MASK);
+    break;
+  case AutofireOptionSequence:
+    usb_hid_autofire_set_sequence_enabled(app, !app->sequence_enabled);
+    break;
+  case AutofireOptionBurst:
+    usb_hid_autofire_set_burst(
+        app, usb_hid_autofire_next_burst_count(app->burst_count),
+        app->burst_interval_ms);
+    break;
+  case AutofireOptionBurstInterval:
+    usb_hid_autofire_set_burst(
+        app, app->burst_count,
+        usb_hid_autofire_next_burst_interval(app->burst_interval_ms));
+    break;
+  case AutofireOptionTrigger:
+    usb_hid_autofire_set_hold_to_fire(app, !app->hold_to_fire);
+    break;
+  case AutofireOptionTransport:
+    usb_hid_autofire_set_transport(
+        app, (AutofireTransportType)((app->transport_type + 1U) %
+                                     AutofireTransportCount));
+    break;
+  case AutofireOptionCapture:
+    usb_hid_autofire_set_capture(app, !app->capture_enabled);
+    break;
+  case AutofireOptionInputLog:
+    usb_hid_autofire_set_input_log(app, !app->input_log_enabled);
+    break;
+  default:
+    break;
+  }
+}
+
+bool usb_hid_autofire_set_channel(UsbHidAutofireApp *app, uint32_t index,
+                                  const AutofireChannelConfig *config) {
+  if ((index >= AUTOFIRE_EXTRA_CHANNEL_COUNT) ||
+      !usb_hid_autofire_channel_is_valid(config) ||
+      (memcmp(config, &app->channels[index], sizeof(AutofireChannelConfig)) ==
+       0)) {
+    return false;
+  }
+
+  app->channels[index] = *config;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+  return true;
+}
+
+bool usb_hid_autofire_set_sequence_enabled(UsbHidAutofireApp *app,
+                                           bool enabled) {
+  if ((enabled == app->sequence_enabled) ||
+      (enabled && (app->sequence.count == 0U))) {
+    return false;
+  }
+
+  app->sequence_enabled = enabled;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(
+      app, AutofireViewStatus | AutofireViewMode | AutofireViewPage);
+  return true;
+}
+
+// A count of zero fires until stopped; an interval of zero stops after one
+// burst.
+bool usb_hid_autofire_set_burst(UsbHidAutofireApp *app, uint32_t burst_count,
+                                uint32_t interval_ms) {
+  if (!usb_hid_autofire_burst_count_is_valid(burst_count) ||
+      !usb_hid_autofire_burst_interval_is_valid(interval_ms) ||
+      ((burst_count == app->burst_count) &&
+       (interval_ms == app->burst_interval_ms))) {
+    return false;
+  }
+
+  app->burst_count = burst_count;
+  app->burst_interval_ms = interval_ms;
+  usb_hid_autofire_send_config(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewStatus | AutofireViewPage);
+  return true;
+}
+
+// The worker already stopped firing after the last click of the burst;
+// this brings the app state in line as if OK had been pressed.
+void usb_hid_autofire_handle_burst_done(UsbHidAutofireApp *app) {
+  if (!app->active || !usb_hid_autofire_burst_finished(app)) {
+    return;
+  }
+
+  usb_hid_autofire_stop(app);
+  app->last_active_state = false;
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewStatus | AutofireViewPage);
+}
+
+void usb_hid_autofire_update_hold_armed(UsbHidAutofireApp *app) {
+  __atomic_store_n(&app->hold_armed,
+                   app->hold_to_fire && (app->screen == AutofireScreenMain),
+                   __ATOMIC_RELEASE);
+}
+
+// Switching modes while firing stops first, so a toggled run cannot be
+// left without a key to end it and a hold cannot outlive its mode.
+bool usb_hid_autofire_set_hold_to_fire(UsbHidAutofireApp *app, bool enabled) {
+  if (enabled == app->hold_to_fire) {
+    return false;
+  }
+
+  if (app->active) {
+    usb_hid_autofire_stop(app);
+    app->last_active_state = false;
+  }
+  app->hold_to_fire = enabled;
+  usb_hid_autofire_update_hold_armed(app);
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewStatus | AutofireViewPage);
+  return true;
+}
+
+// Only saved here: the transport is opened at launch, and reopening it
+// under a running worker would pull the HID out from under a click.
+bool usb_hid_autofire_set_transport(UsbHidAutofireApp *app,
+                                    AutofireTransportType type) {
+  if (!usb_hid_autofire_transport_is_valid(type) ||
+      (type == app->transport_type)) {
+    return false;
+  }
+
+  app->transport_type = type;
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+  return true;
+}
+
+// Applies on the next launch like the transport: the buffers and the writer
+// are set up before the click worker starts.
+bool usb_hid_autofire_set_capture(UsbHidAutofireApp *app, bool enabled) {
+  if (enabled == app->capture_enabled) {
+    return false;
+  }
+
+  app->capture_enabled = enabled;
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+  return true;
+}
+
+// Applies on the next launch, so a log always starts with the settings the
+// app launched with.
+bool usb_hid_autofire_set_input_log(UsbHidAutofireApp *app, bool enabled) {
+  if (enabled == app->input_log_enabled) {
+    return false;
+  }
+
+  app->input_log_enabled = enabled;
+  usb_hid_autofire_mark_settings_dirty(app);
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+  return true;
+}
+
+static void usb_hid_autofire_change_channel_field(UsbHidAutofireApp *app) {
+  uint32_t index = app->channel_cursor / AutofireChannelFieldCount;
+  AutofireChannelConfig config = app->channels[index];
+
+  switch (app->channel_cursor % AutofireChannelFieldCount) {
+  case AutofireChannelFieldEnabled:
+    config.enabled = config.enabled ? 0U : 1U;
+    break;
+  case AutofireChannelFieldTarget:
+    config.mode = usb_hid_autofire_next_mode((AutofireMode)config.mode);
+    break;
+  case AutofireChannelFieldDelay:
+    config.delay_ms = usb_hid_autofire_channel_next_delay(config.delay_ms);
+    break;
+  case AutofireChannelFieldDuty:
+    config.duty_percent += AUTOFIRE_DUTY_STEP_PERCENT;
+    if (config.duty_percent > AUTOFIRE_DUTY_MAX_PERCENT) {
+      config.duty_percent = AUTOFIRE_DUTY_MIN_PERCENT;
+    }
+    break;
+  default:
+    break;
+  }
+  usb_hid_autofire_set_channel(app, index, &config);
+}
+
+static void usb_hid_autofire_move_channel_cursor(UsbHidAutofireApp *app,
+                                                 bool forward) {
+  const uint32_t count =
+      AUTOFIRE_EXTRA_CHANNEL_COUNT * AutofireChannelFieldCount;
+  app->channel_cursor =
+      (app->channel_cursor + (forward ? 1U : (count - 1U))) % count;
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+}
+
+void usb_hid_autofire_handle_info_input(UsbHidAutofireApp *app,
+                                        const InputEvent *input) {
+  // Holding OK scrolls through the key codes.
+  if ((input->type == InputTypeRepeat) && (input->key == InputKeyOk) &&
+      (app->screen == AutofireScreenOptions) &&
+      (app->option == AutofireOptionKeyCode)) {
+    usb_hid_autofire_change_option(app);
+    return;
+  }
+
+  if (input->type != InputTypeShort) {
+    return;
+  }
+
+  switch (input->key) {
+  case InputKeyLeft:
+    usb_hid_autofire_set_screen(app, (app->screen == AutofireScreenHelp)
+                                         ? AUTOFIRE_SCREEN_LAST
+                                         : (AutofireScreen)(app->screen - 1U));
+    break;
+
+  case InputKeyRight:
+    usb_hid_autofire_set_screen(app, (app->screen == AUTOFIRE_SCREEN_LAST)
+                                         ? AutofireScreenHelp
+                                         : (AutofireScreen)(app->screen + 1U));
+    break;
+
+  case InputKeyUp:
+  case InputKeyDown:
+    if (app->screen == AutofireScreenOptions) {
+      app->option = (AutofireOption)((app->option + 1U) % AutofireOptionCount);
+      usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+    } else if (app->screen == AutofireScreenChannels) {
+      usb_hid_autofire_move_channel_cursor(app, input->key == InputKeyDown);
+    }
+    break;
+
+  case InputKeyOk:
+    if (app->screen == AutofireScreenStats) {
+      app->trace_export_result = usb_hid_autofire_export_trace(app)
+                                     ? AutofireExportResultOk
+                                     : AutofireExportResultFailed;
+      usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+    } else if (app->screen == AutofireScreenOptions) {
+      usb_hid_autofire_change_option(app);
+    } else if (app->screen == AutofireScreenChannels) {
+      usb_hid_autofire_change_channel_field(app);
+    }
+    break;
+
+  default:
+    break;
   }
 }
 
@@ -368,12 +863,13 @@ bool usb_hid_autofire_handle_input_event(UsbHidAutofireApp *app,
                                          bool *should_exit) {
   furi_check(should_exit);
   *should_exit = false;
+  app->ui_last_input_tick = furi_get_tick();
+  app->ui_quiet_refreshes = 0U;
 
   if (input->key == InputKeyBack) {
     if (input->type == InputTypeLong) {
-      app->show_help = true;
+      usb_hid_autofire_set_screen(app, AutofireScreenHelp);
       app->back_long_handled = true;
-      app->ui_dirty = true;
       return true;
     }
 
@@ -382,9 +878,8 @@ bool usb_hid_autofire_handle_input_event(UsbHidAutofireApp *app,
         app->back_long_handled = false;
         return true;
       }
-      if (app->show_help) {
-        app->show_help = false;
-        app->ui_dirty = true;
+      if (app->screen != AutofireScreenMain) {
+        usb_hid_autofire_set_screen(app, AutofireScreenMain);
         return true;
       }
       *should_exit = true;
@@ -392,7 +887,20 @@ bool usb_hid_autofire_handle_input_event(UsbHidAutofireApp *app,
     }
   }
 
-  if (app->show_help) {
+  // Fires while held; long presses and repeats are part of the hold. A
+  // hold that left the main screen still ends on its release.
+  if ((input->key == InputKeyOk) && app->hold_to_fire &&
+      ((app->screen == AutofireScreenMain) || app->active)) {
+    if ((input->type == InputTypePress) ||
+        (input->type == InputTypeRelease)) {
+      usb_hid_autofire_hold_changed(app, input->type == InputTypePress);
+      usb_hid_autofire_view_invalidate(app, AutofireViewStatus);
+    }
+    return true;
+  }
+
+  if (app->screen != AutofireScreenMain) {
+    usb_hid_autofire_handle_info_input(app, input);
     return true;
   }
 
@@ -421,7 +929,7 @@ bool usb_hid_autofire_handle_input_event(UsbHidAutofireApp *app,
         app->last_active_state = true;
         usb_hid_autofire_mark_settings_dirty(app);
       }
-      app->ui_dirty = true;
+      usb_hid_autofire_view_invalidate(app, AutofireViewStatus);
     }
   }
 
@@ -1,15 +1,43 @@
 #include "usb_hid_autofire_i.h"
 
-void usb_hid_autofire_timer_callback(void *ctx) {
-  UsbHidAutofireApp *app = ctx;
-  UsbMouseEvent event = {.type = EventTypeTick};
-  furi_message_queue_put(app->event_queue, &event, 0);
-}
-
 void usb_hid_autofire_ui_timer_callback(void *ctx) {
   UsbHidAutofireApp *app = ctx;
   UsbMouseEvent event = {.type = EventTypeUiRefresh};
-  furi_message_queue_put(app->event_queue, &event, 0);
+  usb_hid_autofire_post_event(app, &event);
+}
+
+// Posts without blocking, since callers run in timer and input context.
+// Coalesced types are skipped while a copy is still queued; a failed post
+// is counted and clears the pending bit so the next attempt can retry.
+bool usb_hid_autofire_post_event(UsbHidAutofireApp *app,
+                                 const UsbMouseEvent *event) {
+  uint32_t bit = 1UL << event->type;
+  bool coalesced = (bit & EVENT_COALESCED_MASK) != 0U;
+  if (coalesced &&
+      (__atomic_fetch_or(&app->event_pending, bit, __ATOMIC_ACQ_REL) & bit)) {
+    return true;
+  }
+
+  if (furi_message_queue_put(app->event_queue, event, 0) == FuriStatusOk) {
+    return true;
+  }
+
+  if (coalesced) {
+    __atomic_fetch_and(&app->event_pending, ~bit, __ATOMIC_ACQ_REL);
+  }
+  __atomic_fetch_add(&app->event_drops[event->type], 1U, __ATOMIC_RELAXED);
+  return false;
+}
+
+FuriStatus usb_hid_autofire_get_event(UsbHidAutofireApp *app,
+                                      UsbMouseEvent *event, uint32_t timeout) {
+  FuriStatus status =
+      furi_message_queue_get(app->event_queue, event, timeout);
+  if (status == FuriStatusOk) {
+    __atomic_fetch_and(&app->event_pending, ~(1UL << event->type),
+                       __ATOMIC_ACQ_REL);
+  }
+  return status;
 }
 
 void usb_hid_autofire_format_cps(char *out, size_t out_size, uint32_t cps_x10) {
@@ -17,148 +45,365 @@ void usb_hid_autofire_format_cps(char *out, size_t out_size, uint32_t cps_x10) {
            (unsigned long)(cps_x10 % 10U));
 }
 
+// One click cycle is the full delay: hold plus release gap.
 uint32_t usb_hid_autofire_config_cps_x10_for_delay(uint32_t delay_ms) {
-  uint32_t half_delay_ms = delay_ms / 2U;
-  if (half_delay_ms == 0U) {
-    half_delay_ms = 1U;
-  }
-
-  uint32_t cycle_ms = half_delay_ms * 2U;
+  uint32_t cycle_ms = (delay_ms > 1U) ? delay_ms : 2U;
   return (10000U + (cycle_ms / 2U)) / cycle_ms;
 }
 
-static uint32_t
-usb_hid_autofire_effective_cycle_ms(const UsbHidAutofireApp *app) {
-  uint32_t half_delay_ms = app->autofire_delay_ms / 2U;
-  if (half_delay_ms == 0U) {
-    half_delay_ms = 1U;
-  }
-  return half_delay_ms * 2U;
-}
-
 void usb_hid_autofire_reset_cps_tracking(UsbHidAutofireApp *app) {
-  app->realtime_cps_x10 = 0U;
-  app->last_click_release_tick_ms = 0U;
-  app->last_click_interval_ms = usb_hid_autofire_effective_cycle_ms(app);
+  app->engine.last_click_release_tick_ms = 0U;
+  usb_hid_autofire_cps_window_reset(&app->engine.cps_window);
 }
 
 static void usb_hid_autofire_record_click_release(UsbHidAutofireApp *app) {
+  AutofireEngine *engine = &app->engine;
   uint32_t now_ms = furi_get_tick();
-  if (app->last_click_release_tick_ms != 0U) {
-    uint32_t interval_ms = now_ms - app->last_click_release_tick_ms;
+  if (engine->last_click_release_tick_ms != 0U) {
+    uint32_t interval_ms = now_ms - engine->last_click_release_tick_ms;
     if (interval_ms == 0U) {
       interval_ms = 1U;
     }
-    app->last_click_interval_ms = interval_ms;
+    usb_hid_autofire_cps_window_push(&engine->cps_window, interval_ms);
+    usb_hid_autofire_rate_record_interval(&engine->rate, interval_ms, now_ms);
   }
-  app->last_click_release_tick_ms = now_ms;
+  engine->last_click_release_tick_ms = now_ms;
 }
 
-uint32_t usb_hid_autofire_realtime_cps_x10(const UsbHidAutofireApp *app) {
-  if (!app->active || (app->last_click_release_tick_ms == 0U) ||
-      (app->last_click_interval_ms == 0U)) {
-    return 0U;
-  }
+// Divides on the UI refresh, so the worker only keeps the window sums. A
+// release tick of 0 means no click yet or a burst pause, neither of which
+// ages the rate.
+void usb_hid_autofire_realtime_cps_x10(UsbHidAutofireApp *app,
+                                       uint32_t *short_x10,
+                                       uint32_t *long_x10) {
+  const AutofireEngine *engine = &app->engine;
+  furi_mutex_acquire(app->engine_mutex, FuriWaitForever);
+  uint32_t release_ms = engine->last_click_release_tick_ms;
+  uint32_t open_ms = (release_ms != 0U) ? (furi_get_tick() - release_ms) : 0U;
+  *short_x10 =
+      usb_hid_autofire_cps_window_cps_x10(&engine->cps_window, false, open_ms);
+  *long_x10 =
+      usb_hid_autofire_cps_window_cps_x10(&engine->cps_window, true, open_ms);
+  furi_mutex_release(app->engine_mutex);
+}
 
-  uint32_t elapsed_ms = furi_get_tick() - app->last_click_release_tick_ms;
-  uint32_t effective_interval_ms = app->last_click_interval_ms;
-  if (elapsed_ms > effective_interval_ms) {
-    effective_interval_ms = elapsed_ms;
-  }
-  if (effective_interval_ms == 0U) {
-    effective_interval_ms = 1U;
+// With a target rate the cycle is the rate controller's corrected period;
+// the delay is only the last manual setting then.
+static uint32_t usb_hid_autofire_cycle_ms(const AutofireEngine *engine) {
+  return (engine->target_cps_x10 > 0U)
+             ? usb_hid_autofire_rate_cycle_ms(&engine->rate)
+             : engine->delay_ms;
+}
+
+static uint32_t usb_hid_autofire_hold_ticks(const AutofireEngine *engine) {
+  uint32_t hold_ms;
+  uint32_t gap_ms;
+  usb_hid_autofire_phase_ms(usb_hid_autofire_cycle_ms(engine),
+                            engine->duty_percent, engine->frame_align_ms,
+                            &hold_ms, &gap_ms);
+  return furi_ms_to_ticks(hold_ms);
+}
+
+static uint32_t usb_hid_autofire_gap_ticks(const AutofireEngine *engine) {
+  uint32_t hold_ms;
+  uint32_t gap_ms;
+  usb_hid_autofire_phase_ms(usb_hid_autofire_cycle_ms(engine),
+                            engine->duty_percent, engine->frame_align_ms,
+                            &hold_ms, &gap_ms);
+  return furi_ms_to_ticks(gap_ms);
+}
+
+static uint32_t usb_hid_autofire_cycle_ticks(const AutofireEngine *engine) {
+  return usb_hid_autofire_hold_ticks(engine) +
+         usb_hid_autofire_gap_ticks(engine);
+}
+
+// Starts a new click cycle and returns its hold. With a target rate the
+// cycle length comes from the rate controller, otherwise from the delay.
+static uint32_t usb_hid_autofire_begin_cycle(AutofireEngine *engine) {
+  if (engine->target_cps_x10 == 0U) {
+    engine->cycle_gap_ticks = usb_hid_autofire_gap_ticks(engine);
+    return usb_hid_autofire_hold_ticks(engine);
   }
 
-  return (10000U + (effective_interval_ms / 2U)) / effective_interval_ms;
+  uint32_t hold_ms;
+  uint32_t gap_ms;
+  uint32_t cycle_ms =
+      usb_hid_autofire_rate_next_cycle_ms(&engine->rate, true);
+  usb_hid_autofire_phase_ms(cycle_ms, engine->duty_percent,
+                            engine->frame_align_ms, &hold_ms, &gap_ms);
+  engine->cycle_gap_ticks = furi_ms_to_ticks(gap_ms);
+  return furi_ms_to_ticks(hold_ms);
+}
+
+// The controller tracks the measured rate in both modes so the bench page
+// works for plain delays too; only a target rate applies its correction.
+static void usb_hid_autofire_reset_rate(AutofireEngine *engine) {
+  uint32_t period_q8;
+  if (engine->target_cps_x10 > 0U) {
+    period_q8 = (uint32_t)(((10000ULL << 8) + (engine->target_cps_x10 / 2U)) /
+                           engine->target_cps_x10);
+  } else {
+    period_q8 = usb_hid_autofire_cycle_ticks(engine) << 8;
+  }
+  usb_hid_autofire_rate_reset(&engine->rate, period_q8, furi_get_tick());
 }
 
+// Moves a missed deadline according to the late policy. Catch up keeps the
+// original grid so the missed phases fire back to back, skip drops whole
+// missed cycles, and slide re-bases the grid on the current tick.
 static uint32_t
-usb_hid_autofire_half_delay_ticks(const UsbHidAutofireApp *app) {
-  uint32_t half_delay_ms = app->autofire_delay_ms / 2;
-  if (half_delay_ms == 0) {
-    half_delay_ms = 1;
+usb_hid_autofire_apply_late_policy(const AutofireEngine *engine,
+                                   uint32_t deadline, uint32_t now) {
+  uint32_t late_ticks = now - deadline;
+  uint32_t cycle_ticks = usb_hid_autofire_cycle_ticks(engine);
+
+  switch (engine->late_policy) {
+  case AutofireLatePolicyCatchUp:
+    if (late_ticks < (cycle_ticks * AUTOFIRE_CATCH_UP_MAX_CYCLES)) {
+      return deadline;
+    }
+    return now;
+  case AutofireLatePolicySkip:
+    return deadline + (((late_ticks / cycle_ticks) + 1U) * cycle_ticks);
+  case AutofireLatePolicySlide:
+  default:
+    return now;
   }
-  return furi_ms_to_ticks(half_delay_ms);
+}
+
+// Frame-aligned mode moves a deadline onto the next poll boundary, and at
+// least one poll after the previous state change, so two changes never
+// share a poll window even when catching up.
+static uint32_t usb_hid_autofire_align_deadline(const AutofireEngine *engine,
+                                                uint32_t deadline) {
+  uint32_t poll_ticks = furi_ms_to_ticks(engine->frame_align_ms);
+  if (poll_ticks == 0U) {
+    return deadline;
+  }
+
+  uint32_t earliest = engine->last_transition_tick + poll_ticks;
+  if ((int32_t)(deadline - earliest) < 0) {
+    deadline = earliest;
+  }
+  uint32_t offset = deadline % poll_ticks;
+  return (offset == 0U) ? deadline : (deadline + (poll_ticks - offset));
+}
+
+static uint32_t *usb_hid_autofire_next_deadline(AutofireEngine *engine) {
+  return (engine->click_phase == ClickPhasePress) ? &engine->next_press_at
+                                                  : &engine->next_release_at;
 }
 
 void usb_hid_autofire_schedule_next_tick(UsbHidAutofireApp *app) {
-  furi_timer_start(app->click_timer, usb_hid_autofire_half_delay_ticks(app));
+  uint32_t *deadline = usb_hid_autofire_next_deadline(&app->engine);
+  uint32_t now = furi_get_tick();
+
+  if ((int32_t)(*deadline - now) < 0) {
+    if ((now - *deadline) >= usb_hid_autofire_cycle_ticks(&app->engine)) {
+      app->engine.tick_drops++;
+    }
+    *deadline =
+        usb_hid_autofire_apply_late_policy(&app->engine, *deadline, now);
+  }
+  *deadline = usb_hid_autofire_align_deadline(&app->engine, *deadline);
+}
+
+void usb_hid_autofire_restart_schedule(UsbHidAutofireApp *app) {
+  AutofireEngine *engine = &app->engine;
+  uint32_t now = furi_get_tick();
+  engine->next_press_at = usb_hid_autofire_align_deadline(
+      engine, now + usb_hid_autofire_gap_ticks(engine));
+  engine->next_release_at = usb_hid_autofire_align_deadline(
+      engine, now + usb_hid_autofire_hold_ticks(engine));
+  engine->cycle_gap_ticks = usb_hid_autofire_gap_ticks(engine);
+}
+
+uint32_t usb_hid_autofire_ticks_until_next_tick(const UsbHidAutofireApp *app) {
+  uint32_t deadline;
+  if (!app->engine.active ||
+      !usb_hid_autofire_scheduler_peek(&app->engine, &deadline)) {
+    return FuriWaitForever;
+  }
+
+  int32_t remaining_ticks = (int32_t)(deadline - furi_get_tick());
+  return (remaining_ticks > 0) ? (uint32_t)remaining_ticks : 0U;
 }
 
 void usb_hid_autofire_drain_event_queue(UsbHidAutofireApp *app,
                                         uint8_t max_count) {
   UsbMouseEvent event;
   for (uint8_t i = 0; i < max_count; i++) {
-    if (furi_message_queue_get(app->event_queue, &event, 0) != FuriStatusOk) {
+    if (usb_hid_autofire_get_event(app, &event, 0) != FuriStatusOk) {
       break;
     }
   }
 }
 
-void usb_hid_autofire_press_mode_control(UsbHidAutofireApp *app) {
-  switch (app->mode) {
-  case AutofireModeMouseLeftClick:
-    furi_hal_hid_mouse_press(HID_MOUSE_BTN_LEFT);
-    break;
-  case AutofireModeMouseRightClick:
-    furi_hal_hid_mouse_press(HID_MOUSE_BTN_RIGHT);
-    break;
-  case AutofireModeKeyboardEnter:
-    furi_hal_hid_kb_press(HID_KEYBOARD_RETURN);
-    break;
-  case AutofireModeKeyboardSpace:
-    furi_hal_hid_kb_press(HID_KEYBOARD_SPACEBAR);
-    break;
-  default:
-    break;
-  }
-}
-
-void usb_hid_autofire_release_mode_control(UsbHidAutofireApp *app) {
-  switch (app->mode) {
-  case AutofireModeMouseLeftClick:
-    furi_hal_hid_mouse_release(HID_MOUSE_BTN_LEFT);
-    break;
-  case AutofireModeMouseRightClick:
-    furi_hal_hid_mouse_release(HID_MOUSE_BTN_RIGHT);
-    break;
-  case AutofireModeKeyboardEnter:
-    furi_hal_hid_kb_release(HID_KEYBOARD_RETURN);
-    break;
-  case AutofireModeKeyboardSpace:
-    furi_hal_hid_kb_release(HID_KEYBOARD_SPACEBAR);
-    break;
-  default:
-    break;
+static void usb_hid_autofire_release_pressed(UsbHidAutofireApp *app) {
+  if (app->engine.pressed) {
+    usb_hid_autofire_transport_send(&app->transport, app->engine.kind,
+                                    app->engine.hid_code, false);
+    app->engine.pressed = false;
+    app->engine.last_transition_tick = furi_get_tick();
   }
 }
 
-void usb_hid_autofire_start(UsbHidAutofireApp *app) {
-  app->active = true;
-  app->click_phase = ClickPhasePress;
+static void
+usb_hid_autofire_engine_configure(UsbHidAutofireApp *app,
+                                  const ClickWorkerCommand *command) {
+  AutofireEngine *engine = &app->engine;
+  uint32_t delay_ms = command->delay_ms;
+  bool target_changed = (command->mode != engine->mode) ||
+                        (command->hid_code != engine->hid_code);
+  bool timing_changed = target_changed ||
+                        (delay_ms != engine->delay_ms) ||
+                        (command->duty_percent != engine->duty_percent) ||
+                        (command->frame_align_ms != engine->frame_align_ms) ||
+                        (command->target_cps_x10 != engine->target_cps_x10);
+
+  if (target_changed) {
+    usb_hid_autofire_release_pressed(app);
+    engine->click_phase = ClickPhasePress;
+  }
+  engine->mode = command->mode;
+  engine->kind = usb_hid_autofire_target(command->mode)->kind;
+  engine->hid_code = command->hid_code;
+  engine->delay_ms = delay_ms;
+  engine->duty_percent = command->duty_percent;
+  engine->frame_align_ms = command->frame_align_ms;
+  engine->target_cps_x10 = command->target_cps_x10;
+  engine->late_policy = command->late_policy;
+  if (command->burst_count != engine->burst_count) {
+    engine->burst_clicks = 0U;
+  }
+  engine->burst_count = command->burst_count;
+  engine->burst_interval_ms = command->burst_interval_ms;
+  engine->run = command->run;
+
+  if (engine->active && timing_changed) {
+    // The rate first: with a target rate the schedule takes its cycle.
+    usb_hid_autofire_reset_rate(engine);
+    usb_hid_autofire_restart_schedule(app);
+  }
+
+  // The sequence takes over channel 0 from the click while it runs.
+  bool sequence_enabled =
+      command->sequence_enabled && (engine->sequence.program->count > 0U);
+  if (sequence_enabled != engine->sequence_enabled) {
+    usb_hid_autofire_release_pressed(app);
+    usb_hid_autofire_sequence_stop(&engine->sequence);
+    engine->click_phase = ClickPhasePress;
+    engine->sequence_enabled = sequence_enabled;
+    if (engine->active) {
+      uint32_t now = furi_get_tick();
+      engine->next_press_at = usb_hid_autofire_align_deadline(engine, now);
+      usb_hid_autofire_sequence_start(&engine->sequence, now);
+    }
+  }
+
+  for (size_t i = 0; i < AUTOFIRE_EXTRA_CHANNEL_COUNT; i++) {
+    usb_hid_autofire_channel_configure(&engine->channels[i],
+                                       &command->channels[i],
+                                       command->channel_hid_codes[i],
+                                       engine->active, &app->transport);
+  }
+}
+
+// Starts firing with the configuration the engine already has.
+static void usb_hid_autofire_engine_begin(UsbHidAutofireApp *app) {
+  AutofireEngine *engine = &app->engine;
+  engine->active = true;
+  engine->click_phase = ClickPhasePress;
+  engine->burst_clicks = 0U;
+  engine->next_press_at =
+      usb_hid_autofire_align_deadline(engine, furi_get_tick());
   usb_hid_autofire_reset_cps_tracking(app);
-  furi_timer_start(app->ui_refresh_timer,
-                   furi_ms_to_ticks(UI_REFRESH_PERIOD_MS));
-  usb_hid_autofire_tick(app);
+  usb_hid_autofire_reset_rate(engine);
+  usb_hid_autofire_trace_reset(engine->trace);
+  usb_hid_autofire_sequence_start(&engine->sequence, furi_get_tick());
+  for (size_t i = 0; i < AUTOFIRE_EXTRA_CHANNEL_COUNT; i++) {
+    usb_hid_autofire_channel_start(&engine->channels[i], furi_get_tick());
+  }
 }
 
-void usb_hid_autofire_stop(UsbHidAutofireApp *app) {
-  app->active = false;
-  app->click_phase = ClickPhasePress;
-  if (app->click_timer) {
-    furi_timer_stop(app->click_timer);
+static void usb_hid_autofire_engine_start(UsbHidAutofireApp *app,
+                                          const ClickWorkerCommand *command) {
+  usb_hid_autofire_engine_configure(app, command);
+  usb_hid_autofire_engine_begin(app);
+}
+
+static void usb_hid_autofire_engine_stop(UsbHidAutofireApp *app) {
+  app->engine.active = false;
+  app->engine.burst_done = false;
+  app->engine.hold_report_pending = false;
+  app->engine.click_phase = ClickPhasePress;
+  usb_hid_autofire_release_pressed(app);
+  usb_hid_autofire_sequence_stop(&app->engine.sequence);
+  for (size_t i = 0; i < AUTOFIRE_EXTRA_CHANNEL_COUNT; i++) {
+    usb_hid_autofire_channel_stop(&app->engine.channels[i], &app->transport);
   }
-  if (app->ui_refresh_timer) {
-    furi_timer_stop(app->ui_refresh_timer);
+  app->transport.ops->release_all(&app->transport);
+  usb_hid_autofire_capture_flush(&app->capture);
+  usb_hid_autofire_reset_cps_tracking(app);
+}
+
+static void usb_hid_autofire_worker_send(UsbHidAutofireApp *app,
+                                         ClickWorkerCommandType type) {
+  if (!app->click_worker) {
+    return;
   }
 
-  if (app->mouse_pressed) {
-    usb_hid_autofire_release_mode_control(app);
-    app->mouse_pressed = false;
+  ClickWorkerCommand command = {
+      .type = type,
+      .mode = app->mode,
+      .hid_code = usb_hid_autofire_target_code(app->mode, app->key_code,
+                                               app->key_modifiers),
+      .delay_ms = app->autofire_delay_ms,
+      .duty_percent = app->duty_percent,
+      .frame_align_ms = app->frame_align_ms,
+      .target_cps_x10 = app->target_cps_x10,
+      .late_policy = app->late_policy,
+      .sequence_enabled = app->sequence_enabled,
+      .burst_count = app->burst_count,
+      .burst_interval_ms = app->burst_interval_ms,
+      .run = __atomic_load_n(&app->run, __ATOMIC_ACQUIRE),
+  };
+  for (size_t i = 0; i < AUTOFIRE_EXTRA_CHANNEL_COUNT; i++) {
+    command.channels[i] = app->channels[i];
+    command.channel_hid_codes[i] = usb_hid_autofire_target_code(
+        app->channels[i].mode, app->key_code, app->key_modifiers);
   }
-  furi_hal_hid_kb_release_all();
+  furi_message_queue_put(app->click_commands, &command, FuriWaitForever);
+  furi_thread_flags_set(furi_thread_get_id(app->click_worker),
+                        ClickWorkerFlagCommand);
+}
+
+// App side of starting and stopping; the worker is told separately.
+static void usb_hid_autofire_set_active(UsbHidAutofireApp *app, bool active) {
+  if (active) {
+    app->trace_export_result = AutofireExportResultNone;
+    app->ui_active_since_tick = furi_get_tick();
+    app->ui_quiet_refreshes = 0U;
+  } else if (app->active) {
+    app->ui_stats.active_ms += furi_get_tick() - app->ui_active_since_tick;
+  }
+  app->active = active;
+  app->realtime_cps_x10 = 0U;
+  app->realtime_long_cps_x10 = 0U;
+  usb_hid_autofire_ui_refresh_update(app);
+}
+
+void usb_hid_autofire_start(UsbHidAutofireApp *app) {
+  __atomic_add_fetch(&app->run, 1U, __ATOMIC_ACQ_REL);
+  usb_hid_autofire_set_active(app, true);
+  usb_hid_autofire_worker_send(app, ClickWorkerCommandStart);
+}
+
+void usb_hid_autofire_stop(UsbHidAutofireApp *app) {
+  usb_hid_autofire_set_active(app, false);
+  usb_hid_autofire_worker_send(app, ClickWorkerCommandStop);
 
-  usb_hid_autofire_reset_cps_tracking(app);
   app->adjust_hold_active = false;
   app->adjust_hold_key = InputKeyMAX;
   app->adjust_repeat_count = 0U;
@@ -168,21 +413,291 @@ void usb_hid_autofire_stop(UsbHidAutofireApp *app) {
   app->back_long_handled = false;
 }
 
-void usb_hid_autofire_tick(UsbHidAutofireApp *app) {
-  if (!app->active) {
+void usb_hid_autofire_send_config(UsbHidAutofireApp *app) {
+  usb_hid_autofire_worker_send(app, ClickWorkerCommandConfigure);
+}
+
+// Counts clicks on the worker, so a burst is exact at any rate. The last
+// click of a burst either waits out the interval or ends the run once the
+// pass's report has gone out.
+static void usb_hid_autofire_burst_click(AutofireEngine *engine) {
+  if ((engine->burst_count == 0U) ||
+      (++engine->burst_clicks < engine->burst_count)) {
+    return;
+  }
+
+  engine->burst_clicks = 0U;
+  if (engine->burst_interval_ms == 0U) {
+    engine->burst_done = true;
+    return;
+  }
+  engine->next_press_at =
+      engine->next_release_at + furi_ms_to_ticks(engine->burst_interval_ms);
+  // The pause is not a click interval for the rate window.
+  engine->last_click_release_tick_ms = 0U;
+}
+
+// Runs in the input callback. A press on the armed main screen wakes the
+// worker directly with the number of its run; the release is passed on
+// only for a press that was.
+void usb_hid_autofire_hold_input(UsbHidAutofireApp *app, InputType type) {
+  uint32_t flag = 0U;
+  if ((type == InputTypePress) &&
+      __atomic_load_n(&app->hold_armed, __ATOMIC_ACQUIRE)) {
+    __atomic_store_n(&app->engine.hold_input_tick, furi_get_tick(),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&app->engine.hold_run,
+                     __atomic_add_fetch(&app->run, 1U, __ATOMIC_ACQ_REL),
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&app->hold_down, true, __ATOMIC_RELEASE);
+    flag = ClickWorkerFlagHoldPress;
+  } else if ((type == InputTypeRelease) &&
+             __atomic_exchange_n(&app->hold_down, false, __ATOMIC_ACQ_REL)) {
+    flag = ClickWorkerFlagHoldRelease;
+  }
+
+  // Cleared before the worker is freed.
+  FuriThread *worker = __atomic_load_n(&app->click_worker, __ATOMIC_ACQUIRE);
+  if ((flag != 0U) && worker) {
+    furi_thread_flags_set(furi_thread_get_id(worker), flag);
+  }
+}
+
+// Mirrors a hold on the main loop. The worker started or stopped already,
+// and a command sent now could land after the next press; the run number
+// was taken with the press.
+void usb_hid_autofire_hold_changed(UsbHidAutofireApp *app, bool held) {
+  if (held != app->active) {
+    usb_hid_autofire_set_active(app, held);
+  }
+}
+
+bool usb_hid_autofire_burst_finished(const UsbHidAutofireApp *app) {
+  return __atomic_load_n(&app->engine.burst_done_run, __ATOMIC_ACQUIRE) ==
+         __atomic_load_n(&app->run, __ATOMIC_ACQUIRE);
+}
+
+void usb_hid_autofire_tick(UsbHidAutofireApp *app, AutofireHidBatch *batch) {
+  AutofireEngine *engine = &app->engine;
+  if (!engine->active) {
     return;
   }
 
-  if (app->click_phase == ClickPhasePress) {
-    usb_hid_autofire_press_mode_control(app);
-    app->mouse_pressed = true;
-    app->click_phase = ClickPhaseRelease;
+  uint32_t now = furi_get_tick();
+  AutofireTargetKind kind = engine->kind;
+  engine->last_transition_tick = now;
+  if (engine->click_phase == ClickPhasePress) {
+    usb_hid_autofire_hid_batch_add(batch, kind, engine->hid_code, true);
+    engine->pressed = true;
+    usb_hid_autofire_trace_record_press(engine->trace, now);
+    engine->next_release_at =
+        engine->next_press_at + usb_hid_autofire_begin_cycle(engine);
+    engine->click_phase = ClickPhaseRelease;
   } else {
-    usb_hid_autofire_release_mode_control(app);
-    app->mouse_pressed = false;
+    usb_hid_autofire_hid_batch_add(batch, kind, engine->hid_code, false);
+    engine->pressed = false;
+    usb_hid_autofire_trace_record_release(engine->trace, now);
     usb_hid_autofire_record_click_release(app);
-    app->click_phase = ClickPhasePress;
+    engine->next_press_at = engine->next_release_at + engine->cycle_gap_ticks;
+    engine->click_phase = ClickPhasePress;
+    usb_hid_autofire_burst_click(engine);
   }
 
   usb_hid_autofire_schedule_next_tick(app);
 }
+
+static void usb_hid_autofire_worker_process_commands(UsbHidAutofireApp *app) {
+  ClickWorkerCommand command;
+  while (furi_message_queue_get(app->click_commands, &command, 0) ==
+         FuriStatusOk) {
+    switch (command.type) {
+    case ClickWorkerCommandStart:
+      usb_hid_autofire_engine_start(app, &command);
+      break;
+    case ClickWorkerCommandStop:
+      usb_hid_autofire_engine_stop(app);
+      break;
+    case ClickWorkerCommandConfigure:
+      usb_hid_autofire_engine_configure(app, &command);
+      break;
+    default:
+      break;
+    }
+  }
+  usb_hid_autofire_scheduler_rebuild(&app->engine);
+}
+
+// Serves every channel that is due, each at most once, so a channel still
+// behind after its tick waits for the next pass instead of pressing and
+// releasing within one report. Changes of the pass go out together.
+static void usb_hid_autofire_service_channels(UsbHidAutofireApp *app) {
+  AutofireEngine *engine = &app->engine;
+  AutofireHidBatch batch = {.count = 0U};
+  uint8_t due[AUTOFIRE_CHANNEL_COUNT];
+  uint32_t due_late_ms[AUTOFIRE_CHANNEL_COUNT];
+  uint32_t due_count = 0U;
+  uint32_t deadline;
+  uint32_t now = furi_get_tick();
+
+  while (usb_hid_autofire_scheduler_peek(engine, &deadline) &&
+         ((int32_t)(deadline - now) <= 0)) {
+    due_late_ms[due_count] = now - deadline;
+    due[due_count++] = usb_hid_autofire_scheduler_pop(engine);
+  }
+  for (uint32_t i = 0U; i < due_count; i++) {
+    uint32_t first_change = batch.count;
+    if ((due[i] == 0U) && engine->sequence_enabled) {
+      usb_hid_autofire_sequence_tick(&engine->sequence, &batch,
+                                     engine->late_policy);
+    } else if (due[i] == 0U) {
+      usb_hid_autofire_tick(app, &batch);
+    } else {
+      usb_hid_autofire_channel_tick(&engine->channels[due[i] - 1U], &batch);
+    }
+    for (uint32_t j = first_change; j < batch.count; j++) {
+      usb_hid_autofire_capture_record(&app->capture, &batch.changes[j],
+                                      due[i], now, due_late_ms[i]);
+    }
+  }
+
+  uint32_t changes = batch.count;
+  uint32_t reports =
+      usb_hid_autofire_hid_batch_flush(&batch, &app->transport);
+  engine->merged_changes += changes - reports;
+  engine->scheduler_passes++;
+  if (engine->hold_report_pending && (changes > 0U)) {
+    uint32_t latency_ms =
+        furi_get_tick() -
+        __atomic_load_n(&engine->hold_input_tick, __ATOMIC_RELAXED);
+    engine->hold_report_pending = false;
+    __atomic_store_n(&engine->hold_latency_ms, latency_ms, __ATOMIC_RELAXED);
+    if (latency_ms > engine->hold_latency_max_ms) {
+      __atomic_store_n(&engine->hold_latency_max_ms, latency_ms,
+                       __ATOMIC_RELAXED);
+    }
+  }
+  if (engine->burst_done) {
+    usb_hid_autofire_engine_stop(app);
+    __atomic_store_n(&engine->burst_done_run, engine->run, __ATOMIC_RELEASE);
+    UsbMouseEvent event = {.type = EventTypeBurstDone};
+    usb_hid_autofire_post_event(app, &event);
+    return;
+  }
+  for (uint32_t i = 0U; i < due_count; i++) {
+    usb_hid_autofire_scheduler_push(engine, due[i]);
+  }
+}
+
+// Starts on a hold press and stops once the key is up again. The flags
+// only say that something changed; `hold_down` says where the key is now.
+// A press takes the latest run number even if the last run is still going,
+// since the main loop sees that press as the start of a new one.
+static void usb_hid_autofire_worker_hold(UsbHidAutofireApp *app,
+                                         uint32_t flags) {
+  AutofireEngine *engine = &app->engine;
+  if (flags & ClickWorkerFlagHoldPress) {
+    engine->run = __atomic_load_n(&engine->hold_run, __ATOMIC_ACQUIRE);
+  }
+  if ((flags & ClickWorkerFlagHoldPress) && !engine->active) {
+    usb_hid_autofire_engine_begin(app);
+    engine->hold_report_pending = true;
+    engine->hold_starts++;
+  }
+  if (!__atomic_load_n(&app->hold_down, __ATOMIC_ACQUIRE) && engine->active) {
+    usb_hid_autofire_engine_stop(app);
+  }
+  usb_hid_autofire_scheduler_rebuild(engine);
+}
+
+// Runs the press/release engine at high priority. It sleeps on its thread
+// flags until the next phase deadline, so click timing does not depend on
+// input, redraws or settings writes queued for the main loop.
+static int32_t usb_hid_autofire_worker(void *ctx) {
+  UsbHidAutofireApp *app = ctx;
+  bool running = true;
+
+  while (running) {
+    furi_mutex_acquire(app->engine_mutex, FuriWaitForever);
+    uint32_t wait_ticks = usb_hid_autofire_ticks_until_next_tick(app);
+    furi_mutex_release(app->engine_mutex);
+
+    uint32_t flags = 0U;
+    if (wait_ticks > 0U) {
+      flags = furi_thread_flags_wait(CLICK_WORKER_FLAGS_ALL, FuriFlagWaitAny,
+                                     wait_ticks);
+      if (flags & FuriFlagError) {
+        flags = 0U;
+      }
+    }
+
+    furi_mutex_acquire(app->engine_mutex, FuriWaitForever);
+    if (flags & (ClickWorkerFlagCommand | ClickWorkerFlagExit)) {
+      usb_hid_autofire_worker_process_commands(app);
+    }
+    if (flags & (ClickWorkerFlagHoldPress | ClickWorkerFlagHoldRelease)) {
+      usb_hid_autofire_worker_hold(app, flags);
+    }
+    if (flags & ClickWorkerFlagExit) {
+      usb_hid_autofire_engine_stop(app);
+      running = false;
+    } else if (usb_hid_autofire_ticks_until_next_tick(app) == 0U) {
+      // The whole pass, HID reports included.
+      AUTOFIRE_PROFILE_BEGIN(tick_start);
+      usb_hid_autofire_service_channels(app);
+      AUTOFIRE_PROFILE_END(app, AutofireProfileTick, tick_start);
+    }
+    furi_mutex_release(app->engine_mutex);
+  }
+
+  return 0;
+}
+
+bool usb_hid_autofire_worker_start(UsbHidAutofireApp *app) {
+  app->engine_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+  app->click_commands = furi_message_queue_alloc(
+      CLICK_WORKER_COMMAND_QUEUE_SIZE, sizeof(ClickWorkerCommand));
+  if (!app->engine_mutex || !app->click_commands) {
+    return false;
+  }
+
+  app->click_worker =
+      furi_thread_alloc_ex("AutofireClickWorker", CLICK_WORKER_STACK_SIZE,
+                           usb_hid_autofire_worker, app);
+  if (!app->click_worker) {
+    return false;
+  }
+  furi_thread_set_priority(app->click_worker, FuriThreadPriorityHighest);
+  furi_thread_start(app->click_worker);
+  return true;
+}
+
+void usb_hid_autofire_worker_stop(UsbHidAutofireApp *app) {
+  // Taken out of the app first, so a late input callback cannot reach it.
+  FuriThread *worker =
+      __atomic_exchange_n(&app->click_worker, NULL, __ATOMIC_ACQ_REL);
+  if (worker) {
+    furi_thread_flags_set(furi_thread_get_id(worker), ClickWorkerFlagExit);
+    furi_thread_join(worker);
+    furi_thread_free(worker);
+    FURI_LOG_I(TAG, "Scheduler: %lu passes, %lu changes merged",
+               (unsigned long)app->engine.scheduler_passes,
+               (unsigned long)app->engine.merged_changes);
+    if (app->engine.hold_starts > 0U) {
+      FURI_LOG_I(TAG, "Hold to fire: %lu starts, input to report %lums, max "
+                      "%lums",
+                 (unsigned long)app->engine.hold_starts,
+                 (unsigned long)app->engine.hold_latency_ms,
+                 (unsigned long)app->engine.hold_latency_max_ms);
+    }
+  }
+
+  if (app->click_commands) {
+    furi_message_queue_free(app->click_commands);
+    app->click_commands = NULL;
+  }
+
+  if (app->engine_mutex) {
+    furi_mutex_free(app->engine_mutex);
+    app->engine_mutex = NULL;
+  }
+}
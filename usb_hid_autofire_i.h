@@ -9,6 +9,8 @@
 #include <gui/gui.h>
 #include <input/input.h>
 
+#include <bt/bt_service/bt.h>
+#include <extra_profiles/hid_profile.h>
 #include <flipper_format/flipper_format.h>
 #include <storage/storage.h>
 
@@ -17,6 +19,10 @@
 // Uncomment to be able to make a screenshot
 // #define USB_HID_AUTOFIRE_SCREENSHOT
 
+// Uncomment to time the hot paths, shown on a diagnostics screen and in
+// the exit log
+// #define USB_HID_AUTOFIRE_PROFILE
+
 #define AUTOFIRE_DELAY_MIN_MS 5U
 #define AUTOFIRE_DELAY_MAX_MS 10000U
 #define AUTOFIRE_DELAY_STEP_MS 10U
@@ -25,37 +31,200 @@
 #define AUTOFIRE_REPEAT_MEDIUM_THRESHOLD 3U
 #define AUTOFIRE_REPEAT_FAST_THRESHOLD 8U
 #define AUTOFIRE_DELAY_DEFAULT_MS 10U
+#define AUTOFIRE_DUTY_MIN_PERCENT 10U
+#define AUTOFIRE_DUTY_MAX_PERCENT 90U
+#define AUTOFIRE_DUTY_STEP_PERCENT 10U
+#define AUTOFIRE_DUTY_DEFAULT_PERCENT 50U
+#define AUTOFIRE_FRAME_ALIGN_MAX_MS 8U
+#define AUTOFIRE_FRAME_ALIGN_DEFAULT_MS 0U
+#define AUTOFIRE_TARGET_CPS_MIN_X10 1U
+#define AUTOFIRE_TARGET_CPS_MAX_X10 2000U
+#define AUTOFIRE_RATE_KP_SHIFT 2U
+#define AUTOFIRE_RATE_KI_SHIFT 4U
+#define AUTOFIRE_RATE_EMA_SHIFT 3U
+#define AUTOFIRE_RATE_SETTLE_PERMILLE 10U
 #define AUTOFIRE_PRESET_SLOW_MS 250U
 #define AUTOFIRE_PRESET_MEDIUM_MS 120U
 #define AUTOFIRE_PRESET_FAST_MS 70U
 #define HIGH_CPS_CONFIRM_THRESHOLD_X10 120U
 #define UI_REFRESH_PERIOD_MS 250U
+#define UI_REFRESH_SLOW_PERIOD_MS 1000U
+// Refreshes without a visible change before the refresh slows down.
+#define UI_REFRESH_QUIET_LIMIT 4U
+// The firmware turns the display off this long after the last key (its
+// default timeout) and on again at the next one. Apps get no display event,
+// so the last input stands for it.
+#define UI_DISPLAY_OFF_MS 30000U
+#define UI_REDRAW_MIN_INTERVAL_MS 40U
+#define AUTOFIRE_VIEW_LINES 6U
+#define AUTOFIRE_VIEW_LINE_SIZE 40U
 #define EVENT_DRAIN_MAX_COUNT 32U
 #define SETTINGS_SAVE_DEBOUNCE_MS 500U
+#define AUTOFIRE_CATCH_UP_MAX_CYCLES 4U
+#define AUTOFIRE_TRACE_SIZE 64U
+#define AUTOFIRE_TRACE_MASK (AUTOFIRE_TRACE_SIZE - 1U)
+#define AUTOFIRE_CPS_WINDOW_SIZE 32U
+#define AUTOFIRE_CPS_WINDOW_MASK (AUTOFIRE_CPS_WINDOW_SIZE - 1U)
+#define AUTOFIRE_CPS_SHORT_WINDOW 8U
+#define AUTOFIRE_KEY_CODE_MIN 0x04U
+#define AUTOFIRE_KEY_CODE_MAX 0x65U
+#define AUTOFIRE_KEY_CODE_DEFAULT 0x04U
+// Left Ctrl, Shift, Alt and GUI, in the order of the HID modifier byte.
+#define AUTOFIRE_KEY_MODIFIERS_MASK 0x0FU
+// The main target plus extra channels that fire independently.
+#define AUTOFIRE_CHANNEL_COUNT 4U
+#define AUTOFIRE_EXTRA_CHANNEL_COUNT (AUTOFIRE_CHANNEL_COUNT - 1U)
+#define AUTOFIRE_CHANNEL_DELAY_MAX_MS 600000U
+#define AUTOFIRE_CHANNEL_HOLD_MAX_MS 100U
+// Ops kept in memory: a whole short program, or two halves a longer one
+// streams through from SD.
+#define AUTOFIRE_SEQUENCE_MAX_OPS 64U
+#define AUTOFIRE_SEQUENCE_CHUNK_OPS (AUTOFIRE_SEQUENCE_MAX_OPS / 2U)
+// Jump targets are 16-bit.
+#define AUTOFIRE_SEQUENCE_STREAM_MAX_OPS 65535U
+#define AUTOFIRE_SEQUENCE_CHUNK_NONE UINT32_MAX
+// Nested loop levels, one counter each.
+#define AUTOFIRE_SEQUENCE_MAX_DEPTH 4U
+// Keys a sequence can hold at once, the slots of a boot keyboard report.
+#define AUTOFIRE_SEQUENCE_MAX_KEYS 6U
+#define AUTOFIRE_SEQUENCE_LINE_MAX 64U
+#define AUTOFIRE_SEQUENCE_READ_SIZE 128U
+#define AUTOFIRE_SEQUENCE_TAP_MS 20U
+#define AUTOFIRE_BURST_MAX_CLICKS 10000U
+// Reports the loopback transport keeps, 8 bytes each.
+#define AUTOFIRE_LOOPBACK_CAPACITY 4096U
+#define AUTOFIRE_BLE_DISCONNECT_WAIT_MS 200U
+// Capture records per RAM block; the worker fills one block while the
+// writer puts the other on SD.
+#define AUTOFIRE_CAPTURE_BLOCK_RECORDS 128U
+// Size at which the capture file rolls over to the old file.
+#define AUTOFIRE_CAPTURE_FILE_MAX_BYTES (256U * 1024U)
+#define AUTOFIRE_CAPTURE_LATE_MAX_MS UINT16_MAX
+// Input events buffered between the input callback and the main loop, and
+// how many the main loop lets pile up before it writes them out.
+#define AUTOFIRE_INPUT_LOG_RECORDS 64U
+#define AUTOFIRE_INPUT_LOG_FLUSH_RECORDS 32U
+// About 8000 events; later ones are counted but not written.
+#define AUTOFIRE_INPUT_LOG_MAX_BYTES (64U * 1024U)
+#define CLICK_WORKER_STACK_SIZE 1024U
+#define CLICK_WORKER_COMMAND_QUEUE_SIZE 8U
+#define SETTINGS_WRITER_STACK_SIZE 2048U
+#define SEQUENCE_LOADER_STACK_SIZE 1024U
+#define SEQUENCE_LOADER_QUEUE_SIZE 4U
+#define CAPTURE_WRITER_STACK_SIZE 1024U
 
-#define USB_HID_AUTOFIRE_SETTINGS_PATH APP_DATA_PATH(".settings")
+#define USB_HID_AUTOFIRE_SETTINGS_PATH APP_DATA_PATH("settings.bin")
+#define USB_HID_AUTOFIRE_SETTINGS_MAGIC 0x54534641U
+#define USB_HID_AUTOFIRE_SETTINGS_VERSION 2U
+#define USB_HID_AUTOFIRE_SETTINGS_TEMP_PATH APP_DATA_PATH("settings.tmp")
+// Text settings written up to 0.7.x, migrated once on first load.
+#define USB_HID_AUTOFIRE_SETTINGS_LEGACY_PATH APP_DATA_PATH(".settings")
 #define USB_HID_AUTOFIRE_SETTINGS_FILE_TYPE "USB HID Autofire Settings"
-#define USB_HID_AUTOFIRE_SETTINGS_VERSION 1U
+#define USB_HID_AUTOFIRE_SETTINGS_LEGACY_VERSION 1U
+#define USB_HID_AUTOFIRE_TRACE_EXPORT_PATH APP_DATA_PATH("click_trace.csv")
+#define USB_HID_AUTOFIRE_SEQUENCE_PATH APP_DATA_PATH("sequence.txt")
+// Compiled ops of a sequence too long to keep in memory.
+#define USB_HID_AUTOFIRE_SEQUENCE_STREAM_PATH APP_DATA_PATH("sequence.bin")
+#define USB_HID_AUTOFIRE_LOOPBACK_EXPORT_PATH APP_DATA_PATH("loopback.csv")
+#define USB_HID_AUTOFIRE_BLE_KEYS_PATH APP_DATA_PATH(".bt_hid.keys")
+#define USB_HID_AUTOFIRE_CAPTURE_PATH APP_DATA_PATH("capture.bin")
+#define USB_HID_AUTOFIRE_CAPTURE_OLD_PATH APP_DATA_PATH("capture.old.bin")
+#define USB_HID_AUTOFIRE_CAPTURE_MAGIC 0x50434641U
+#define USB_HID_AUTOFIRE_CAPTURE_VERSION 1U
+#define USB_HID_AUTOFIRE_INPUT_LOG_PATH APP_DATA_PATH("input.bin")
+#define USB_HID_AUTOFIRE_INPUT_LOG_OLD_PATH APP_DATA_PATH("input.old.bin")
+#define USB_HID_AUTOFIRE_INPUT_LOG_MAGIC 0x4E494641U
+#define USB_HID_AUTOFIRE_INPUT_LOG_VERSION 1U
 
 typedef enum {
   EventTypeInput,
-  EventTypeTick,
   EventTypeUiRefresh,
   EventTypeSettingsSave,
+  EventTypeBurstDone,
+  EventTypeCount,
 } EventType;
 
+// Payload-free events that need at most one queued copy.
+#define EVENT_COALESCED_MASK                                                   \
+  ((1UL << EventTypeUiRefresh) | (1UL << EventTypeSettingsSave) |             \
+   (1UL << EventTypeBurstDone))
+
 typedef enum {
   ClickPhasePress,
   ClickPhaseRelease,
 } ClickPhase;
 
+// Index into the target table. The first four rows are the original modes
+// so stored settings keep their meaning.
 typedef enum {
   AutofireModeMouseLeftClick,
   AutofireModeMouseRightClick,
   AutofireModeKeyboardEnter,
   AutofireModeKeyboardSpace,
+  AutofireModeMouseMiddleClick,
+  AutofireModeKeyboardCustom,
+  AutofireModeCount,
 } AutofireMode;
 
+typedef enum {
+  AutofireTargetKindMouse,
+  AutofireTargetKindKeyboard,
+  AutofireTargetKindCount,
+} AutofireTargetKind;
+
+typedef struct {
+  AutofireTargetKind kind;
+  // Mouse button mask or keyboard usage; 0 takes the custom key code.
+  uint16_t code;
+  const char *label;
+} AutofireTarget;
+
+typedef enum {
+  AutofireTransportUsb,
+  AutofireTransportBle,
+  AutofireTransportLoopback,
+  AutofireTransportCount,
+} AutofireTransportType;
+
+typedef struct AutofireTransport AutofireTransport;
+
+// One way of getting reports to the host. Press and release each send a
+// report, as the furi_hal_hid calls do; release_all lets go of every key.
+typedef struct {
+  bool (*open)(AutofireTransport *transport);
+  void (*close)(AutofireTransport *transport);
+  bool (*press)(AutofireTransport *transport, AutofireTargetKind kind,
+                uint16_t code);
+  bool (*release)(AutofireTransport *transport, AutofireTargetKind kind,
+                  uint16_t code);
+  bool (*release_all)(AutofireTransport *transport);
+} AutofireTransportOps;
+
+typedef struct {
+  uint32_t tick;
+  uint16_t code;
+  uint8_t kind;
+  uint8_t press;
+} AutofireLoopbackReport;
+
+// Reports taken by the loopback transport, in a buffer allocated at open so
+// recording never allocates. Reports past the capacity are only counted.
+typedef struct {
+  AutofireLoopbackReport *reports;
+  uint32_t count;
+  uint32_t total;
+} AutofireLoopback;
+
+struct AutofireTransport {
+  AutofireTransportType type;
+  const AutofireTransportOps *ops;
+  bool opened;
+  FuriHalUsbInterface *usb_mode_prev;
+  Bt *bt;
+  FuriHalBleProfileBase *ble_profile;
+  AutofireLoopback loopback;
+};
+
 typedef enum {
   AutofirePresetCustom,
   AutofirePresetSlow,
@@ -69,6 +238,260 @@ typedef enum {
   AutofireStartupPolicyRestoreLastState,
 } AutofireStartupPolicy;
 
+typedef enum {
+  AutofireLatePolicyCatchUp,
+  AutofireLatePolicySkip,
+  AutofireLatePolicySlide,
+  AutofireLatePolicyCount,
+} AutofireLatePolicy;
+
+typedef enum {
+  AutofireScreenMain,
+  AutofireScreenHelp,
+  AutofireScreenStats,
+  AutofireScreenOptions,
+  AutofireScreenBench,
+  AutofireScreenChannels,
+  AutofireScreenProfile,
+} AutofireScreen;
+
+// Left of the help screen and right of the last page wrap around.
+#ifdef USB_HID_AUTOFIRE_PROFILE
+#define AUTOFIRE_SCREEN_LAST AutofireScreenProfile
+#else
+#define AUTOFIRE_SCREEN_LAST AutofireScreenChannels
+#endif
+
+typedef enum {
+  AutofireOptionTarget,
+  AutofireOptionDuty,
+  AutofireOptionLatePolicy,
+  AutofireOptionFrameAlign,
+  AutofireOptionKeyCode,
+  AutofireOptionKeyModifiers,
+  AutofireOptionSequence,
+  AutofireOptionBurst,
+  AutofireOptionBurstInterval,
+  AutofireOptionTrigger,
+  AutofireOptionTransport,
+  AutofireOptionCapture,
+  AutofireOptionInputLog,
+  AutofireOptionCount,
+} AutofireOption;
+
+typedef enum {
+  AutofireChannelFieldEnabled,
+  AutofireChannelFieldTarget,
+  AutofireChannelFieldDelay,
+  AutofireChannelFieldDuty,
+  AutofireChannelFieldCount,
+} AutofireChannelField;
+
+typedef enum {
+  AutofireExportResultNone,
+  AutofireExportResultOk,
+  AutofireExportResultFailed,
+} AutofireExportResult;
+
+typedef struct {
+  uint32_t press_tick;
+  uint32_t release_tick;
+} AutofireClickSample;
+
+// Fixed-size ring of the most recent clicks. A press fills the slot at
+// `count`, the matching release completes it and advances `count`.
+typedef struct {
+  AutofireClickSample samples[AUTOFIRE_TRACE_SIZE];
+  uint32_t count;
+} AutofireClickTrace;
+
+// Release-to-release intervals of the last clicks with running sums for a
+// short and a long window, so a push is O(1) without any division.
+typedef struct {
+  uint16_t intervals_ms[AUTOFIRE_CPS_WINDOW_SIZE];
+  uint32_t count;
+  uint32_t short_sum_ms;
+  uint32_t long_sum_ms;
+} AutofireCpsWindow;
+
+typedef struct {
+  uint32_t clicks;
+  uint32_t intervals;
+  uint32_t min_ms;
+  uint32_t max_ms;
+  uint32_t p50_ms;
+  uint32_t p99_ms;
+  uint32_t jitter_x10_ms;
+} AutofireTraceStats;
+
+typedef struct {
+  uint32_t events[EventTypeCount];
+  uint32_t ticks;
+  uint32_t sequence_underruns;
+} AutofireDropStats;
+
+// Fixed-point PI rate controller. Times are in 1/256 ms so fractional
+// periods such as 69.93 ms for 14.3 CPS average out exactly.
+typedef struct {
+  uint32_t period_q8;
+  uint32_t carry_q8;
+  int32_t integral_q8;
+  int32_t correction_q8;
+  uint32_t ema_q8;
+  uint32_t start_tick;
+  uint32_t settle_ms;
+  uint32_t steady_intervals;
+  uint32_t steady_sum_ms;
+} AutofireRateControl;
+
+typedef struct {
+  uint32_t target_cps_x10;
+  uint32_t measured_cps_x100;
+  // Steady-state rate error in 0.01 % units.
+  int32_t error_bp;
+  uint32_t settle_ms;
+  uint32_t steady_intervals;
+} AutofireRateStats;
+
+typedef struct {
+  uint32_t enabled;
+  uint32_t mode;
+  uint32_t delay_ms;
+  uint32_t duty_percent;
+} AutofireChannelConfig;
+
+// Worker state of an extra channel. It runs on its own grid with the same
+// press/release phases as the main engine; a channel that falls a whole
+// cycle behind skips the missed clicks.
+typedef struct {
+  AutofireChannelConfig config;
+  AutofireTargetKind kind;
+  uint16_t hid_code;
+  bool pressed;
+  ClickPhase click_phase;
+  uint32_t next_at;
+  uint32_t clicks;
+} AutofireChannel;
+
+// Min-heap of channel indices ordered by their next deadline; channel 0 is
+// the main engine. One heap serves every active channel, so the worker
+// sleeps until the earliest deadline however many channels run.
+typedef struct {
+  uint8_t heap[AUTOFIRE_CHANNEL_COUNT];
+  uint8_t size;
+} AutofireScheduler;
+
+typedef struct {
+  AutofireTargetKind kind;
+  uint16_t code;
+  bool press;
+} AutofireHidChange;
+
+// HID changes due in one scheduler pass.
+typedef struct {
+  AutofireHidChange changes[AUTOFIRE_CHANNEL_COUNT];
+  uint32_t count;
+} AutofireHidBatch;
+
+typedef enum {
+  AutofireSeqOpPress,
+  AutofireSeqOpRelease,
+  AutofireSeqOpWait,
+  AutofireSeqOpLoop,
+  AutofireSeqOpNext,
+  AutofireSeqOpJump,
+} AutofireSeqOpcode;
+
+// One fixed-width sequence instruction. Press and release take the target
+// kind in `slot` and the HID code in `arg`; wait takes milliseconds; loop
+// loads counter `slot` with `arg`, and next decrements it and jumps to `arg`
+// while it is not zero; jump goes to `arg`.
+typedef struct {
+  uint8_t opcode;
+  uint8_t slot;
+  uint16_t arg;
+} AutofireSeqOp;
+
+// Double buffer of a streamed sequence. The worker owns the requests and
+// only reads a half whose state says its chunk is ready; the loader thread
+// fills a requested half and marks it ready unless the request changed in
+// the meantime.
+typedef struct {
+  FuriThread *loader;
+  FuriMessageQueue *requests;
+  // Chunk index << 1 | ready bit per half, or AUTOFIRE_SEQUENCE_CHUNK_NONE.
+  uint32_t state[2];
+  uint32_t chunk_count;
+  uint32_t loads;
+  uint32_t read_failures;
+  // Stalls where the next op was not in memory yet.
+  uint32_t underruns;
+} AutofireSequenceStream;
+
+// A sequence compiled once at launch. A resident program never changes
+// while the worker runs it; a streamed one is read in chunks into the two
+// halves of `ops`, so memory stays the same however long the script is.
+typedef struct {
+  AutofireSeqOp *ops;
+  uint32_t count;
+  // Length of one pass through the program, loops included.
+  uint32_t period_ms;
+  bool streamed;
+  AutofireSequenceStream stream;
+} AutofireSequence;
+
+// Worker state of a running sequence. It replaces the main click on
+// channel 0; waits advance an absolute deadline like the click phases do.
+typedef struct {
+  AutofireSequence *program;
+  AutofireTransport *transport;
+  uint32_t pc;
+  uint16_t counters[AUTOFIRE_SEQUENCE_MAX_DEPTH];
+  uint32_t next_at;
+  uint8_t mouse_held;
+  uint16_t keys_held[AUTOFIRE_SEQUENCE_MAX_KEYS];
+  uint32_t passes;
+  bool stalled;
+  // Chunk to prefetch while a streamed run is in `fetch_chunk`; worked out
+  // again after a loop op, since the counters decide where the run goes.
+  uint32_t fetch_chunk;
+  uint32_t prefetch_chunk;
+} AutofireSequenceRun;
+
+// Persisted settings, all fields 32-bit so the layout has no padding. Fields
+// are only ever appended, so a record from an older build is a prefix.
+typedef struct {
+  uint32_t delay_ms;
+  uint32_t mode;
+  uint32_t preset;
+  uint32_t startup_policy;
+  uint32_t last_active;
+  uint32_t late_policy;
+  uint32_t duty_percent;
+  uint32_t frame_align_ms;
+  uint32_t target_cps_x10;
+  uint32_t key_code;
+  uint32_t key_modifiers;
+  AutofireChannelConfig channels[AUTOFIRE_EXTRA_CHANNEL_COUNT];
+  uint32_t sequence_enabled;
+  uint32_t burst_count;
+  uint32_t burst_interval_ms;
+  uint32_t hold_to_fire;
+  uint32_t transport;
+  uint32_t capture;
+  uint32_t input_log;
+} AutofireSettings;
+
+// On-disk record, read and written with a single storage call. The CRC-32
+// covers everything before it.
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  AutofireSettings settings;
+  uint32_t crc;
+} AutofireSettingsRecord;
+
 typedef struct {
   union {
     InputEvent input;
@@ -76,25 +499,298 @@ typedef struct {
   EventType type;
 } UsbMouseEvent;
 
+// The hold flags come straight from the input callback, so hold-to-fire
+// does not wait for the main loop.
+typedef enum {
+  ClickWorkerFlagCommand = (1 << 0),
+  ClickWorkerFlagExit = (1 << 1),
+  ClickWorkerFlagHoldPress = (1 << 2),
+  ClickWorkerFlagHoldRelease = (1 << 3),
+} ClickWorkerFlag;
+
+#define CLICK_WORKER_FLAGS_ALL                                                 \
+  (ClickWorkerFlagCommand | ClickWorkerFlagExit | ClickWorkerFlagHoldPress |  \
+   ClickWorkerFlagHoldRelease)
+
+typedef enum {
+  SettingsWriterFlagSave = (1 << 0),
+  SettingsWriterFlagExit = (1 << 1),
+} SettingsWriterFlag;
+
+#define SETTINGS_WRITER_FLAGS_ALL                                              \
+  (SettingsWriterFlagSave | SettingsWriterFlagExit)
+
+typedef enum {
+  CaptureWriterFlagFlush = (1 << 0),
+  CaptureWriterFlagExit = (1 << 1),
+} CaptureWriterFlag;
+
+#define CAPTURE_WRITER_FLAGS_ALL                                               \
+  (CaptureWriterFlagFlush | CaptureWriterFlagExit)
+
+typedef enum {
+  AutofireCaptureFlagPress = (1 << 0),
+  AutofireCaptureFlagMouse = (1 << 1),
+} AutofireCaptureFlag;
+
+// One scheduled HID change, 12 bytes on SD in the device's little-endian
+// order. `sequence` counts every change, so a gap marks dropped records.
+typedef struct {
+  uint32_t tick;
+  uint16_t sequence;
+  uint16_t code;
+  // Time past the channel's deadline, saturated.
+  uint16_t late_ms;
+  uint8_t channel;
+  uint8_t flags;
+} AutofireCaptureRecord;
+
+// Starts every capture file, including one started by a rollover.
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+} AutofireCaptureHeader;
+
+// Report capture, set up at launch when enabled. The click worker fills
+// `blocks[active]` and hands a full block to the low-priority writer by
+// setting its `pending` bit; it only moves on to the other block once the
+// writer has cleared that one's bit, and drops records until then.
+typedef struct {
+  FuriThread *thread;
+  AutofireCaptureRecord *blocks;
+  uint32_t counts[2];
+  uint32_t pending;
+  uint32_t active;
+  uint32_t fill;
+  uint16_t sequence;
+  uint32_t records;
+  uint32_t dropped;
+  // Writer side.
+  uint32_t file_bytes;
+  uint32_t blocks_written;
+  uint32_t rollovers;
+  uint32_t failures;
+} AutofireCapture;
+
+// One input event as the input callback saw it, 8 bytes on SD.
+typedef struct {
+  uint32_t tick;
+  uint16_t sequence;
+  uint8_t key;
+  uint8_t type;
+} AutofireInputRecord;
+
+// Starts the input log, followed by the settings the app ran with, so a
+// replay starts from the same state. Older settings are a prefix of newer
+// ones, as in the settings record.
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint16_t settings_size;
+  uint16_t reserved;
+  // Tick the log was opened at, shortly after launch.
+  uint32_t start_tick;
+} AutofireInputLogHeader;
+
+// Input log, opened at launch when enabled. The input callback only fills
+// `records`, a ring allocated at start, up to `head`; the main loop writes
+// them out and advances `tail`.
+typedef struct {
+  File *file;
+  AutofireInputRecord *records;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t file_bytes;
+  uint32_t written;
+  // Counted by the input callback and the main loop respectively.
+  uint32_t dropped;
+  uint32_t truncated;
+} AutofireInputLog;
+
+// Low-priority thread that persists settings snapshots. The main loop only
+// replaces `pending`; `written` is what the file holds and is touched by the
+// writer alone once it runs.
+typedef struct {
+  FuriThread *thread;
+  FuriMutex *mutex;
+  AutofireSettings pending;
+  bool has_pending;
+  AutofireSettings written;
+  bool has_written;
+  uint32_t writes;
+  uint32_t skips;
+  uint32_t failures;
+  uint32_t last_ms;
+  uint32_t worst_ms;
+} AutofireSettingsWriter;
+
+typedef enum {
+  ClickWorkerCommandStart,
+  ClickWorkerCommandStop,
+  ClickWorkerCommandConfigure,
+} ClickWorkerCommandType;
+
+typedef struct {
+  ClickWorkerCommandType type;
+  AutofireMode mode;
+  uint16_t hid_code;
+  uint32_t delay_ms;
+  uint32_t duty_percent;
+  uint32_t frame_align_ms;
+  uint32_t target_cps_x10;
+  AutofireLatePolicy late_policy;
+  AutofireChannelConfig channels[AUTOFIRE_EXTRA_CHANNEL_COUNT];
+  uint16_t channel_hid_codes[AUTOFIRE_EXTRA_CHANNEL_COUNT];
+  bool sequence_enabled;
+  uint32_t burst_count;
+  uint32_t burst_interval_ms;
+  // Start number of the run, echoed back when its burst ends.
+  uint32_t run;
+} ClickWorkerCommand;
+
+// Press/release engine state. Only the click worker thread writes it; other
+// threads read it while holding engine_mutex.
+typedef struct {
+  bool active;
+  bool pressed;
+  ClickPhase click_phase;
+  AutofireMode mode;
+  // Resolved from the target table when the mode is configured.
+  AutofireTargetKind kind;
+  uint16_t hid_code;
+  uint32_t delay_ms;
+  uint32_t duty_percent;
+  uint32_t frame_align_ms;
+  uint32_t target_cps_x10;
+  AutofireLatePolicy late_policy;
+  uint32_t cycle_gap_ticks;
+  uint32_t next_press_at;
+  uint32_t next_release_at;
+  uint32_t last_transition_tick;
+  uint32_t last_click_release_tick_ms;
+  AutofireCpsWindow cps_window;
+  // Deadlines serviced a full cycle or more late.
+  uint32_t tick_drops;
+  AutofireRateControl rate;
+  // Allocated at launch, so the engine stays small.
+  AutofireClickTrace *trace;
+  AutofireChannel channels[AUTOFIRE_EXTRA_CHANNEL_COUNT];
+  AutofireScheduler scheduler;
+  uint32_t scheduler_passes;
+  // Changes that shared a report with another change in the same pass.
+  uint32_t merged_changes;
+  bool sequence_enabled;
+  AutofireSequenceRun sequence;
+  // Clicks per burst, 0 for endless firing, and the pause between bursts,
+  // 0 to stop after one.
+  uint32_t burst_count;
+  uint32_t burst_interval_ms;
+  uint32_t burst_clicks;
+  bool burst_done;
+  uint32_t run;
+  // Last run whose burst ended, read by the main loop.
+  uint32_t burst_done_run;
+  // Tick and run number of the last hold-to-fire press, stored by the
+  // input callback.
+  uint32_t hold_input_tick;
+  uint32_t hold_run;
+  bool hold_report_pending;
+  uint32_t hold_starts;
+  // Input callback to first report, published for the main screen.
+  uint32_t hold_latency_ms;
+  uint32_t hold_latency_max_ms;
+} AutofireEngine;
+
+#ifdef USB_HID_AUTOFIRE_PROFILE
+typedef enum {
+  AutofireProfileTick,
+  AutofireProfileInput,
+  AutofireProfileRender,
+  AutofireProfileSave,
+  AutofireProfileCount,
+} AutofireProfileSection;
+
+// CPU cycles spent in one section. Each section is timed on one thread, so
+// updates take no lock; a reader may see one sample half applied.
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} AutofireProfileStat;
+
+#define AUTOFIRE_PROFILE_BEGIN(var)                                            \
+  uint32_t var = usb_hid_autofire_profile_cycles()
+#define AUTOFIRE_PROFILE_END(app, section, var)                                \
+  usb_hid_autofire_profile_record(&(app)->profile[section], var)
+#else
+#define AUTOFIRE_PROFILE_BEGIN(var)
+#define AUTOFIRE_PROFILE_END(app, section, var)
+#endif
+
+// Parts of the view model a state change makes stale. The main screen is
+// formatted line by line; any change on another screen reformats the page.
+typedef enum {
+  AutofireViewStatus = (1 << 0),
+  AutofireViewMode = (1 << 1),
+  AutofireViewPreset = (1 << 2),
+  AutofireViewRate = (1 << 3),
+  AutofireViewPage = (1 << 4),
+  AutofireViewAll = 0x1F,
+} AutofireViewField;
+
+// Display strings for the current screen, formatted by the main loop when
+// state changes so the draw callback only blits them. Guarded by mutex
+// because the GUI thread draws.
+typedef struct {
+  FuriMutex *mutex;
+  AutofireScreen screen;
+  uint32_t dirty;
+  char lines[AUTOFIRE_VIEW_LINES][AUTOFIRE_VIEW_LINE_SIZE];
+  // Main screen lines and whole pages formatted since launch.
+  uint32_t formats;
+} AutofireViewModel;
+
+typedef struct {
+  uint32_t refresh_wakeups;
+  uint32_t redraws;
+  // Loop passes that held back a due redraw to honor the minimum interval.
+  uint32_t deferred_redraws;
+  uint32_t active_ms;
+} AutofireUiStats;
+
 typedef struct {
   FuriMessageQueue *event_queue;
   ViewPort *view_port;
   Gui *gui;
   DialogsApp *dialogs;
-  FuriTimer *click_timer;
+  FuriThread *click_worker;
+  AutofireSettingsWriter settings_writer;
+  FuriMessageQueue *click_commands;
+  FuriMutex *engine_mutex;
   FuriTimer *ui_refresh_timer;
   FuriTimer *settings_save_timer;
-  FuriHalUsbInterface *usb_mode_prev;
+  // Opened at launch; a changed `transport_type` applies on the next one.
+  AutofireTransport transport;
+  // Written from timer and input callbacks, so only touched atomically.
+  uint32_t event_pending;
+  uint32_t event_drops[EventTypeCount];
   bool active;
-  bool mouse_pressed;
   bool ui_dirty;
   bool settings_dirty;
-  bool show_help;
+  AutofireScreen screen;
+  AutofireOption option;
   bool last_active_state;
   uint32_t autofire_delay_ms;
+  uint32_t duty_percent;
+  // Assumed USB poll interval for frame-aligned timing, 0 when off.
+  uint32_t frame_align_ms;
+  // Closed-loop target rate, 0 when the delay drives the schedule.
+  uint32_t target_cps_x10;
   uint32_t realtime_cps_x10;
-  uint32_t last_click_release_tick_ms;
-  uint32_t last_click_interval_ms;
+  uint32_t realtime_long_cps_x10;
   bool adjust_hold_active;
   InputKey adjust_hold_key;
   uint16_t adjust_repeat_count;
@@ -103,13 +799,50 @@ typedef struct {
   bool ok_long_handled;
   bool back_long_handled;
   AutofireMode mode;
+  uint32_t key_code;
+  uint32_t key_modifiers;
   AutofirePreset preset;
   AutofireStartupPolicy startup_policy;
-  ClickPhase click_phase;
+  AutofireLatePolicy late_policy;
+  AutofireChannelConfig channels[AUTOFIRE_EXTRA_CHANNEL_COUNT];
+  // Channel times AutofireChannelFieldCount plus field.
+  uint32_t channel_cursor;
+  AutofireSequence sequence;
+  bool sequence_enabled;
+  uint32_t burst_count;
+  uint32_t burst_interval_ms;
+  // Bumped on every start so a late burst end cannot stop a newer run. A
+  // hold press takes its number in the input callback, so it is atomic.
+  uint32_t run;
+  bool hold_to_fire;
+  // Read by the input callback: hold-to-fire is on and OK reaches the main
+  // screen. `hold_down` is set while a press it let through is held.
+  bool hold_armed;
+  bool hold_down;
+  AutofireTransportType transport_type;
+  bool capture_enabled;
+  AutofireCapture capture;
+  bool input_log_enabled;
+  AutofireInputLog input_log;
+  AutofireEngine engine;
+  AutofireTraceStats trace_stats;
+  AutofireDropStats drop_stats;
+  AutofireRateStats rate_stats;
+  AutofireExportResult trace_export_result;
+  AutofireViewModel view;
+  // Current live refresh period, 0 while suspended.
+  uint32_t ui_refresh_period_ms;
+  uint32_t ui_quiet_refreshes;
+  uint32_t ui_last_input_tick;
+  uint32_t ui_last_redraw_tick;
+  uint32_t ui_active_since_tick;
+  AutofireUiStats ui_stats;
+#ifdef USB_HID_AUTOFIRE_PROFILE
+  AutofireProfileStat profile[AutofireProfileCount];
+#endif
 } UsbHidAutofireApp;
 
 void usb_hid_autofire_input_callback(InputEvent *input_event, void *ctx);
-void usb_hid_autofire_timer_callback(void *ctx);
 void usb_hid_autofire_ui_timer_callback(void *ctx);
 void usb_hid_autofire_settings_save_timer_callback(void *ctx);
 
@@ -118,44 +851,226 @@ uint32_t usb_hid_autofire_delay_decrease(uint32_t delay_ms, uint32_t step_ms);
 uint32_t usb_hid_autofire_delay_increase(uint32_t delay_ms, uint32_t step_ms);
 uint32_t usb_hid_autofire_accel_step_ms(uint16_t repeat_count);
 uint32_t usb_hid_autofire_config_cps_x10_for_delay(uint32_t delay_ms);
+uint32_t usb_hid_autofire_duty_clamp(uint32_t duty_percent);
+uint32_t usb_hid_autofire_hold_ms(uint32_t delay_ms, uint32_t duty_percent);
+void usb_hid_autofire_phase_ms(uint32_t delay_ms, uint32_t duty_percent,
+                               uint32_t frame_align_ms, uint32_t *hold_ms,
+                               uint32_t *gap_ms);
+uint32_t usb_hid_autofire_max_lossless_cps_x10(uint32_t poll_ms);
+uint32_t usb_hid_autofire_next_frame_align(uint32_t frame_align_ms);
+uint32_t usb_hid_autofire_target_cps_clamp(uint32_t target_cps_x10);
+uint32_t usb_hid_autofire_next_burst_count(uint32_t burst_count);
+uint32_t usb_hid_autofire_next_burst_interval(uint32_t interval_ms);
+
+const AutofireTarget *usb_hid_autofire_target(AutofireMode mode);
+void usb_hid_autofire_hid_batch_add(AutofireHidBatch *batch,
+                                    AutofireTargetKind kind, uint16_t code,
+                                    bool press);
+uint32_t usb_hid_autofire_hid_batch_flush(AutofireHidBatch *batch,
+                                          AutofireTransport *transport);
+
+void usb_hid_autofire_transport_init(AutofireTransport *transport,
+                                     AutofireTransportType type);
+bool usb_hid_autofire_transport_open(AutofireTransport *transport);
+void usb_hid_autofire_transport_close(AutofireTransport *transport);
+bool usb_hid_autofire_transport_send(AutofireTransport *transport,
+                                     AutofireTargetKind kind, uint16_t code,
+                                     bool press);
+bool usb_hid_autofire_transport_is_valid(uint32_t transport_type);
+const char *usb_hid_autofire_transport_label(AutofireTransportType type);
+bool usb_hid_autofire_loopback_export(const AutofireLoopback *loopback);
+
+void usb_hid_autofire_channel_defaults(AutofireChannelConfig *channels);
+bool usb_hid_autofire_channel_is_valid(const AutofireChannelConfig *channel);
+uint32_t usb_hid_autofire_channel_next_delay(uint32_t delay_ms);
+void usb_hid_autofire_format_channel_delay(char *out, size_t out_size,
+                                           uint32_t delay_ms);
+void usb_hid_autofire_channel_configure(AutofireChannel *channel,
+                                        const AutofireChannelConfig *config,
+                                        uint16_t hid_code, bool active,
+                                        AutofireTransport *transport);
+void usb_hid_autofire_channel_start(AutofireChannel *channel, uint32_t now);
+void usb_hid_autofire_channel_stop(AutofireChannel *channel,
+                                   AutofireTransport *transport);
+void usb_hid_autofire_channel_tick(AutofireChannel *channel,
+                                   AutofireHidBatch *batch);
+void usb_hid_autofire_scheduler_push(AutofireEngine *engine, uint8_t channel);
+uint8_t usb_hid_autofire_scheduler_pop(AutofireEngine *engine);
+bool usb_hid_autofire_scheduler_peek(const AutofireEngine *engine,
+                                     uint32_t *deadline);
+void usb_hid_autofire_scheduler_rebuild(AutofireEngine *engine);
 
-const char *usb_hid_autofire_mode_label(AutofireMode mode);
+bool usb_hid_autofire_sequence_load(AutofireSequence *sequence);
+void usb_hid_autofire_sequence_free(AutofireSequence *sequence);
+void usb_hid_autofire_sequence_start(AutofireSequenceRun *run, uint32_t now);
+void usb_hid_autofire_sequence_stop(AutofireSequenceRun *run);
+void usb_hid_autofire_sequence_tick(AutofireSequenceRun *run,
+                                    AutofireHidBatch *batch,
+                                    AutofireLatePolicy late_policy);
+uint16_t usb_hid_autofire_target_code(AutofireMode mode, uint32_t key_code,
+                                      uint32_t key_modifiers);
+bool usb_hid_autofire_parse_target(const char *name, AutofireTargetKind *kind,
+                                   uint16_t *code);
+void usb_hid_autofire_format_key(char *out, size_t out_size,
+                                 uint32_t key_code);
+void usb_hid_autofire_format_modifiers(char *out, size_t out_size,
+                                       uint32_t key_modifiers);
+void usb_hid_autofire_format_target(char *out, size_t out_size,
+                                    AutofireMode mode, uint32_t key_code,
+                                    uint32_t key_modifiers);
 AutofireMode usb_hid_autofire_next_mode(AutofireMode mode);
 AutofireMode usb_hid_autofire_prev_mode(AutofireMode mode);
 const char *usb_hid_autofire_preset_label(AutofirePreset preset);
 uint32_t usb_hid_autofire_preset_delay_ms(AutofirePreset preset);
 AutofirePreset usb_hid_autofire_next_preset(AutofirePreset preset);
+const char *usb_hid_autofire_late_policy_label(AutofireLatePolicy late_policy);
 
 bool usb_hid_autofire_mode_is_valid(uint32_t mode_value);
+bool usb_hid_autofire_key_code_is_valid(uint32_t key_code);
+bool usb_hid_autofire_key_modifiers_is_valid(uint32_t key_modifiers);
 bool usb_hid_autofire_preset_is_valid(uint32_t preset_value);
 bool usb_hid_autofire_startup_policy_is_valid(uint32_t startup_policy_value);
+bool usb_hid_autofire_late_policy_is_valid(uint32_t late_policy_value);
+bool usb_hid_autofire_duty_is_valid(uint32_t duty_percent);
+bool usb_hid_autofire_frame_align_is_valid(uint32_t frame_align_ms);
+bool usb_hid_autofire_target_cps_is_valid(uint32_t target_cps_x10);
+bool usb_hid_autofire_burst_count_is_valid(uint32_t burst_count);
+bool usb_hid_autofire_burst_interval_is_valid(uint32_t interval_ms);
 
 void usb_hid_autofire_format_cps(char *out, size_t out_size, uint32_t cps_x10);
 
+void usb_hid_autofire_app_defaults(UsbHidAutofireApp *app);
+void usb_hid_autofire_engine_init(UsbHidAutofireApp *app);
+
 void usb_hid_autofire_render_callback(Canvas *canvas, void *ctx);
+void usb_hid_autofire_view_invalidate(UsbHidAutofireApp *app, uint32_t fields);
+void usb_hid_autofire_view_update(UsbHidAutofireApp *app);
+void usb_hid_autofire_ui_refresh_update(UsbHidAutofireApp *app);
+void usb_hid_autofire_ui_refresh_done(UsbHidAutofireApp *app, bool changed);
+uint32_t usb_hid_autofire_ui_redraw_wait_ms(const UsbHidAutofireApp *app);
+void usb_hid_autofire_ui_redraw(UsbHidAutofireApp *app);
 
-uint32_t usb_hid_autofire_realtime_cps_x10(const UsbHidAutofireApp *app);
+void usb_hid_autofire_realtime_cps_x10(UsbHidAutofireApp *app,
+                                       uint32_t *short_x10,
+                                       uint32_t *long_x10);
 void usb_hid_autofire_reset_cps_tracking(UsbHidAutofireApp *app);
+bool usb_hid_autofire_post_event(UsbHidAutofireApp *app,
+                                 const UsbMouseEvent *event);
+FuriStatus usb_hid_autofire_get_event(UsbHidAutofireApp *app,
+                                      UsbMouseEvent *event, uint32_t timeout);
 void usb_hid_autofire_drain_event_queue(UsbHidAutofireApp *app,
                                         uint8_t max_count);
-void usb_hid_autofire_press_mode_control(UsbHidAutofireApp *app);
-void usb_hid_autofire_release_mode_control(UsbHidAutofireApp *app);
 void usb_hid_autofire_schedule_next_tick(UsbHidAutofireApp *app);
+void usb_hid_autofire_restart_schedule(UsbHidAutofireApp *app);
+uint32_t usb_hid_autofire_ticks_until_next_tick(const UsbHidAutofireApp *app);
 void usb_hid_autofire_start(UsbHidAutofireApp *app);
 void usb_hid_autofire_stop(UsbHidAutofireApp *app);
-void usb_hid_autofire_tick(UsbHidAutofireApp *app);
+void usb_hid_autofire_send_config(UsbHidAutofireApp *app);
+void usb_hid_autofire_tick(UsbHidAutofireApp *app, AutofireHidBatch *batch);
+bool usb_hid_autofire_burst_finished(const UsbHidAutofireApp *app);
+void usb_hid_autofire_hold_input(UsbHidAutofireApp *app, InputType type);
+void usb_hid_autofire_hold_changed(UsbHidAutofireApp *app, bool held);
+
+bool usb_hid_autofire_worker_start(UsbHidAutofireApp *app);
+void usb_hid_autofire_worker_stop(UsbHidAutofireApp *app);
+
+void usb_hid_autofire_trace_reset(AutofireClickTrace *trace);
+void usb_hid_autofire_trace_record_press(AutofireClickTrace *trace,
+                                         uint32_t tick);
+void usb_hid_autofire_trace_record_release(AutofireClickTrace *trace,
+                                           uint32_t tick);
+void usb_hid_autofire_trace_compute_stats(const AutofireClickTrace *trace,
+                                          AutofireTraceStats *stats);
+bool usb_hid_autofire_trace_export(const AutofireClickTrace *trace);
+bool usb_hid_autofire_export_trace(UsbHidAutofireApp *app);
+bool usb_hid_autofire_refresh_trace_stats(UsbHidAutofireApp *app);
+
+void usb_hid_autofire_rate_reset(AutofireRateControl *rate, uint32_t period_q8,
+                                 uint32_t tick);
+uint32_t usb_hid_autofire_rate_next_cycle_ms(AutofireRateControl *rate,
+                                             bool closed_loop);
+uint32_t usb_hid_autofire_rate_cycle_ms(const AutofireRateControl *rate);
+void usb_hid_autofire_rate_record_interval(AutofireRateControl *rate,
+                                           uint32_t interval_ms,
+                                           uint32_t tick);
+void usb_hid_autofire_rate_compute_stats(const AutofireRateControl *rate,
+                                         AutofireRateStats *stats);
+bool usb_hid_autofire_refresh_rate_stats(UsbHidAutofireApp *app);
+void usb_hid_autofire_cps_window_reset(AutofireCpsWindow *window);
+void usb_hid_autofire_cps_window_push(AutofireCpsWindow *window,
+                                      uint32_t interval_ms);
+uint32_t usb_hid_autofire_cps_window_cps_x10(const AutofireCpsWindow *window,
+                                             bool long_window,
+                                             uint32_t open_ms);
+
+#ifdef USB_HID_AUTOFIRE_PROFILE
+uint32_t usb_hid_autofire_profile_cycles(void);
+void usb_hid_autofire_profile_record(AutofireProfileStat *stat,
+                                     uint32_t start);
+void usb_hid_autofire_profile_format(char *out, size_t out_size,
+                                     const AutofireProfileStat *stat,
+                                     AutofireProfileSection section);
+void usb_hid_autofire_profile_log(const UsbHidAutofireApp *app);
+#endif
 
 void usb_hid_autofire_mark_settings_dirty(UsbHidAutofireApp *app);
 bool usb_hid_autofire_settings_load(UsbHidAutofireApp *app);
+void usb_hid_autofire_settings_seal(AutofireSettingsRecord *record);
+void usb_hid_autofire_settings_snapshot(const UsbHidAutofireApp *app,
+                                        AutofireSettings *settings);
 void usb_hid_autofire_settings_flush_if_dirty(UsbHidAutofireApp *app);
+bool usb_hid_autofire_settings_writer_start(UsbHidAutofireApp *app);
+void usb_hid_autofire_settings_writer_stop(UsbHidAutofireApp *app);
+
+bool usb_hid_autofire_capture_start(AutofireCapture *capture);
+void usb_hid_autofire_capture_stop(AutofireCapture *capture);
+void usb_hid_autofire_capture_record(AutofireCapture *capture,
+                                     const AutofireHidChange *change,
+                                     uint8_t channel, uint32_t tick,
+                                     uint32_t late_ms);
+void usb_hid_autofire_capture_flush(AutofireCapture *capture);
+
+bool usb_hid_autofire_input_log_start(AutofireInputLog *log,
+                                      const AutofireSettings *settings);
+void usb_hid_autofire_input_log_stop(AutofireInputLog *log);
+void usb_hid_autofire_input_log_record(AutofireInputLog *log,
+                                       const InputEvent *event);
+void usb_hid_autofire_input_log_flush(AutofireInputLog *log, bool all);
 
 bool usb_hid_autofire_set_mode(UsbHidAutofireApp *app, AutofireMode new_mode);
+bool usb_hid_autofire_set_key_code(UsbHidAutofireApp *app, uint32_t key_code);
+bool usb_hid_autofire_set_key_modifiers(UsbHidAutofireApp *app,
+                                        uint32_t key_modifiers);
 bool usb_hid_autofire_set_delay(UsbHidAutofireApp *app, uint32_t new_delay_ms,
                                 AutofirePreset new_preset);
+bool usb_hid_autofire_set_duty(UsbHidAutofireApp *app, uint32_t duty_percent);
+bool usb_hid_autofire_set_late_policy(UsbHidAutofireApp *app,
+                                      AutofireLatePolicy late_policy);
+bool usb_hid_autofire_set_frame_align(UsbHidAutofireApp *app,
+                                      uint32_t frame_align_ms);
+bool usb_hid_autofire_set_target_cps(UsbHidAutofireApp *app,
+                                     uint32_t target_cps_x10);
+bool usb_hid_autofire_set_channel(UsbHidAutofireApp *app, uint32_t index,
+                                  const AutofireChannelConfig *config);
+bool usb_hid_autofire_set_sequence_enabled(UsbHidAutofireApp *app,
+                                           bool enabled);
+bool usb_hid_autofire_set_burst(UsbHidAutofireApp *app, uint32_t burst_count,
+                                uint32_t interval_ms);
+void usb_hid_autofire_handle_burst_done(UsbHidAutofireApp *app);
+bool usb_hid_autofire_set_hold_to_fire(UsbHidAutofireApp *app, bool enabled);
+bool usb_hid_autofire_set_transport(UsbHidAutofireApp *app,
+                                    AutofireTransportType type);
+bool usb_hid_autofire_set_capture(UsbHidAutofireApp *app, bool enabled);
+bool usb_hid_autofire_set_input_log(UsbHidAutofireApp *app, bool enabled);
+void usb_hid_autofire_update_hold_armed(UsbHidAutofireApp *app);
 void usb_hid_autofire_adjust_delay(UsbHidAutofireApp *app, InputKey key,
                                    uint32_t step_ms);
 void usb_hid_autofire_apply_preset_request(UsbHidAutofireApp *app,
                                            AutofirePreset preset);
+void usb_hid_autofire_set_screen(UsbHidAutofireApp *app,
+                                 AutofireScreen screen);
+void usb_hid_autofire_handle_info_input(UsbHidAutofireApp *app,
+                                        const InputEvent *input);
 void usb_hid_autofire_handle_delay_input(UsbHidAutofireApp *app,
                                          const InputEvent *input);
 void usb_hid_autofire_handle_mode_input(UsbHidAutofireApp *app,
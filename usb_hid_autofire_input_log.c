@@ -0,0 +1,120 @@
+#include "usb_hid_autofire_i.h"
+
+// Each launch starts a new log and keeps the previous one as the old log.
+bool usb_hid_autofire_input_log_start(AutofireInputLog *log,
+                                      const AutofireSettings *settings) {
+  log->records =
+      malloc(AUTOFIRE_INPUT_LOG_RECORDS * sizeof(AutofireInputRecord));
+  if (!log->records) {
+    return false;
+  }
+
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  storage_common_remove(storage, USB_HID_AUTOFIRE_INPUT_LOG_OLD_PATH);
+  storage_common_rename(storage, USB_HID_AUTOFIRE_INPUT_LOG_PATH,
+                        USB_HID_AUTOFIRE_INPUT_LOG_OLD_PATH);
+
+  const AutofireInputLogHeader header = {
+      .magic = USB_HID_AUTOFIRE_INPUT_LOG_MAGIC,
+      .version = USB_HID_AUTOFIRE_INPUT_LOG_VERSION,
+      .record_size = sizeof(AutofireInputRecord),
+      .settings_size = sizeof(AutofireSettings),
+      .start_tick = furi_get_tick(),
+  };
+  File *file = storage_file_alloc(storage);
+  bool ok = file &&
+            storage_file_open(file, USB_HID_AUTOFIRE_INPUT_LOG_PATH,
+                              FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+            (storage_file_write(file, &header, sizeof(header)) ==
+             sizeof(header)) &&
+            (storage_file_write(file, settings, sizeof(AutofireSettings)) ==
+             sizeof(AutofireSettings));
+  if (!ok) {
+    if (file) {
+      storage_file_close(file);
+      storage_file_free(file);
+    }
+    furi_record_close(RECORD_STORAGE);
+    free(log->records);
+    log->records = NULL;
+    return false;
+  }
+
+  log->file_bytes = sizeof(header) + sizeof(AutofireSettings);
+  // Published last: the input callback records only once the file is set.
+  __atomic_store_n(&log->file, file, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Call once the view port is gone, so no input callback is still running.
+void usb_hid_autofire_input_log_stop(AutofireInputLog *log) {
+  if (!log->file) {
+    return;
+  }
+
+  usb_hid_autofire_input_log_flush(log, true);
+  storage_file_close(log->file);
+  storage_file_free(log->file);
+  log->file = NULL;
+  free(log->records);
+  log->records = NULL;
+  furi_record_close(RECORD_STORAGE);
+  FURI_LOG_I(TAG, "Input log: %lu events, %lu dropped, %lu past the limit",
+             (unsigned long)log->written, (unsigned long)log->dropped,
+             (unsigned long)log->truncated);
+}
+
+// Runs in the input callback, so it only copies the event; a full buffer
+// drops it.
+void usb_hid_autofire_input_log_record(AutofireInputLog *log,
+                                       const InputEvent *event) {
+  if (!__atomic_load_n(&log->file, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  uint32_t head = log->head;
+  if ((head - __atomic_load_n(&log->tail, __ATOMIC_ACQUIRE)) >=
+      AUTOFIRE_INPUT_LOG_RECORDS) {
+    log->dropped++;
+    return;
+  }
+  log->records[head % AUTOFIRE_INPUT_LOG_RECORDS] = (AutofireInputRecord){
+      .tick = furi_get_tick(),
+      .sequence = (uint16_t)event->sequence,
+      .key = (uint8_t)event->key,
+      .type = (uint8_t)event->type,
+  };
+  __atomic_store_n(&log->head, head + 1U, __ATOMIC_RELEASE);
+}
+
+// Writes buffered events from the main loop once enough have piled up, or
+// all of them with `all`. Past the size limit they are dropped.
+void usb_hid_autofire_input_log_flush(AutofireInputLog *log, bool all) {
+  if (!log->file) {
+    return;
+  }
+
+  uint32_t tail = log->tail;
+  uint32_t pending = __atomic_load_n(&log->head, __ATOMIC_ACQUIRE) - tail;
+  if ((pending == 0U) ||
+      (!all && (pending < AUTOFIRE_INPUT_LOG_FLUSH_RECORDS))) {
+    return;
+  }
+
+  while (pending > 0U) {
+    uint32_t index = tail % AUTOFIRE_INPUT_LOG_RECORDS;
+    uint32_t count = AUTOFIRE_INPUT_LOG_RECORDS - index;
+    count = (count < pending) ? count : pending;
+    size_t size = count * sizeof(AutofireInputRecord);
+    if (((log->file_bytes + size) <= AUTOFIRE_INPUT_LOG_MAX_BYTES) &&
+        (storage_file_write(log->file, &log->records[index], size) == size)) {
+      log->file_bytes += size;
+      log->written += count;
+    } else {
+      log->truncated += count;
+    }
+    tail += count;
+    pending -= count;
+  }
+  __atomic_store_n(&log->tail, tail, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,79 @@
+#include "usb_hid_autofire_i.h"
+
+#ifdef USB_HID_AUTOFIRE_PROFILE
+
+static const char *const usb_hid_autofire_profile_names[AutofireProfileCount] =
+    {"Tick", "Input", "Render", "Save"};
+
+// The DWT cycle counter the firmware already runs for microsecond delays.
+uint32_t usb_hid_autofire_profile_cycles(void) {
+  return furi_hal_cortex_timer_get(0).start;
+}
+
+void usb_hid_autofire_profile_record(AutofireProfileStat *stat,
+                                     uint32_t start) {
+  uint32_t cycles = usb_hid_autofire_profile_cycles() - start;
+  if ((stat->count == 0U) || (cycles < stat->min)) {
+    stat->min = cycles;
+  }
+  if (cycles > stat->max) {
+    stat->max = cycles;
+  }
+  stat->sum += cycles;
+  stat->count++;
+}
+
+typedef char AutofireProfileUs[12];
+
+// Min, mean and max in microseconds with one decimal; the counter runs at
+// the core clock.
+static void usb_hid_autofire_profile_format_us(const AutofireProfileStat *stat,
+                                               AutofireProfileUs *out) {
+  const uint64_t cycles[3] = {stat->min, stat->sum / stat->count, stat->max};
+  uint32_t per_us = furi_hal_cortex_instructions_per_microsecond();
+  for (size_t i = 0; i < COUNT_OF(cycles); i++) {
+    uint64_t us_x10 = (cycles[i] * 10U) / per_us;
+    snprintf(out[i], sizeof(out[i]), "%lu.%lu", (unsigned long)(us_x10 / 10U),
+             (unsigned long)(us_x10 % 10U));
+  }
+}
+
+// One screen row: name, calls and min/mean/max in microseconds.
+void usb_hid_autofire_profile_format(char *out, size_t out_size,
+                                     const AutofireProfileStat *stat,
+                                     AutofireProfileSection section) {
+  uint32_t count = stat->count;
+  if (count == 0U) {
+    snprintf(out, out_size, "%s -", usb_hid_autofire_profile_names[section]);
+    return;
+  }
+
+  AutofireProfileUs us[3];
+  usb_hid_autofire_profile_format_us(stat, us);
+  // Large counts in thousands so the times still fit the row.
+  if (count >= 10000U) {
+    snprintf(out, out_size, "%s %luk %s/%s/%s",
+             usb_hid_autofire_profile_names[section],
+             (unsigned long)(count / 1000U), us[0], us[1], us[2]);
+  } else {
+    snprintf(out, out_size, "%s %lu %s/%s/%s",
+             usb_hid_autofire_profile_names[section], (unsigned long)count,
+             us[0], us[1], us[2]);
+  }
+}
+
+void usb_hid_autofire_profile_log(const UsbHidAutofireApp *app) {
+  for (uint32_t i = 0U; i < AutofireProfileCount; i++) {
+    const AutofireProfileStat *stat = &app->profile[i];
+    if (stat->count == 0U) {
+      continue;
+    }
+    AutofireProfileUs us[3];
+    usb_hid_autofire_profile_format_us(stat, us);
+    FURI_LOG_I(TAG, "Profile %s: %lu calls, min %sus, mean %sus, max %sus",
+               usb_hid_autofire_profile_names[i], (unsigned long)stat->count,
+               us[0], us[1], us[2]);
+  }
+}
+
+#endif
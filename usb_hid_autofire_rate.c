@@ -0,0 +1,185 @@
+#include "usb_hid_autofire_i.h"
+
+#define AUTOFIRE_RATE_MIN_CYCLE_Q8 (2U << 8)
+
+void usb_hid_autofire_rate_reset(AutofireRateControl *rate, uint32_t period_q8,
+                                 uint32_t tick) {
+  memset(rate, 0, sizeof(AutofireRateControl));
+  rate->period_q8 = period_q8;
+  rate->start_tick = tick;
+}
+
+static uint32_t usb_hid_autofire_rate_cycle_q8(const AutofireRateControl *rate,
+                                               bool closed_loop) {
+  int32_t cycle_q8 = (int32_t)rate->period_q8;
+  if (closed_loop) {
+    cycle_q8 += rate->correction_q8;
+  }
+  if (cycle_q8 < (int32_t)AUTOFIRE_RATE_MIN_CYCLE_Q8) {
+    cycle_q8 = (int32_t)AUTOFIRE_RATE_MIN_CYCLE_Q8;
+  }
+  return (uint32_t)cycle_q8;
+}
+
+// Length of the next click cycle in whole ms. The sub-millisecond part of
+// the period and of the PI correction is carried into later cycles, so the
+// long-run average matches the period instead of its rounded value.
+uint32_t usb_hid_autofire_rate_next_cycle_ms(AutofireRateControl *rate,
+                                             bool closed_loop) {
+  uint32_t total_q8 =
+      rate->carry_q8 + usb_hid_autofire_rate_cycle_q8(rate, closed_loop);
+  rate->carry_q8 = total_q8 & 0xFFU;
+  return total_q8 >> 8;
+}
+
+// The corrected cycle rounded to whole ms, without touching the carry; the
+// late policy measures missed cycles in it.
+uint32_t usb_hid_autofire_rate_cycle_ms(const AutofireRateControl *rate) {
+  return (usb_hid_autofire_rate_cycle_q8(rate, true) + 0x80U) >> 8;
+}
+
+// Feeds one measured release-to-release interval. The P term reacts to the
+// last interval, the I term to the accumulated phase error. An EMA of the
+// interval decides when the rate has settled within the tolerance band;
+// intervals after that point make up the steady-state error.
+void usb_hid_autofire_rate_record_interval(AutofireRateControl *rate,
+                                           uint32_t interval_ms,
+                                           uint32_t tick) {
+  int32_t period_q8 = (int32_t)rate->period_q8;
+  int32_t interval_q8 = (int32_t)(interval_ms << 8);
+  int32_t error_q8 = period_q8 - interval_q8;
+
+  // A whole missed cycle is the late policy's business, not a rate error.
+  if ((uint32_t)interval_q8 >= (2U * rate->period_q8)) {
+    rate->settle_ms = tick - rate->start_tick;
+    rate->steady_intervals = 0U;
+    rate->steady_sum_ms = 0U;
+    return;
+  }
+
+  rate->integral_q8 += error_q8;
+  if (rate->integral_q8 > period_q8) {
+    rate->integral_q8 = period_q8;
+  } else if (rate->integral_q8 < -period_q8) {
+    rate->integral_q8 = -period_q8;
+  }
+  rate->correction_q8 = (error_q8 >> AUTOFIRE_RATE_KP_SHIFT) +
+                        (rate->integral_q8 >> AUTOFIRE_RATE_KI_SHIFT);
+  if (rate->correction_q8 > (period_q8 / 4)) {
+    rate->correction_q8 = period_q8 / 4;
+  } else if (rate->correction_q8 < -(period_q8 / 4)) {
+    rate->correction_q8 = -(period_q8 / 4);
+  }
+
+  if (rate->ema_q8 == 0U) {
+    rate->ema_q8 = (uint32_t)interval_q8;
+  } else {
+    rate->ema_q8 =
+        (uint32_t)((int32_t)rate->ema_q8 +
+                   ((interval_q8 - (int32_t)rate->ema_q8) >>
+                    AUTOFIRE_RATE_EMA_SHIFT));
+  }
+
+  uint32_t deviation_q8 = (rate->ema_q8 > rate->period_q8)
+                              ? (rate->ema_q8 - rate->period_q8)
+                              : (rate->period_q8 - rate->ema_q8);
+  if ((deviation_q8 * 1000U) >
+      (rate->period_q8 * AUTOFIRE_RATE_SETTLE_PERMILLE)) {
+    rate->settle_ms = tick - rate->start_tick;
+    rate->steady_intervals = 0U;
+    rate->steady_sum_ms = 0U;
+  } else {
+    rate->steady_intervals++;
+    rate->steady_sum_ms += interval_ms;
+  }
+}
+
+void usb_hid_autofire_rate_compute_stats(const AutofireRateControl *rate,
+                                         AutofireRateStats *stats) {
+  memset(stats, 0, sizeof(AutofireRateStats));
+  if (rate->period_q8 == 0U) {
+    return;
+  }
+
+  stats->target_cps_x10 =
+      (uint32_t)(((10000ULL << 8) + (rate->period_q8 / 2U)) / rate->period_q8);
+  stats->settle_ms = rate->settle_ms;
+  stats->steady_intervals = rate->steady_intervals;
+  if ((rate->steady_intervals == 0U) || (rate->steady_sum_ms == 0U)) {
+    return;
+  }
+
+  stats->measured_cps_x100 =
+      (uint32_t)(((uint64_t)rate->steady_intervals * 100000ULL) /
+                 rate->steady_sum_ms);
+  // Measured over target rate is period * intervals / elapsed.
+  stats->error_bp =
+      (int32_t)(((int64_t)rate->period_q8 * rate->steady_intervals * 10000) /
+                ((int64_t)rate->steady_sum_ms << 8)) -
+      10000;
+}
+
+// Returns true when the bench screen changed.
+bool usb_hid_autofire_refresh_rate_stats(UsbHidAutofireApp *app) {
+  AutofireRateStats stats;
+  furi_mutex_acquire(app->engine_mutex, FuriWaitForever);
+  usb_hid_autofire_rate_compute_stats(&app->engine.rate, &stats);
+  furi_mutex_release(app->engine_mutex);
+
+  if (memcmp(&stats, &app->rate_stats, sizeof(AutofireRateStats)) == 0) {
+    return false;
+  }
+
+  app->rate_stats = stats;
+  usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+  return true;
+}
+
+void usb_hid_autofire_cps_window_reset(AutofireCpsWindow *window) {
+  memset(window, 0, sizeof(AutofireCpsWindow));
+}
+
+// Runs in the click path: each sum adds the new interval and drops the one
+// that just left its window.
+void usb_hid_autofire_cps_window_push(AutofireCpsWindow *window,
+                                      uint32_t interval_ms) {
+  if (interval_ms > UINT16_MAX) {
+    interval_ms = UINT16_MAX;
+  }
+
+  uint32_t slot = window->count & AUTOFIRE_CPS_WINDOW_MASK;
+  if (window->count >= AUTOFIRE_CPS_WINDOW_SIZE) {
+    window->long_sum_ms -= window->intervals_ms[slot];
+  }
+  if (window->count >= AUTOFIRE_CPS_SHORT_WINDOW) {
+    window->short_sum_ms -=
+        window->intervals_ms[(window->count - AUTOFIRE_CPS_SHORT_WINDOW) &
+                             AUTOFIRE_CPS_WINDOW_MASK];
+  }
+
+  window->intervals_ms[slot] = (uint16_t)interval_ms;
+  window->short_sum_ms += interval_ms;
+  window->long_sum_ms += interval_ms;
+  window->count++;
+}
+
+// Once the time since the last click is longer than an average interval it
+// stands in for one, so the rate falls off when clicks stall or stop
+// instead of holding its last value.
+uint32_t usb_hid_autofire_cps_window_cps_x10(const AutofireCpsWindow *window,
+                                             bool long_window,
+                                             uint32_t open_ms) {
+  uint32_t size =
+      long_window ? AUTOFIRE_CPS_WINDOW_SIZE : AUTOFIRE_CPS_SHORT_WINDOW;
+  uint64_t sum_ms = long_window ? window->long_sum_ms : window->short_sum_ms;
+  uint32_t count = (window->count < size) ? window->count : size;
+  if ((count == 0U) || (sum_ms == 0U)) {
+    return 0U;
+  }
+
+  uint64_t average_ms = sum_ms / count;
+  if (open_ms > average_ms) {
+    sum_ms += open_ms - average_ms;
+  }
+  return (uint32_t)((((uint64_t)count * 10000U) + (sum_ms / 2U)) / sum_ms);
+}
@@ -0,0 +1,626 @@
+#include "usb_hid_autofire_i.h"
+
+typedef struct {
+  AutofireSequence *sequence;
+  Storage *storage;
+  // sequence.bin, opened once the program outgrows memory.
+  File *spill;
+  // Ops already written to the spill file.
+  uint32_t flushed;
+  uint32_t body_start[AUTOFIRE_SEQUENCE_MAX_DEPTH];
+  // Passes a step at this depth runs per pass through the program.
+  uint32_t repeats[AUTOFIRE_SEQUENCE_MAX_DEPTH + 1U];
+  uint32_t depth;
+} AutofireSequenceCompiler;
+
+static uint32_t usb_hid_autofire_sequence_mul(uint32_t a, uint32_t b) {
+  uint64_t product = (uint64_t)a * b;
+  return (product > UINT32_MAX) ? UINT32_MAX : (uint32_t)product;
+}
+
+// Writes the ops compiled since the last spill to sequence.bin.
+static bool
+usb_hid_autofire_sequence_spill(AutofireSequenceCompiler *compiler) {
+  if (!compiler->spill) {
+    compiler->spill = storage_file_alloc(compiler->storage);
+    if (!storage_file_open(compiler->spill,
+                           USB_HID_AUTOFIRE_SEQUENCE_STREAM_PATH, FSAM_WRITE,
+                           FSOM_CREATE_ALWAYS)) {
+      return false;
+    }
+  }
+
+  uint32_t buffered = compiler->sequence->count - compiler->flushed;
+  size_t size = buffered * sizeof(AutofireSeqOp);
+  compiler->flushed += buffered;
+  return storage_file_write(compiler->spill, compiler->sequence->ops, size) ==
+         size;
+}
+
+static bool usb_hid_autofire_sequence_emit(AutofireSequenceCompiler *compiler,
+                                           AutofireSeqOpcode opcode,
+                                           uint32_t slot, uint32_t arg) {
+  AutofireSequence *sequence = compiler->sequence;
+  if (sequence->count >= AUTOFIRE_SEQUENCE_STREAM_MAX_OPS) {
+    return false;
+  }
+  if (((sequence->count - compiler->flushed) == AUTOFIRE_SEQUENCE_MAX_OPS) &&
+      !usb_hid_autofire_sequence_spill(compiler)) {
+    return false;
+  }
+  sequence->ops[sequence->count - compiler->flushed] = (AutofireSeqOp){
+      .opcode = (uint8_t)opcode, .slot = (uint8_t)slot, .arg = (uint16_t)arg};
+  sequence->count++;
+  return true;
+}
+
+// Waits longer than an op can hold are split over several ops.
+static bool usb_hid_autofire_sequence_emit_wait(
+    AutofireSequenceCompiler *compiler, uint32_t wait_ms) {
+  AutofireSequence *sequence = compiler->sequence;
+  sequence->period_ms += usb_hid_autofire_sequence_mul(
+      wait_ms, compiler->repeats[compiler->depth]);
+  while (wait_ms > 0U) {
+    uint32_t chunk_ms = (wait_ms > UINT16_MAX) ? UINT16_MAX : wait_ms;
+    if (!usb_hid_autofire_sequence_emit(compiler, AutofireSeqOpWait, 0U,
+                                        chunk_ms)) {
+      return false;
+    }
+    wait_ms -= chunk_ms;
+  }
+  return true;
+}
+
+static bool usb_hid_autofire_sequence_parse_u32(const char *text,
+                                                uint32_t min, uint32_t max,
+                                                uint32_t *value) {
+  char *end = NULL;
+  if (!text) {
+    return false;
+  }
+  unsigned long parsed = strtoul(text, &end, 10);
+  if ((end == text) || (*end != '\0') || (parsed < min) || (parsed > max)) {
+    return false;
+  }
+  *value = (uint32_t)parsed;
+  return true;
+}
+
+// Splits a line into whitespace separated words in place and drops
+// everything after a '#'.
+static uint32_t usb_hid_autofire_sequence_split(char *line, char **words,
+                                                uint32_t max_words) {
+  uint32_t count = 0U;
+  char *cursor = line;
+  while (*cursor != '\0') {
+    while ((*cursor == ' ') || (*cursor == '\t') || (*cursor == '\r')) {
+      cursor++;
+    }
+    if ((*cursor == '\0') || (*cursor == '#')) {
+      break;
+    }
+    if (count == max_words) {
+      return max_words + 1U;
+    }
+    words[count++] = cursor;
+    while ((*cursor != '\0') && (*cursor != ' ') && (*cursor != '\t') &&
+           (*cursor != '\r') && (*cursor != '#')) {
+      cursor++;
+    }
+    if (*cursor == '#') {
+      *cursor = '\0';
+      break;
+    }
+    if (*cursor != '\0') {
+      *cursor++ = '\0';
+    }
+  }
+  return count;
+}
+
+static bool usb_hid_autofire_sequence_compile_line(
+    AutofireSequenceCompiler *compiler, char *line) {
+  char *words[3] = {NULL, NULL, NULL};
+  uint32_t count =
+      usb_hid_autofire_sequence_split(line, words, COUNT_OF(words));
+  if (count == 0U) {
+    return true;
+  }
+  if (count > COUNT_OF(words)) {
+    return false;
+  }
+
+  const char *verb = words[0];
+  AutofireTargetKind kind;
+  uint16_t code;
+  uint32_t value;
+
+  if ((strcasecmp(verb, "press") == 0) || (strcasecmp(verb, "release") == 0)) {
+    return (count == 2U) &&
+           usb_hid_autofire_parse_target(words[1], &kind, &code) &&
+           usb_hid_autofire_sequence_emit(
+               compiler,
+               (strcasecmp(verb, "press") == 0) ? AutofireSeqOpPress
+                                                : AutofireSeqOpRelease,
+               kind, code);
+  }
+  if (strcasecmp(verb, "tap") == 0) {
+    value = AUTOFIRE_SEQUENCE_TAP_MS;
+    return (count >= 2U) &&
+           usb_hid_autofire_parse_target(words[1], &kind, &code) &&
+           ((count == 2U) ||
+            usb_hid_autofire_sequence_parse_u32(
+                words[2], 1U, AUTOFIRE_CHANNEL_DELAY_MAX_MS, &value)) &&
+           usb_hid_autofire_sequence_emit(compiler, AutofireSeqOpPress, kind,
+                                          code) &&
+           usb_hid_autofire_sequence_emit_wait(compiler, value) &&
+           usb_hid_autofire_sequence_emit(compiler, AutofireSeqOpRelease,
+                                          kind, code);
+  }
+  if (strcasecmp(verb, "wait") == 0) {
+    return (count == 2U) &&
+           usb_hid_autofire_sequence_parse_u32(
+               words[1], 1U, AUTOFIRE_CHANNEL_DELAY_MAX_MS, &value) &&
+           usb_hid_autofire_sequence_emit_wait(compiler, value);
+  }
+  if (strcasecmp(verb, "loop") == 0) {
+    uint32_t depth = compiler->depth;
+    if ((count != 2U) || (depth == AUTOFIRE_SEQUENCE_MAX_DEPTH) ||
+        !usb_hid_autofire_sequence_parse_u32(words[1], 1U, UINT16_MAX,
+                                             &value) ||
+        !usb_hid_autofire_sequence_emit(compiler, AutofireSeqOpLoop, depth,
+                                        value)) {
+      return false;
+    }
+    compiler->body_start[depth] = compiler->sequence->count;
+    compiler->repeats[depth + 1U] =
+        usb_hid_autofire_sequence_mul(compiler->repeats[depth], value);
+    compiler->depth++;
+    return true;
+  }
+  if (strcasecmp(verb, "end") == 0) {
+    // An empty body would spin the worker without ever reaching a wait.
+    if ((count != 1U) || (compiler->depth == 0U) ||
+        (compiler->body_start[compiler->depth - 1U] ==
+         compiler->sequence->count)) {
+      return false;
+    }
+    compiler->depth--;
+    return usb_hid_autofire_sequence_emit(
+        compiler, AutofireSeqOpNext, compiler->depth,
+        compiler->body_start[compiler->depth]);
+  }
+  return false;
+}
+
+// Checks the program end and closes it with the jump back to the start. A
+// program that spilled writes its last ops too, and then runs streamed.
+static bool usb_hid_autofire_sequence_finish(
+    AutofireSequenceCompiler *compiler) {
+  AutofireSequence *sequence = compiler->sequence;
+  if ((compiler->depth != 0U) || (sequence->period_ms == 0U) ||
+      !usb_hid_autofire_sequence_emit(compiler, AutofireSeqOpJump, 0U, 0U)) {
+    return false;
+  }
+  if (compiler->flushed == 0U) {
+    return true;
+  }
+  sequence->streamed = true;
+  return usb_hid_autofire_sequence_spill(compiler);
+}
+
+static bool usb_hid_autofire_sequence_read_chunk(File *file,
+                                                 AutofireSequence *sequence,
+                                                 uint32_t half,
+                                                 uint32_t chunk) {
+  uint32_t first = chunk * AUTOFIRE_SEQUENCE_CHUNK_OPS;
+  uint32_t count = sequence->count - first;
+  if (count > AUTOFIRE_SEQUENCE_CHUNK_OPS) {
+    count = AUTOFIRE_SEQUENCE_CHUNK_OPS;
+  }
+  size_t size = count * sizeof(AutofireSeqOp);
+  return storage_file_seek(file, first * sizeof(AutofireSeqOp), true) &&
+         (storage_file_read(file,
+                            &sequence->ops[half * AUTOFIRE_SEQUENCE_CHUNK_OPS],
+                            size) == size);
+}
+
+// Fills requested halves. SD latency only delays the loader; the worker
+// never waits for it.
+static int32_t usb_hid_autofire_sequence_loader(void *ctx) {
+  AutofireSequence *sequence = ctx;
+  AutofireSequenceStream *stream = &sequence->stream;
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  File *file = storage_file_alloc(storage);
+  bool opened = storage_file_open(file, USB_HID_AUTOFIRE_SEQUENCE_STREAM_PATH,
+                                  FSAM_READ, FSOM_OPEN_EXISTING);
+  uint32_t request;
+
+  while ((furi_message_queue_get(stream->requests, &request,
+                                 FuriWaitForever) == FuriStatusOk) &&
+         (request != AUTOFIRE_SEQUENCE_CHUNK_NONE)) {
+    uint32_t half = request & 1U;
+    uint32_t chunk = request >> 1;
+    bool ok = opened &&
+              usb_hid_autofire_sequence_read_chunk(file, sequence, half, chunk);
+    // A failed read frees the half so the worker asks again.
+    uint32_t expected = chunk << 1;
+    __atomic_compare_exchange_n(&stream->state[half], &expected,
+                                ok ? (expected | 1U)
+                                   : AUTOFIRE_SEQUENCE_CHUNK_NONE,
+                                false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    __atomic_fetch_add(ok ? &stream->loads : &stream->read_failures, 1U,
+                       __ATOMIC_RELAXED);
+  }
+
+  if (opened) {
+    storage_file_close(file);
+  }
+  storage_file_free(file);
+  furi_record_close(RECORD_STORAGE);
+  return 0;
+}
+
+// Loads the first two chunks up front, then hands the rest to the loader.
+// The closing jump is not chunked, so the last chunk prefetches the first.
+static bool usb_hid_autofire_sequence_stream_start(Storage *storage,
+                                                   AutofireSequence *sequence) {
+  AutofireSequenceStream *stream = &sequence->stream;
+  stream->chunk_count =
+      (sequence->count - 1U + AUTOFIRE_SEQUENCE_CHUNK_OPS - 1U) /
+      AUTOFIRE_SEQUENCE_CHUNK_OPS;
+
+  bool ok = false;
+  File *file = storage_file_alloc(storage);
+  if (storage_file_open(file, USB_HID_AUTOFIRE_SEQUENCE_STREAM_PATH,
+                        FSAM_READ, FSOM_OPEN_EXISTING)) {
+    ok = true;
+    for (uint32_t half = 0U; half < 2U; half++) {
+      ok = ok &&
+           usb_hid_autofire_sequence_read_chunk(file, sequence, half, half);
+      stream->state[half] = ok ? ((half << 1) | 1U)
+                               : AUTOFIRE_SEQUENCE_CHUNK_NONE;
+    }
+    storage_file_close(file);
+  }
+  storage_file_free(file);
+
+  stream->requests = furi_message_queue_alloc(SEQUENCE_LOADER_QUEUE_SIZE,
+                                              sizeof(uint32_t));
+  if (!ok || !stream->requests) {
+    return false;
+  }
+  stream->loader =
+      furi_thread_alloc_ex("AutofireSeqLoader", SEQUENCE_LOADER_STACK_SIZE,
+                           usb_hid_autofire_sequence_loader, sequence);
+  if (!stream->loader) {
+    return false;
+  }
+  // Above the UI so a prefetch is not held up by redraws.
+  furi_thread_set_priority(stream->loader, FuriThreadPriorityHigh);
+  furi_thread_start(stream->loader);
+  return true;
+}
+
+// Compiles sequence.txt line by line. Up to AUTOFIRE_SEQUENCE_MAX_OPS ops
+// stay in memory; a longer program is written to sequence.bin as it
+// compiles and streamed from there.
+bool usb_hid_autofire_sequence_load(AutofireSequence *sequence) {
+  *sequence = (AutofireSequence){
+      .ops = NULL,
+      .stream = {.state = {AUTOFIRE_SEQUENCE_CHUNK_NONE,
+                           AUTOFIRE_SEQUENCE_CHUNK_NONE}},
+  };
+
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  File *file = storage_file_alloc(storage);
+  if (!storage_file_open(file, USB_HID_AUTOFIRE_SEQUENCE_PATH, FSAM_READ,
+                         FSOM_OPEN_EXISTING)) {
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return false;
+  }
+
+  AutofireSequenceCompiler compiler = {
+      .sequence = sequence,
+      .storage = storage,
+      .spill = NULL,
+      .flushed = 0U,
+      .depth = 0U,
+  };
+  compiler.repeats[0] = 1U;
+  char *block = malloc(AUTOFIRE_SEQUENCE_READ_SIZE);
+  char line[AUTOFIRE_SEQUENCE_LINE_MAX + 1U];
+  uint32_t length = 0U;
+  uint32_t line_number = 1U;
+  sequence->ops = malloc(AUTOFIRE_SEQUENCE_MAX_OPS * sizeof(AutofireSeqOp));
+  bool ok = (block != NULL) && (sequence->ops != NULL);
+
+  size_t read;
+  while (ok && ((read = storage_file_read(file, block,
+                                          AUTOFIRE_SEQUENCE_READ_SIZE)) > 0U)) {
+    for (size_t i = 0U; ok && (i < read); i++) {
+      if (block[i] == '\n') {
+        line[length] = '\0';
+        ok = usb_hid_autofire_sequence_compile_line(&compiler, line);
+        line_number += ok ? 1U : 0U;
+        length = 0U;
+      } else if (length < AUTOFIRE_SEQUENCE_LINE_MAX) {
+        line[length++] = block[i];
+      } else {
+        ok = false;
+      }
+    }
+  }
+  if (ok && (length > 0U)) {
+    line[length] = '\0';
+    ok = usb_hid_autofire_sequence_compile_line(&compiler, line);
+  }
+  ok = ok && usb_hid_autofire_sequence_finish(&compiler);
+
+  storage_file_close(file);
+  storage_file_free(file);
+  free(block);
+  if (compiler.spill) {
+    storage_file_close(compiler.spill);
+    storage_file_free(compiler.spill);
+  }
+  if (ok && sequence->streamed) {
+    ok = usb_hid_autofire_sequence_stream_start(storage, sequence);
+  }
+  furi_record_close(RECORD_STORAGE);
+
+  if (!ok) {
+    FURI_LOG_W(TAG, "Sequence file error on line %lu",
+               (unsigned long)line_number);
+    usb_hid_autofire_sequence_free(sequence);
+    return false;
+  }
+  FURI_LOG_I(TAG, "Sequence: %lu ops, %lums per pass%s",
+             (unsigned long)sequence->count,
+             (unsigned long)sequence->period_ms,
+             sequence->streamed ? ", streamed from SD" : "");
+  return true;
+}
+
+void usb_hid_autofire_sequence_free(AutofireSequence *sequence) {
+  AutofireSequenceStream *stream = &sequence->stream;
+  if (stream->loader) {
+    uint32_t exit_request = AUTOFIRE_SEQUENCE_CHUNK_NONE;
+    furi_message_queue_put(stream->requests, &exit_request, FuriWaitForever);
+    furi_thread_join(stream->loader);
+    furi_thread_free(stream->loader);
+    stream->loader = NULL;
+    FURI_LOG_I(TAG, "Sequence stream: %lu chunk loads, %lu underruns, %lu "
+                    "read failures",
+               (unsigned long)stream->loads, (unsigned long)stream->underruns,
+               (unsigned long)stream->read_failures);
+  }
+  if (stream->requests) {
+    furi_message_queue_free(stream->requests);
+    stream->requests = NULL;
+  }
+
+  free(sequence->ops);
+  sequence->ops = NULL;
+  sequence->count = 0U;
+  sequence->period_ms = 0U;
+  sequence->streamed = false;
+}
+
+void usb_hid_autofire_sequence_start(AutofireSequenceRun *run, uint32_t now) {
+  run->pc = 0U;
+  run->next_at = now;
+  run->passes = 0U;
+  run->fetch_chunk = AUTOFIRE_SEQUENCE_CHUNK_NONE;
+}
+
+// Lets go of whatever the sequence still holds.
+static void usb_hid_autofire_sequence_release_held(AutofireSequenceRun *run) {
+  if (run->mouse_held != 0U) {
+    usb_hid_autofire_transport_send(run->transport, AutofireTargetKindMouse,
+                                    run->mouse_held, false);
+    run->mouse_held = 0U;
+  }
+  for (size_t i = 0; i < AUTOFIRE_SEQUENCE_MAX_KEYS; i++) {
+    if (run->keys_held[i] != 0U) {
+      usb_hid_autofire_transport_send(run->transport,
+                                      AutofireTargetKindKeyboard,
+                                      run->keys_held[i], false);
+      run->keys_held[i] = 0U;
+    }
+  }
+}
+
+void usb_hid_autofire_sequence_stop(AutofireSequenceRun *run) {
+  usb_hid_autofire_sequence_release_held(run);
+  run->pc = 0U;
+  run->stalled = false;
+}
+
+// Asks the loader for a chunk unless a half already holds or awaits it.
+static void usb_hid_autofire_sequence_request(AutofireSequenceStream *stream,
+                                              uint32_t half, uint32_t chunk) {
+  uint32_t state = __atomic_load_n(&stream->state[half], __ATOMIC_ACQUIRE);
+  if ((state >> 1) == chunk) {
+    return;
+  }
+
+  __atomic_store_n(&stream->state[half], chunk << 1, __ATOMIC_RELEASE);
+  uint32_t request = (chunk << 1) | half;
+  if (furi_message_queue_put(stream->requests, &request, 0) != FuriStatusOk) {
+    __atomic_store_n(&stream->state[half], AUTOFIRE_SEQUENCE_CHUNK_NONE,
+                     __ATOMIC_RELEASE);
+  }
+}
+
+// The chunk the run goes to after `chunk`: the start of the first loop
+// that jumps back out of it, otherwise the one after it. Loops that close
+// inside the chunk are run through on copies of the counters.
+static uint32_t
+usb_hid_autofire_sequence_next_chunk(const AutofireSequenceRun *run,
+                                     const AutofireSeqOp *ops,
+                                     uint32_t chunk) {
+  const AutofireSequence *program = run->program;
+  uint16_t counters[AUTOFIRE_SEQUENCE_MAX_DEPTH];
+  memcpy(counters, run->counters, sizeof(counters));
+  uint32_t end = (chunk + 1U) * AUTOFIRE_SEQUENCE_CHUNK_OPS;
+  end = (end < program->count) ? end : program->count;
+
+  for (uint32_t pc = run->pc; pc < end; pc++) {
+    const AutofireSeqOp *op = &ops[pc % AUTOFIRE_SEQUENCE_CHUNK_OPS];
+    if (op->opcode == AutofireSeqOpLoop) {
+      counters[op->slot] = op->arg;
+    } else if (op->opcode == AutofireSeqOpNext) {
+      uint32_t target = op->arg / AUTOFIRE_SEQUENCE_CHUNK_OPS;
+      if ((counters[op->slot] > 1U) && (target != chunk)) {
+        return target;
+      }
+      counters[op->slot] = 0U;
+    }
+  }
+  return (chunk + 1U) % program->stream.chunk_count;
+}
+
+// Returns the op at `pc`, or NULL while its chunk is not in memory. Running
+// from one half prefetches the chunk the run needs next into the other:
+// the start of a loop about to repeat, otherwise the following chunk,
+// wrapping to the start.
+static const AutofireSeqOp *
+usb_hid_autofire_sequence_fetch(AutofireSequenceRun *run) {
+  static const AutofireSeqOp wrap = {AutofireSeqOpJump, 0U, 0U};
+  AutofireSequence *program = run->program;
+  uint32_t pc = run->pc;
+  if (!program->streamed) {
+    return &program->ops[pc];
+  }
+  if ((pc + 1U) == program->count) {
+    return &wrap;
+  }
+
+  AutofireSequenceStream *stream = &program->stream;
+  uint32_t chunk = pc / AUTOFIRE_SEQUENCE_CHUNK_OPS;
+  for (uint32_t half = 0U; half < 2U; half++) {
+    if (__atomic_load_n(&stream->state[half], __ATOMIC_ACQUIRE) ==
+        ((chunk << 1) | 1U)) {
+      const AutofireSeqOp *ops =
+          &program->ops[half * AUTOFIRE_SEQUENCE_CHUNK_OPS];
+      if (run->fetch_chunk != chunk) {
+        run->fetch_chunk = chunk;
+        run->prefetch_chunk =
+            usb_hid_autofire_sequence_next_chunk(run, ops, chunk);
+      }
+      usb_hid_autofire_sequence_request(stream, half ^ 1U,
+                                        run->prefetch_chunk);
+      return &ops[pc % AUTOFIRE_SEQUENCE_CHUNK_OPS];
+    }
+  }
+
+  // Keep a prefetch of the chunk after this one if one is under way.
+  uint32_t next = (run->fetch_chunk == chunk)
+                      ? run->prefetch_chunk
+                      : ((chunk + 1U) % stream->chunk_count);
+  uint32_t busy = __atomic_load_n(&stream->state[0], __ATOMIC_ACQUIRE) >> 1;
+  usb_hid_autofire_sequence_request(stream, (busy == next) ? 1U : 0U, chunk);
+  return NULL;
+}
+
+// The next op is still on its way from SD: let go of every key so the
+// stall cannot hold one down, and look again on the next tick.
+static void usb_hid_autofire_sequence_stall(AutofireSequenceRun *run) {
+  usb_hid_autofire_sequence_release_held(run);
+  if (!run->stalled) {
+    run->stalled = true;
+    run->program->stream.underruns++;
+  }
+  run->next_at = furi_get_tick() + 1U;
+}
+
+static void usb_hid_autofire_sequence_track(AutofireSequenceRun *run,
+                                            const AutofireSeqOp *op) {
+  bool press = op->opcode == AutofireSeqOpPress;
+  if (op->slot == AutofireTargetKindMouse) {
+    run->mouse_held = press ? (run->mouse_held | (uint8_t)op->arg)
+                            : (run->mouse_held & (uint8_t)~op->arg);
+    return;
+  }
+
+  uint16_t match = press ? 0U : op->arg;
+  for (size_t i = 0; i < AUTOFIRE_SEQUENCE_MAX_KEYS; i++) {
+    if (press && (run->keys_held[i] == op->arg)) {
+      return;
+    }
+  }
+  for (size_t i = 0; i < AUTOFIRE_SEQUENCE_MAX_KEYS; i++) {
+    if (run->keys_held[i] == match) {
+      run->keys_held[i] = press ? op->arg : 0U;
+      return;
+    }
+  }
+}
+
+// Runs ops up to the next wait. At most one HID change goes into the batch
+// per call; a second one leaves the deadline as is, so the scheduler comes
+// straight back for it in the next pass. The compiler rejects empty loop
+// bodies and programs without a wait, so every call ends.
+void usb_hid_autofire_sequence_tick(AutofireSequenceRun *run,
+                                    AutofireHidBatch *batch,
+                                    AutofireLatePolicy late_policy) {
+  AutofireSequence *program = run->program;
+  bool sent = false;
+
+  while (true) {
+    const AutofireSeqOp *op = usb_hid_autofire_sequence_fetch(run);
+    if (!op) {
+      // A change already in the batch goes out first; the stall follows on
+      // the next pass.
+      if (!sent) {
+        usb_hid_autofire_sequence_stall(run);
+      }
+      return;
+    }
+    run->stalled = false;
+    switch (op->opcode) {
+    case AutofireSeqOpPress:
+    case AutofireSeqOpRelease:
+      if (sent) {
+        return;
+      }
+      usb_hid_autofire_hid_batch_add(batch, (AutofireTargetKind)op->slot,
+                                     op->arg,
+                                     op->opcode == AutofireSeqOpPress);
+      usb_hid_autofire_sequence_track(run, op);
+      sent = true;
+      run->pc++;
+      break;
+    case AutofireSeqOpWait: {
+      run->next_at += furi_ms_to_ticks(op->arg);
+      run->pc++;
+      // Catch up keeps the grid like the click phases do; a stall longer
+      // than a pass, or any other policy, re-bases on the current tick.
+      uint32_t now = furi_get_tick();
+      int32_t late_ticks = (int32_t)(now - run->next_at);
+      if ((late_ticks > 0) &&
+          ((late_policy != AutofireLatePolicyCatchUp) ||
+           ((uint32_t)late_ticks >= furi_ms_to_ticks(program->period_ms)))) {
+        run->next_at = now;
+      }
+      return;
+    }
+    case AutofireSeqOpLoop:
+      run->counters[op->slot] = op->arg;
+      run->pc++;
+      run->fetch_chunk = AUTOFIRE_SEQUENCE_CHUNK_NONE;
+      break;
+    case AutofireSeqOpNext:
+      run->pc = (--run->counters[op->slot] > 0U) ? op->arg : (run->pc + 1U);
+      run->fetch_chunk = AUTOFIRE_SEQUENCE_CHUNK_NONE;
+      break;
+    case AutofireSeqOpJump:
+    default:
+      run->pc = op->arg;
+      run->passes++;
+      break;
+    }
+  }
+}
@@ -3,7 +3,7 @@
 void usb_hid_autofire_settings_save_timer_callback(void *ctx) {
   UsbHidAutofireApp *app = ctx;
   UsbMouseEvent event = {.type = EventTypeSettingsSave};
-  furi_message_queue_put(app->event_queue, &event, 0);
+  usb_hid_autofire_post_event(app, &event);
 }
 
 void usb_hid_autofire_mark_settings_dirty(UsbHidAutofireApp *app) {
@@ -14,44 +14,108 @@ void usb_hid_autofire_mark_settings_dirty(UsbHidAutofireApp *app) {
   }
 }
 
-static bool usb_hid_autofire_settings_save(const UsbHidAutofireApp *app) {
-  bool success = false;
-  Storage *storage = furi_record_open(RECORD_STORAGE);
-  FlipperFormat *settings_file = flipper_format_file_alloc(storage);
-  if (settings_file && flipper_format_file_open_always(
-                           settings_file, USB_HID_AUTOFIRE_SETTINGS_PATH)) {
-    do {
-      if (!flipper_format_write_header_cstr(
-              settings_file, USB_HID_AUTOFIRE_SETTINGS_FILE_TYPE,
-              USB_HID_AUTOFIRE_SETTINGS_VERSION)) {
-        break;
-      }
+// Reflected CRC-32 (IEEE), one nibble at a time to keep the table small.
+static uint32_t usb_hid_autofire_crc32(const void *data, size_t size) {
+  static const uint32_t table[16] = {
+      0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+      0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+      0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+      0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU,
+  };
+  const uint8_t *bytes = data;
+  uint32_t crc = 0xFFFFFFFFU;
 
-      uint32_t delay_ms = usb_hid_autofire_delay_clamp(app->autofire_delay_ms);
-      uint32_t mode = app->mode;
-      uint32_t preset = app->preset;
-      uint32_t startup_policy = app->startup_policy;
-      bool last_active = app->last_active_state;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= bytes[i];
+    crc = (crc >> 4) ^ table[crc & 0x0FU];
+    crc = (crc >> 4) ^ table[crc & 0x0FU];
+  }
+  return ~crc;
+}
 
-      if (!flipper_format_write_uint32(settings_file, "delay_ms", &delay_ms, 1))
-        break;
-      if (!flipper_format_write_uint32(settings_file, "mode", &mode, 1))
-        break;
-      if (!flipper_format_write_uint32(settings_file, "preset", &preset, 1))
-        break;
-      if (!flipper_format_write_uint32(settings_file, "startup_policy",
-                                       &startup_policy, 1))
-        break;
-      if (!flipper_format_write_bool(settings_file, "last_active", &last_active,
-                                     1))
-        break;
+void usb_hid_autofire_settings_seal(AutofireSettingsRecord *record) {
+  record->magic = USB_HID_AUTOFIRE_SETTINGS_MAGIC;
+  record->version = USB_HID_AUTOFIRE_SETTINGS_VERSION;
+  record->size = sizeof(AutofireSettings);
+  record->crc =
+      usb_hid_autofire_crc32(record, offsetof(AutofireSettingsRecord, crc));
+}
 
-      success = true;
-    } while (false);
+static void usb_hid_autofire_settings_defaults(AutofireSettings *settings) {
+  *settings = (AutofireSettings){
+      .delay_ms = AUTOFIRE_DELAY_DEFAULT_MS,
+      .mode = AutofireModeMouseLeftClick,
+      .preset = AutofirePresetCustom,
+      .startup_policy = AutofireStartupPolicyPausedOnLaunch,
+      .last_active = 0U,
+      .late_policy = AutofireLatePolicyCatchUp,
+      .duty_percent = AUTOFIRE_DUTY_DEFAULT_PERCENT,
+      .frame_align_ms = AUTOFIRE_FRAME_ALIGN_DEFAULT_MS,
+      .target_cps_x10 = 0U,
+      .key_code = AUTOFIRE_KEY_CODE_DEFAULT,
+      .key_modifiers = 0U,
+      .sequence_enabled = 0U,
+      .burst_count = 0U,
+      .burst_interval_ms = 0U,
+      .hold_to_fire = 0U,
+      .transport = AutofireTransportUsb,
+      .capture = 0U,
+      .input_log = 0U,
+  };
+  usb_hid_autofire_channel_defaults(settings->channels);
+}
+
+void usb_hid_autofire_settings_snapshot(const UsbHidAutofireApp *app,
+                                        AutofireSettings *settings) {
+  *settings = (AutofireSettings){
+      .delay_ms = usb_hid_autofire_delay_clamp(app->autofire_delay_ms),
+      .mode = app->mode,
+      .preset = app->preset,
+      .startup_policy = app->startup_policy,
+      .last_active = app->last_active_state ? 1U : 0U,
+      .late_policy = app->late_policy,
+      .duty_percent = app->duty_percent,
+      .frame_align_ms = app->frame_align_ms,
+      .target_cps_x10 = app->target_cps_x10,
+      .key_code = app->key_code,
+      .key_modifiers = app->key_modifiers,
+      .sequence_enabled = app->sequence_enabled ? 1U : 0U,
+      .burst_count = app->burst_count,
+      .burst_interval_ms = app->burst_interval_ms,
+      .hold_to_fire = app->hold_to_fire ? 1U : 0U,
+      .transport = app->transport_type,
+      .capture = app->capture_enabled ? 1U : 0U,
+      .input_log = app->input_log_enabled ? 1U : 0U,
+  };
+  memcpy(settings->channels, app->channels, sizeof(settings->channels));
+}
+
+// Writes the record to a temp file and renames it over the old one, so a
+// power loss leaves either the old or the new record. Rename does not
+// replace an existing file, and load falls back to the temp file for the
+// gap between the remove and the rename.
+static bool usb_hid_autofire_settings_write(const AutofireSettings *settings) {
+  AutofireSettingsRecord record = {.settings = *settings};
+  usb_hid_autofire_settings_seal(&record);
+
+  bool success = false;
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  File *file = storage_file_alloc(storage);
+  if (file && storage_file_open(file, USB_HID_AUTOFIRE_SETTINGS_TEMP_PATH,
+                                FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+    success = storage_file_write(file, &record, sizeof(record)) ==
+              sizeof(record);
+    storage_file_close(file);
   }
 
-  if (settings_file) {
-    flipper_format_free(settings_file);
+  if (file) {
+    storage_file_free(file);
+  }
+  if (success) {
+    storage_common_remove(storage, USB_HID_AUTOFIRE_SETTINGS_PATH);
+    success = storage_common_rename(storage,
+                                    USB_HID_AUTOFIRE_SETTINGS_TEMP_PATH,
+                                    USB_HID_AUTOFIRE_SETTINGS_PATH) == FSE_OK;
   }
   furi_record_close(RECORD_STORAGE);
 
@@ -62,45 +126,106 @@ static bool usb_hid_autofire_settings_save(const UsbHidAutofireApp *app) {
   return success;
 }
 
-bool usb_hid_autofire_settings_load(UsbHidAutofireApp *app) {
+typedef enum {
+  AutofireSettingsReadOk,
+  AutofireSettingsReadMissing,
+  AutofireSettingsReadCorrupt,
+} AutofireSettingsReadResult;
+
+static AutofireSettingsReadResult
+usb_hid_autofire_settings_read_record(Storage *storage, const char *path,
+                                      AutofireSettings *settings) {
+  uint8_t buffer[sizeof(AutofireSettingsRecord)];
+  AutofireSettingsRecord header;
+  const size_t header_size = offsetof(AutofireSettingsRecord, settings);
+  AutofireSettingsReadResult result = AutofireSettingsReadMissing;
+  File *file = storage_file_alloc(storage);
+
+  if (file &&
+      storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+    result = AutofireSettingsReadCorrupt;
+    size_t read = storage_file_read(file, buffer, sizeof(buffer));
+    memcpy(&header, buffer, header_size);
+    // Older builds wrote a shorter settings block; its crc follows it.
+    size_t size = header.size;
+    uint32_t crc;
+    if ((read >= header_size) &&
+        (header.magic == USB_HID_AUTOFIRE_SETTINGS_MAGIC) &&
+        (header.version == USB_HID_AUTOFIRE_SETTINGS_VERSION) &&
+        (size >= offsetof(AutofireSettings, channels)) &&
+        (size <= sizeof(AutofireSettings)) && ((size % 4U) == 0U) &&
+        (read == (header_size + size + sizeof(crc)))) {
+      memcpy(&crc, &buffer[header_size + size], sizeof(crc));
+      if (crc == usb_hid_autofire_crc32(buffer, header_size + size)) {
+        memcpy(settings, &buffer[header_size], size);
+        result = AutofireSettingsReadOk;
+      }
+    }
+    storage_file_close(file);
+  }
+
+  if (file) {
+    storage_file_free(file);
+  }
+
+  return result;
+}
+
+// Reads the version 1 text file. Keys added after the first release are
+// optional, so they are looked up after a rewind and keep their defaults.
+static bool usb_hid_autofire_settings_read_legacy(Storage *storage,
+                                                  AutofireSettings *settings) {
   bool loaded = false;
-  Storage *storage = furi_record_open(RECORD_STORAGE);
   FlipperFormat *settings_file = flipper_format_file_alloc(storage);
   FuriString *file_type = furi_string_alloc();
   uint32_t version = 0;
-  uint32_t delay_ms = AUTOFIRE_DELAY_DEFAULT_MS;
-  uint32_t mode = AutofireModeMouseLeftClick;
-  uint32_t preset = AutofirePresetCustom;
-  uint32_t startup_policy = AutofireStartupPolicyPausedOnLaunch;
   bool last_active = false;
 
-  if (settings_file && flipper_format_file_open_existing(
-                           settings_file, USB_HID_AUTOFIRE_SETTINGS_PATH)) {
+  if (settings_file &&
+      flipper_format_file_open_existing(
+          settings_file, USB_HID_AUTOFIRE_SETTINGS_LEGACY_PATH)) {
     do {
       if (!flipper_format_read_header(settings_file, file_type, &version))
         break;
       if ((strcmp(furi_string_get_cstr(file_type),
                   USB_HID_AUTOFIRE_SETTINGS_FILE_TYPE) != 0) ||
-          (version != USB_HID_AUTOFIRE_SETTINGS_VERSION))
+          (version != USB_HID_AUTOFIRE_SETTINGS_LEGACY_VERSION))
         break;
-      if (!flipper_format_read_uint32(settings_file, "delay_ms", &delay_ms, 1))
+      if (!flipper_format_read_uint32(settings_file, "delay_ms",
+                                      &settings->delay_ms, 1))
         break;
-      if (!flipper_format_read_uint32(settings_file, "mode", &mode, 1))
+      if (!flipper_format_read_uint32(settings_file, "mode", &settings->mode,
+                                      1))
         break;
-      if (!flipper_format_read_uint32(settings_file, "preset", &preset, 1))
+      if (!flipper_format_read_uint32(settings_file, "preset",
+                                      &settings->preset, 1))
         break;
       if (!flipper_format_read_uint32(settings_file, "startup_policy",
-                                      &startup_policy, 1))
+                                      &settings->startup_policy, 1))
         break;
       if (!flipper_format_read_bool(settings_file, "last_active", &last_active,
                                     1))
         break;
-      if (!usb_hid_autofire_mode_is_valid(mode))
-        break;
-      if (!usb_hid_autofire_preset_is_valid(preset))
-        break;
-      if (!usb_hid_autofire_startup_policy_is_valid(startup_policy))
-        break;
+      settings->last_active = last_active ? 1U : 0U;
+
+      flipper_format_rewind(settings_file);
+      flipper_format_read_uint32(settings_file, "late_policy",
+                                 &settings->late_policy, 1);
+      flipper_format_rewind(settings_file);
+      flipper_format_read_uint32(settings_file, "duty_percent",
+                                 &settings->duty_percent, 1);
+      flipper_format_rewind(settings_file);
+      flipper_format_read_uint32(settings_file, "frame_align_ms",
+                                 &settings->frame_align_ms, 1);
+      flipper_format_rewind(settings_file);
+      flipper_format_read_uint32(settings_file, "target_cps_x10",
+                                 &settings->target_cps_x10, 1);
+      flipper_format_rewind(settings_file);
+      flipper_format_read_uint32(settings_file, "key_code",
+                                 &settings->key_code, 1);
+      flipper_format_rewind(settings_file);
+      flipper_format_read_uint32(settings_file, "key_modifiers",
+                                 &settings->key_modifiers, 1);
 
       loaded = true;
     } while (false);
@@ -110,17 +235,74 @@ bool usb_hid_autofire_settings_load(UsbHidAutofireApp *app) {
   if (settings_file) {
     flipper_format_free(settings_file);
   }
-  furi_record_close(RECORD_STORAGE);
 
-  if (!loaded) {
+  return loaded;
+}
+
+// The required fields must be valid; fields added later fall back to their
+// defaults one by one.
+static bool usb_hid_autofire_settings_apply(UsbHidAutofireApp *app,
+                                            AutofireSettings *settings) {
+  if (!usb_hid_autofire_mode_is_valid(settings->mode) ||
+      !usb_hid_autofire_preset_is_valid(settings->preset) ||
+      !usb_hid_autofire_startup_policy_is_valid(settings->startup_policy)) {
     return false;
   }
 
-  app->autofire_delay_ms = usb_hid_autofire_delay_clamp(delay_ms);
-  app->mode = (AutofireMode)mode;
-  app->preset = (AutofirePreset)preset;
+  AutofireSettings defaults;
+  usb_hid_autofire_settings_defaults(&defaults);
+  if (!usb_hid_autofire_late_policy_is_valid(settings->late_policy)) {
+    settings->late_policy = defaults.late_policy;
+  }
+  if (!usb_hid_autofire_duty_is_valid(settings->duty_percent)) {
+    settings->duty_percent = defaults.duty_percent;
+  }
+  if (!usb_hid_autofire_frame_align_is_valid(settings->frame_align_ms)) {
+    settings->frame_align_ms = defaults.frame_align_ms;
+  }
+  if (!usb_hid_autofire_target_cps_is_valid(settings->target_cps_x10)) {
+    settings->target_cps_x10 = defaults.target_cps_x10;
+  }
+  if (!usb_hid_autofire_key_code_is_valid(settings->key_code)) {
+    settings->key_code = defaults.key_code;
+  }
+  if (!usb_hid_autofire_key_modifiers_is_valid(settings->key_modifiers)) {
+    settings->key_modifiers = defaults.key_modifiers;
+  }
+  for (size_t i = 0; i < AUTOFIRE_EXTRA_CHANNEL_COUNT; i++) {
+    if (!usb_hid_autofire_channel_is_valid(&settings->channels[i])) {
+      settings->channels[i] = defaults.channels[i];
+    }
+  }
+  if (!usb_hid_autofire_burst_count_is_valid(settings->burst_count)) {
+    settings->burst_count = defaults.burst_count;
+  }
+  if (!usb_hid_autofire_burst_interval_is_valid(settings->burst_interval_ms)) {
+    settings->burst_interval_ms = defaults.burst_interval_ms;
+  }
+  if (!usb_hid_autofire_transport_is_valid(settings->transport)) {
+    settings->transport = defaults.transport;
+  }
+
+  app->autofire_delay_ms = usb_hid_autofire_delay_clamp(settings->delay_ms);
+  app->mode = (AutofireMode)settings->mode;
+  app->preset = (AutofirePreset)settings->preset;
   app->startup_policy = AutofireStartupPolicyPausedOnLaunch;
-  app->last_active_state = last_active;
+  app->last_active_state = settings->last_active != 0U;
+  app->late_policy = (AutofireLatePolicy)settings->late_policy;
+  app->duty_percent = settings->duty_percent;
+  app->frame_align_ms = settings->frame_align_ms;
+  app->target_cps_x10 = settings->target_cps_x10;
+  app->key_code = settings->key_code;
+  app->key_modifiers = settings->key_modifiers;
+  memcpy(app->channels, settings->channels, sizeof(app->channels));
+  app->sequence_enabled = settings->sequence_enabled == 1U;
+  app->burst_count = settings->burst_count;
+  app->burst_interval_ms = settings->burst_interval_ms;
+  app->hold_to_fire = settings->hold_to_fire == 1U;
+  app->transport_type = (AutofireTransportType)settings->transport;
+  app->capture_enabled = settings->capture == 1U;
+  app->input_log_enabled = settings->input_log == 1U;
 
   if ((app->preset != AutofirePresetCustom) &&
       (app->autofire_delay_ms !=
@@ -131,12 +313,162 @@ bool usb_hid_autofire_settings_load(UsbHidAutofireApp *app) {
   return true;
 }
 
+bool usb_hid_autofire_settings_load(UsbHidAutofireApp *app) {
+  AutofireSettings settings;
+  bool migrate = false;
+  usb_hid_autofire_settings_defaults(&settings);
+
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  AutofireSettingsReadResult result = usb_hid_autofire_settings_read_record(
+      storage, USB_HID_AUTOFIRE_SETTINGS_PATH, &settings);
+  if (result == AutofireSettingsReadMissing) {
+    // A save interrupted between remove and rename.
+    result = usb_hid_autofire_settings_read_record(
+        storage, USB_HID_AUTOFIRE_SETTINGS_TEMP_PATH, &settings);
+  }
+  if (result == AutofireSettingsReadMissing) {
+    migrate = usb_hid_autofire_settings_read_legacy(storage, &settings);
+  }
+  furi_record_close(RECORD_STORAGE);
+
+  if (result == AutofireSettingsReadCorrupt) {
+    FURI_LOG_W(TAG, "Settings record is corrupt, using defaults");
+    return false;
+  }
+  if (((result != AutofireSettingsReadOk) && !migrate) ||
+      !usb_hid_autofire_settings_apply(app, &settings)) {
+    return false;
+  }
+
+  // Unchanged settings need no write until the user changes something.
+  AutofireSettingsWriter *writer = &app->settings_writer;
+  usb_hid_autofire_settings_snapshot(app, &writer->written);
+  writer->has_written = !migrate;
+
+  // Only drop the text file once its values are safely in the record.
+  if (migrate && usb_hid_autofire_settings_write(&writer->written)) {
+    writer->has_written = true;
+    storage = furi_record_open(RECORD_STORAGE);
+    storage_common_remove(storage, USB_HID_AUTOFIRE_SETTINGS_LEGACY_PATH);
+    furi_record_close(RECORD_STORAGE);
+    FURI_LOG_I(TAG, "Migrated text settings to binary record");
+  }
+
+  return true;
+}
+
+// Hands a snapshot to the writer; a newer snapshot replaces one that has
+// not been written yet.
 void usb_hid_autofire_settings_flush_if_dirty(UsbHidAutofireApp *app) {
-  if (!app->settings_dirty) {
+  AutofireSettingsWriter *writer = &app->settings_writer;
+  if (!app->settings_dirty || !writer->thread) {
     return;
   }
 
-  if (usb_hid_autofire_settings_save(app)) {
-    app->settings_dirty = false;
+  furi_mutex_acquire(writer->mutex, FuriWaitForever);
+  usb_hid_autofire_settings_snapshot(app, &writer->pending);
+  writer->has_pending = true;
+  furi_mutex_release(writer->mutex);
+  furi_thread_flags_set(furi_thread_get_id(writer->thread),
+                        SettingsWriterFlagSave);
+  app->settings_dirty = false;
+}
+
+static int32_t usb_hid_autofire_settings_writer(void *ctx) {
+  UsbHidAutofireApp *app = ctx;
+  AutofireSettingsWriter *writer = &app->settings_writer;
+  bool running = true;
+
+  while (running) {
+    uint32_t flags = furi_thread_flags_wait(SETTINGS_WRITER_FLAGS_ALL,
+                                            FuriFlagWaitAny, FuriWaitForever);
+    if (flags & FuriFlagError) {
+      continue;
+    }
+    // A save posted together with exit is still written.
+    running = (flags & SettingsWriterFlagExit) == 0U;
+
+    AutofireSettings settings;
+    furi_mutex_acquire(writer->mutex, FuriWaitForever);
+    bool has_pending = writer->has_pending;
+    settings = writer->pending;
+    writer->has_pending = false;
+    furi_mutex_release(writer->mutex);
+    if (!has_pending) {
+      continue;
+    }
+
+    if (writer->has_written &&
+        (memcmp(&settings, &writer->written, sizeof(AutofireSettings)) == 0)) {
+      furi_mutex_acquire(writer->mutex, FuriWaitForever);
+      writer->skips++;
+      furi_mutex_release(writer->mutex);
+      continue;
+    }
+
+    uint32_t start_tick = furi_get_tick();
+    AUTOFIRE_PROFILE_BEGIN(save_start);
+    bool success = usb_hid_autofire_settings_write(&settings);
+    AUTOFIRE_PROFILE_END(app, AutofireProfileSave, save_start);
+    uint32_t elapsed_ms = furi_get_tick() - start_tick;
+    if (success) {
+      writer->written = settings;
+      writer->has_written = true;
+    }
+
+    furi_mutex_acquire(writer->mutex, FuriWaitForever);
+    if (success) {
+      writer->writes++;
+    } else {
+      writer->failures++;
+    }
+    writer->last_ms = elapsed_ms;
+    if (elapsed_ms > writer->worst_ms) {
+      writer->worst_ms = elapsed_ms;
+    }
+    furi_mutex_release(writer->mutex);
+  }
+
+  return 0;
+}
+
+bool usb_hid_autofire_settings_writer_start(UsbHidAutofireApp *app) {
+  AutofireSettingsWriter *writer = &app->settings_writer;
+  writer->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+  if (!writer->mutex) {
+    return false;
+  }
+
+  writer->thread = furi_thread_alloc_ex(
+      "AutofireSettingsWriter", SETTINGS_WRITER_STACK_SIZE,
+      usb_hid_autofire_settings_writer, app);
+  if (!writer->thread) {
+    return false;
+  }
+  furi_thread_set_priority(writer->thread, FuriThreadPriorityLow);
+  furi_thread_start(writer->thread);
+  return true;
+}
+
+// Stops the writer after it has written any pending snapshot.
+void usb_hid_autofire_settings_writer_stop(UsbHidAutofireApp *app) {
+  AutofireSettingsWriter *writer = &app->settings_writer;
+  if (writer->thread) {
+    furi_thread_flags_set(furi_thread_get_id(writer->thread),
+                          SettingsWriterFlagExit);
+    furi_thread_join(writer->thread);
+    furi_thread_free(writer->thread);
+    writer->thread = NULL;
+    FURI_LOG_I(TAG,
+               "Settings writer: %lu writes, %lu skipped, %lu failed, worst "
+               "%lums",
+               (unsigned long)writer->writes, (unsigned long)writer->skips,
+               (unsigned long)writer->failures,
+               (unsigned long)writer->worst_ms);
+  }
+
+  if (writer->mutex) {
+    furi_mutex_free(writer->mutex);
+    writer->mutex = NULL;
   }
 }
@@ -0,0 +1,238 @@
+#include "usb_hid_autofire_i.h"
+
+// Adding a fire target only takes a new row here and in AutofireMode.
+static const AutofireTarget usb_hid_autofire_targets[AutofireModeCount] = {
+    [AutofireModeMouseLeftClick] = {AutofireTargetKindMouse,
+                                    HID_MOUSE_BTN_LEFT, "Mouse Left"},
+    [AutofireModeMouseRightClick] = {AutofireTargetKindMouse,
+                                     HID_MOUSE_BTN_RIGHT, "Mouse Right"},
+    [AutofireModeKeyboardEnter] = {AutofireTargetKindKeyboard,
+                                   HID_KEYBOARD_RETURN, "Key Enter"},
+    [AutofireModeKeyboardSpace] = {AutofireTargetKindKeyboard,
+                                   HID_KEYBOARD_SPACEBAR, "Key Space"},
+    [AutofireModeMouseMiddleClick] = {AutofireTargetKindMouse,
+                                      HID_MOUSE_BTN_WHEEL, "Mouse Middle"},
+    [AutofireModeKeyboardCustom] = {AutofireTargetKindKeyboard, 0U, "Key"},
+};
+
+typedef struct {
+  uint8_t code;
+  const char *name;
+} AutofireKeyName;
+
+// Keys without a letter, digit or F-key name.
+static const AutofireKeyName usb_hid_autofire_key_names[] = {
+    {0x28U, "Enter"}, {0x29U, "Esc"},   {0x2AU, "Bksp"},  {0x2BU, "Tab"},
+    {0x2CU, "Space"}, {0x2DU, "-"},     {0x2EU, "="},     {0x2FU, "["},
+    {0x30U, "]"},     {0x31U, "\\"},    {0x33U, ";"},     {0x34U, "'"},
+    {0x35U, "`"},     {0x36U, ","},     {0x37U, "."},     {0x38U, "/"},
+    {0x39U, "Caps"},  {0x46U, "PrtSc"}, {0x47U, "ScrLk"}, {0x48U, "Pause"},
+    {0x49U, "Ins"},   {0x4AU, "Home"},  {0x4BU, "PgUp"},  {0x4CU, "Del"},
+    {0x4DU, "End"},   {0x4EU, "PgDn"},  {0x4FU, "Right"}, {0x50U, "Left"},
+    {0x51U, "Down"},  {0x52U, "Up"},    {0x65U, "Menu"},
+};
+
+// Mouse buttons in sequence files; "Left" and "Right" name arrow keys.
+static const AutofireKeyName usb_hid_autofire_button_names[] = {
+    {HID_MOUSE_BTN_LEFT, "LClick"},
+    {HID_MOUSE_BTN_RIGHT, "RClick"},
+    {HID_MOUSE_BTN_WHEEL, "MClick"},
+};
+
+static const char *usb_hid_autofire_modifier_names[] = {"Ctrl", "Shift", "Alt",
+                                                        "GUI"};
+
+const AutofireTarget *usb_hid_autofire_target(AutofireMode mode) {
+  return &usb_hid_autofire_targets[(mode < AutofireModeCount)
+                                       ? mode
+                                       : AutofireModeMouseLeftClick];
+}
+
+void usb_hid_autofire_hid_batch_add(AutofireHidBatch *batch,
+                                    AutofireTargetKind kind, uint16_t code,
+                                    bool press) {
+  furi_check(batch->count < AUTOFIRE_CHANNEL_COUNT);
+  batch->changes[batch->count++] =
+      (AutofireHidChange){.kind = kind, .code = code, .press = press};
+}
+
+// Sends the releases before the presses so a key that one channel lets go
+// of and another presses ends up held. Mouse buttons are a bit mask in one
+// report, so all mouse changes of a direction go out in a single call;
+// keyboard usages take one call each. Returns the number of reports sent.
+uint32_t usb_hid_autofire_hid_batch_flush(AutofireHidBatch *batch,
+                                          AutofireTransport *transport) {
+  uint32_t reports = 0U;
+  for (uint32_t pass = 0U; pass < 2U; pass++) {
+    bool press = (pass == 1U);
+    uint16_t mouse_mask = 0U;
+    for (uint32_t i = 0U; i < batch->count; i++) {
+      const AutofireHidChange *change = &batch->changes[i];
+      if (change->press != press) {
+        continue;
+      }
+      if (change->kind == AutofireTargetKindMouse) {
+        mouse_mask |= change->code;
+        continue;
+      }
+      usb_hid_autofire_transport_send(transport, change->kind, change->code,
+                                      press);
+      reports++;
+    }
+    if (mouse_mask != 0U) {
+      usb_hid_autofire_transport_send(transport, AutofireTargetKindMouse,
+                                      mouse_mask, press);
+      reports++;
+    }
+  }
+
+  batch->count = 0U;
+  return reports;
+}
+
+// Keyboard codes carry the modifier mask in the high byte, which is how
+// furi_hal_hid_kb_press() takes key combos.
+uint16_t usb_hid_autofire_target_code(AutofireMode mode, uint32_t key_code,
+                                      uint32_t key_modifiers) {
+  const AutofireTarget *target = usb_hid_autofire_target(mode);
+  if (target->kind != AutofireTargetKindKeyboard) {
+    return target->code;
+  }
+
+  uint16_t code = (target->code != 0U) ? target->code : (uint16_t)key_code;
+  return code | (uint16_t)((key_modifiers & AUTOFIRE_KEY_MODIFIERS_MASK) << 8);
+}
+
+void usb_hid_autofire_format_key(char *out, size_t out_size,
+                                 uint32_t key_code) {
+  if ((key_code >= 0x04U) && (key_code <= 0x1DU)) {
+    snprintf(out, out_size, "%c", (char)('A' + (key_code - 0x04U)));
+  } else if ((key_code >= 0x1EU) && (key_code <= 0x27U)) {
+    snprintf(out, out_size, "%c", (char)('0' + ((key_code - 0x1DU) % 10U)));
+  } else if ((key_code >= 0x3AU) && (key_code <= 0x45U)) {
+    snprintf(out, out_size, "F%lu", (unsigned long)(key_code - 0x39U));
+  } else {
+    snprintf(out, out_size, "0x%02lX", (unsigned long)key_code);
+    for (size_t i = 0; i < COUNT_OF(usb_hid_autofire_key_names); i++) {
+      if (usb_hid_autofire_key_names[i].code == key_code) {
+        snprintf(out, out_size, "%s", usb_hid_autofire_key_names[i].name);
+        break;
+      }
+    }
+  }
+}
+
+void usb_hid_autofire_format_modifiers(char *out, size_t out_size,
+                                       uint32_t key_modifiers) {
+  size_t length = 0U;
+  out[0] = '\0';
+  for (size_t i = 0; i < COUNT_OF(usb_hid_autofire_modifier_names); i++) {
+    if ((key_modifiers & (1UL << i)) && (length < out_size)) {
+      int written = snprintf(out + length, out_size - length, "%s%s",
+                             (length > 0U) ? "+" : "",
+                             usb_hid_autofire_modifier_names[i]);
+      length += (written > 0) ? (size_t)written : 0U;
+    }
+  }
+}
+
+void usb_hid_autofire_format_target(char *out, size_t out_size,
+                                    AutofireMode mode, uint32_t key_code,
+                                    uint32_t key_modifiers) {
+  const AutofireTarget *target = usb_hid_autofire_target(mode);
+  char modifiers_str[24];
+  char key_str[8];
+
+  modifiers_str[0] = '\0';
+  if (target->kind == AutofireTargetKindKeyboard) {
+    usb_hid_autofire_format_modifiers(modifiers_str, sizeof(modifiers_str),
+                                      key_modifiers);
+  }
+
+  key_str[0] = '\0';
+  if (target->code == 0U) {
+    usb_hid_autofire_format_key(key_str, sizeof(key_str), key_code);
+  }
+  snprintf(out, out_size, "%s%s%s%s%s", modifiers_str,
+           (modifiers_str[0] != '\0') ? "+" : "", target->label,
+           (key_str[0] != '\0') ? " " : "", key_str);
+}
+
+// Parses a sequence target: a mouse button name, or a key as
+// usb_hid_autofire_format_key() shows it or as a 0x usage, after optional
+// modifiers such as "Ctrl+Shift+".
+bool usb_hid_autofire_parse_target(const char *name, AutofireTargetKind *kind,
+                                   uint16_t *code) {
+  for (size_t i = 0; i < COUNT_OF(usb_hid_autofire_button_names); i++) {
+    if (strcasecmp(name, usb_hid_autofire_button_names[i].name) == 0) {
+      *kind = AutofireTargetKindMouse;
+      *code = usb_hid_autofire_button_names[i].code;
+      return true;
+    }
+  }
+
+  uint32_t modifiers = 0U;
+  const char *plus;
+  while ((plus = strchr(name, '+')) && (plus[1] != '\0')) {
+    size_t length = (size_t)(plus - name);
+    size_t i = 0;
+    while ((i < COUNT_OF(usb_hid_autofire_modifier_names)) &&
+           ((strlen(usb_hid_autofire_modifier_names[i]) != length) ||
+            (strncasecmp(name, usb_hid_autofire_modifier_names[i], length) !=
+             0))) {
+      i++;
+    }
+    if (i == COUNT_OF(usb_hid_autofire_modifier_names)) {
+      return false;
+    }
+    modifiers |= 1UL << i;
+    name = plus + 1;
+  }
+
+  uint32_t key_code = 0U;
+  if (strncasecmp(name, "0x", 2) == 0) {
+    char *end = NULL;
+    key_code = strtoul(name, &end, 16);
+    if (*end != '\0') {
+      return false;
+    }
+  } else {
+    char key_str[8];
+    for (uint32_t candidate = AUTOFIRE_KEY_CODE_MIN;
+         candidate <= AUTOFIRE_KEY_CODE_MAX; candidate++) {
+      usb_hid_autofire_format_key(key_str, sizeof(key_str), candidate);
+      if (strcasecmp(name, key_str) == 0) {
+        key_code = candidate;
+        break;
+      }
+    }
+  }
+  if (!usb_hid_autofire_key_code_is_valid(key_code)) {
+    return false;
+  }
+
+  *kind = AutofireTargetKindKeyboard;
+  *code = (uint16_t)(key_code | (modifiers << 8));
+  return true;
+}
+
+AutofireMode usb_hid_autofire_next_mode(AutofireMode mode) {
+  return (AutofireMode)((mode + 1U) % AutofireModeCount);
+}
+
+AutofireMode usb_hid_autofire_prev_mode(AutofireMode mode) {
+  return (AutofireMode)((mode + AutofireModeCount - 1U) % AutofireModeCount);
+}
+
+bool usb_hid_autofire_mode_is_valid(uint32_t mode_value) {
+  return mode_value < (uint32_t)AutofireModeCount;
+}
+
+bool usb_hid_autofire_key_code_is_valid(uint32_t key_code) {
+  return (key_code >= AUTOFIRE_KEY_CODE_MIN) &&
+         (key_code <= AUTOFIRE_KEY_CODE_MAX);
+}
+
+bool usb_hid_autofire_key_modifiers_is_valid(uint32_t key_modifiers) {
+  return (key_modifiers & ~AUTOFIRE_KEY_MODIFIERS_MASK) == 0U;
+}
@@ -0,0 +1,180 @@
+#include "usb_hid_autofire_i.h"
+
+void usb_hid_autofire_trace_reset(AutofireClickTrace *trace) {
+  memset(trace, 0, sizeof(AutofireClickTrace));
+}
+
+void usb_hid_autofire_trace_record_press(AutofireClickTrace *trace,
+                                         uint32_t tick) {
+  AutofireClickSample *sample =
+      &trace->samples[trace->count & AUTOFIRE_TRACE_MASK];
+  sample->press_tick = tick;
+  sample->release_tick = tick;
+}
+
+void usb_hid_autofire_trace_record_release(AutofireClickTrace *trace,
+                                           uint32_t tick) {
+  trace->samples[trace->count & AUTOFIRE_TRACE_MASK].release_tick = tick;
+  trace->count++;
+}
+
+static uint32_t
+usb_hid_autofire_trace_stored(const AutofireClickTrace *trace) {
+  return (trace->count < AUTOFIRE_TRACE_SIZE) ? trace->count
+                                              : AUTOFIRE_TRACE_SIZE;
+}
+
+// Oldest-first access to the completed samples still held in the ring.
+static const AutofireClickSample *
+usb_hid_autofire_trace_sample(const AutofireClickTrace *trace,
+                              uint32_t index) {
+  uint32_t first = trace->count - usb_hid_autofire_trace_stored(trace);
+  return &trace->samples[(first + index) & AUTOFIRE_TRACE_MASK];
+}
+
+static uint32_t usb_hid_autofire_trace_percentile(const uint16_t *sorted,
+                                                  uint32_t count,
+                                                  uint32_t percent) {
+  uint32_t rank = ((percent * count) + 99U) / 100U;
+  return sorted[(rank > 0U) ? (rank - 1U) : 0U];
+}
+
+void usb_hid_autofire_trace_compute_stats(const AutofireClickTrace *trace,
+                                          AutofireTraceStats *stats) {
+  uint16_t intervals[AUTOFIRE_TRACE_SIZE - 1U];
+  uint32_t stored = usb_hid_autofire_trace_stored(trace);
+  uint32_t count = 0U;
+  uint32_t jitter_sum_ms = 0U;
+
+  memset(stats, 0, sizeof(AutofireTraceStats));
+  stats->clicks = trace->count;
+  if (stored < 2U) {
+    return;
+  }
+
+  // Press-to-press intervals, insertion sorted as they are collected. The
+  // jitter is the mean difference between consecutive intervals.
+  for (uint32_t i = 1U; i < stored; i++) {
+    uint32_t interval_ms =
+        usb_hid_autofire_trace_sample(trace, i)->press_tick -
+        usb_hid_autofire_trace_sample(trace, i - 1U)->press_tick;
+    if (interval_ms > UINT16_MAX) {
+      interval_ms = UINT16_MAX;
+    }
+
+    if (i > 1U) {
+      uint32_t previous_ms =
+          usb_hid_autofire_trace_sample(trace, i - 1U)->press_tick -
+          usb_hid_autofire_trace_sample(trace, i - 2U)->press_tick;
+      jitter_sum_ms += (interval_ms > previous_ms)
+                           ? (interval_ms - previous_ms)
+                           : (previous_ms - interval_ms);
+    }
+
+    uint32_t slot = count++;
+    while ((slot > 0U) && (intervals[slot - 1U] > interval_ms)) {
+      intervals[slot] = intervals[slot - 1U];
+      slot--;
+    }
+    intervals[slot] = (uint16_t)interval_ms;
+  }
+
+  stats->intervals = count;
+  stats->min_ms = intervals[0];
+  stats->max_ms = intervals[count - 1U];
+  stats->p50_ms = usb_hid_autofire_trace_percentile(intervals, count, 50U);
+  stats->p99_ms = usb_hid_autofire_trace_percentile(intervals, count, 99U);
+  if (count > 1U) {
+    stats->jitter_x10_ms =
+        ((jitter_sum_ms * 10U) + ((count - 1U) / 2U)) / (count - 1U);
+  }
+}
+
+bool usb_hid_autofire_trace_export(const AutofireClickTrace *trace) {
+  bool success = false;
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  File *file = storage_file_alloc(storage);
+
+  if (file && storage_file_open(file, USB_HID_AUTOFIRE_TRACE_EXPORT_PATH,
+                                FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+    char line[64];
+    const char *header = "click,press_ms,release_ms,hold_ms,interval_ms\n";
+    size_t header_length = strlen(header);
+    success =
+        storage_file_write(file, header, header_length) == header_length;
+
+    uint32_t stored = usb_hid_autofire_trace_stored(trace);
+    uint32_t first = trace->count - stored;
+    for (uint32_t i = 0U; success && (i < stored); i++) {
+      const AutofireClickSample *sample =
+          usb_hid_autofire_trace_sample(trace, i);
+      uint32_t interval_ms = 0U;
+      if (i > 0U) {
+        interval_ms = sample->press_tick -
+                      usb_hid_autofire_trace_sample(trace, i - 1U)->press_tick;
+      }
+      int length = snprintf(
+          line, sizeof(line), "%lu,%lu,%lu,%lu,%lu\n",
+          (unsigned long)(first + i), (unsigned long)sample->press_tick,
+          (unsigned long)sample->release_tick,
+          (unsigned long)(sample->release_tick - sample->press_tick),
+          (unsigned long)interval_ms);
+      success = (length > 0) &&
+                (storage_file_write(file, line, (size_t)length) ==
+                 (size_t)length);
+    }
+    storage_file_close(file);
+  }
+
+  if (file) {
+    storage_file_free(file);
+  }
+  furi_record_close(RECORD_STORAGE);
+
+  if (!success) {
+    FURI_LOG_W(TAG, "Failed to export click trace");
+  }
+
+  return success;
+}
+
+bool usb_hid_autofire_export_trace(UsbHidAutofireApp *app) {
+  // Export a copy so the SD write never holds the engine lock.
+  AutofireClickTrace *trace = malloc(sizeof(AutofireClickTrace));
+  furi_mutex_acquire(app->engine_mutex, FuriWaitForever);
+  memcpy(trace, app->engine.trace, sizeof(AutofireClickTrace));
+  furi_mutex_release(app->engine_mutex);
+
+  bool success = usb_hid_autofire_trace_export(trace);
+  free(trace);
+  return success;
+}
+
+// Returns true when the stats screen changed.
+bool usb_hid_autofire_refresh_trace_stats(UsbHidAutofireApp *app) {
+  AutofireTraceStats stats;
+  AutofireDropStats drops;
+  furi_mutex_acquire(app->engine_mutex, FuriWaitForever);
+  usb_hid_autofire_trace_compute_stats(app->engine.trace, &stats);
+  drops.ticks = app->engine.tick_drops;
+  drops.sequence_underruns = app->sequence.stream.underruns;
+  furi_mutex_release(app->engine_mutex);
+  for (size_t i = 0; i < EventTypeCount; i++) {
+    drops.events[i] = __atomic_load_n(&app->event_drops[i], __ATOMIC_RELAXED);
+  }
+
+  bool changed = false;
+  if (memcmp(&stats, &app->trace_stats, sizeof(AutofireTraceStats)) != 0) {
+    app->trace_stats = stats;
+    changed = true;
+  }
+  if (memcmp(&drops, &app->drop_stats, sizeof(AutofireDropStats)) != 0) {
+    app->drop_stats = drops;
+    changed = true;
+  }
+  if (changed) {
+    usb_hid_autofire_view_invalidate(app, AutofireViewPage);
+  }
+
+  return changed;
+}
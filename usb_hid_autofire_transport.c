@@ -0,0 +1,249 @@
+#include "usb_hid_autofire_i.h"
+
+static const char *usb_hid_autofire_transport_labels[AutofireTransportCount] =
+    {
+        [AutofireTransportUsb] = "USB",
+        [AutofireTransportBle] = "BLE",
+        [AutofireTransportLoopback] = "Loopback",
+};
+
+static bool usb_hid_autofire_usb_open(AutofireTransport *transport) {
+  transport->usb_mode_prev = furi_hal_usb_get_config();
+  furi_hal_usb_unlock();
+  return furi_hal_usb_set_config(&usb_hid, NULL);
+}
+
+static void usb_hid_autofire_usb_close(AutofireTransport *transport) {
+  furi_hal_usb_set_config(transport->usb_mode_prev, NULL);
+}
+
+static bool usb_hid_autofire_usb_press(AutofireTransport *transport,
+                                       AutofireTargetKind kind,
+                                       uint16_t code) {
+  UNUSED(transport);
+  return (kind == AutofireTargetKindMouse)
+             ? furi_hal_hid_mouse_press((uint8_t)code)
+             : furi_hal_hid_kb_press(code);
+}
+
+static bool usb_hid_autofire_usb_release(AutofireTransport *transport,
+                                         AutofireTargetKind kind,
+                                         uint16_t code) {
+  UNUSED(transport);
+  return (kind == AutofireTargetKindMouse)
+             ? furi_hal_hid_mouse_release((uint8_t)code)
+             : furi_hal_hid_kb_release(code);
+}
+
+static bool usb_hid_autofire_usb_release_all(AutofireTransport *transport) {
+  UNUSED(transport);
+  return furi_hal_hid_kb_release_all();
+}
+
+// Pairing keys go to the app folder so the app does not touch the bonds of
+// the stock profile, as the firmware's own HID remote does.
+static bool usb_hid_autofire_ble_open(AutofireTransport *transport) {
+  transport->bt = furi_record_open(RECORD_BT);
+  bt_disconnect(transport->bt);
+  furi_delay_ms(AUTOFIRE_BLE_DISCONNECT_WAIT_MS);
+  bt_keys_storage_set_storage_path(transport->bt,
+                                   USB_HID_AUTOFIRE_BLE_KEYS_PATH);
+  transport->ble_profile =
+      bt_profile_start(transport->bt, ble_profile_hid, NULL);
+  if (!transport->ble_profile) {
+    bt_keys_storage_set_default_path(transport->bt);
+    furi_record_close(RECORD_BT);
+    transport->bt = NULL;
+    return false;
+  }
+  furi_hal_bt_start_advertising();
+  return true;
+}
+
+static void usb_hid_autofire_ble_close(AutofireTransport *transport) {
+  bt_disconnect(transport->bt);
+  furi_delay_ms(AUTOFIRE_BLE_DISCONNECT_WAIT_MS);
+  bt_keys_storage_set_default_path(transport->bt);
+  if (!bt_profile_restore_default(transport->bt)) {
+    FURI_LOG_W(TAG, "Failed to restore the default BLE profile");
+  }
+  furi_record_close(RECORD_BT);
+  transport->bt = NULL;
+  transport->ble_profile = NULL;
+}
+
+static bool usb_hid_autofire_ble_press(AutofireTransport *transport,
+                                       AutofireTargetKind kind,
+                                       uint16_t code) {
+  return (kind == AutofireTargetKindMouse)
+             ? ble_profile_hid_mouse_press(transport->ble_profile,
+                                           (uint8_t)code)
+             : ble_profile_hid_kb_press(transport->ble_profile, code);
+}
+
+static bool usb_hid_autofire_ble_release(AutofireTransport *transport,
+                                         AutofireTargetKind kind,
+                                         uint16_t code) {
+  return (kind == AutofireTargetKindMouse)
+             ? ble_profile_hid_mouse_release(transport->ble_profile,
+                                             (uint8_t)code)
+             : ble_profile_hid_kb_release(transport->ble_profile, code);
+}
+
+static bool usb_hid_autofire_ble_release_all(AutofireTransport *transport) {
+  return ble_profile_hid_kb_release_all(transport->ble_profile);
+}
+
+static bool usb_hid_autofire_loopback_open(AutofireTransport *transport) {
+  AutofireLoopback *loopback = &transport->loopback;
+  loopback->reports =
+      malloc(AUTOFIRE_LOOPBACK_CAPACITY * sizeof(AutofireLoopbackReport));
+  loopback->count = 0U;
+  loopback->total = 0U;
+  return loopback->reports != NULL;
+}
+
+static void usb_hid_autofire_loopback_close(AutofireTransport *transport) {
+  AutofireLoopback *loopback = &transport->loopback;
+  FURI_LOG_I(TAG, "Loopback: %lu reports, %lu recorded",
+             (unsigned long)loopback->total, (unsigned long)loopback->count);
+  usb_hid_autofire_loopback_export(loopback);
+  free(loopback->reports);
+  loopback->reports = NULL;
+}
+
+// Runs on the click worker only, so recording takes no lock. A full buffer
+// keeps the first reports and counts the rest.
+static bool usb_hid_autofire_loopback_record(AutofireTransport *transport,
+                                             AutofireTargetKind kind,
+                                             uint16_t code, bool press) {
+  AutofireLoopback *loopback = &transport->loopback;
+  loopback->total++;
+  if (!loopback->reports || (loopback->count >= AUTOFIRE_LOOPBACK_CAPACITY)) {
+    return true;
+  }
+  loopback->reports[loopback->count++] = (AutofireLoopbackReport){
+      .tick = furi_get_tick(),
+      .code = code,
+      .kind = (uint8_t)kind,
+      .press = press ? 1U : 0U,
+  };
+  return true;
+}
+
+static bool usb_hid_autofire_loopback_press(AutofireTransport *transport,
+                                            AutofireTargetKind kind,
+                                            uint16_t code) {
+  return usb_hid_autofire_loopback_record(transport, kind, code, true);
+}
+
+static bool usb_hid_autofire_loopback_release(AutofireTransport *transport,
+                                              AutofireTargetKind kind,
+                                              uint16_t code) {
+  return usb_hid_autofire_loopback_record(transport, kind, code, false);
+}
+
+// Recorded as a keyboard release of usage 0.
+static bool
+usb_hid_autofire_loopback_release_all(AutofireTransport *transport) {
+  return usb_hid_autofire_loopback_record(
+      transport, AutofireTargetKindKeyboard, 0U, false);
+}
+
+static const AutofireTransportOps
+    usb_hid_autofire_transport_ops[AutofireTransportCount] = {
+        [AutofireTransportUsb] = {usb_hid_autofire_usb_open,
+                                  usb_hid_autofire_usb_close,
+                                  usb_hid_autofire_usb_press,
+                                  usb_hid_autofire_usb_release,
+                                  usb_hid_autofire_usb_release_all},
+        [AutofireTransportBle] = {usb_hid_autofire_ble_open,
+                                  usb_hid_autofire_ble_close,
+                                  usb_hid_autofire_ble_press,
+                                  usb_hid_autofire_ble_release,
+                                  usb_hid_autofire_ble_release_all},
+        [AutofireTransportLoopback] = {usb_hid_autofire_loopback_open,
+                                       usb_hid_autofire_loopback_close,
+                                       usb_hid_autofire_loopback_press,
+                                       usb_hid_autofire_loopback_release,
+                                       usb_hid_autofire_loopback_release_all},
+};
+
+void usb_hid_autofire_transport_init(AutofireTransport *transport,
+                                     AutofireTransportType type) {
+  if (!usb_hid_autofire_transport_is_valid(type)) {
+    type = AutofireTransportUsb;
+  }
+  *transport = (AutofireTransport){
+      .type = type,
+      .ops = &usb_hid_autofire_transport_ops[type],
+  };
+}
+
+bool usb_hid_autofire_transport_open(AutofireTransport *transport) {
+  transport->opened = transport->ops->open(transport);
+  return transport->opened;
+}
+
+void usb_hid_autofire_transport_close(AutofireTransport *transport) {
+  if (transport->opened) {
+    transport->ops->close(transport);
+    transport->opened = false;
+  }
+}
+
+bool usb_hid_autofire_transport_send(AutofireTransport *transport,
+                                     AutofireTargetKind kind, uint16_t code,
+                                     bool press) {
+  return press ? transport->ops->press(transport, kind, code)
+               : transport->ops->release(transport, kind, code);
+}
+
+bool usb_hid_autofire_transport_is_valid(uint32_t transport_type) {
+  return transport_type < (uint32_t)AutofireTransportCount;
+}
+
+const char *usb_hid_autofire_transport_label(AutofireTransportType type) {
+  return usb_hid_autofire_transport_is_valid(type)
+             ? usb_hid_autofire_transport_labels[type]
+             : "Unknown";
+}
+
+bool usb_hid_autofire_loopback_export(const AutofireLoopback *loopback) {
+  bool success = false;
+  Storage *storage = furi_record_open(RECORD_STORAGE);
+  File *file = storage_file_alloc(storage);
+
+  if (file && storage_file_open(file, USB_HID_AUTOFIRE_LOOPBACK_EXPORT_PATH,
+                                FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+    char line[48];
+    const char *header = "report,tick_ms,kind,code,press\n";
+    size_t header_length = strlen(header);
+    success =
+        storage_file_write(file, header, header_length) == header_length;
+
+    for (uint32_t i = 0U; success && (i < loopback->count); i++) {
+      const AutofireLoopbackReport *report = &loopback->reports[i];
+      int length = snprintf(
+          line, sizeof(line), "%lu,%lu,%s,0x%04X,%u\n", (unsigned long)i,
+          (unsigned long)report->tick,
+          (report->kind == AutofireTargetKindMouse) ? "mouse" : "key",
+          (unsigned)report->code, (unsigned)report->press);
+      success = (length > 0) &&
+                (storage_file_write(file, line, (size_t)length) ==
+                 (size_t)length);
+    }
+    storage_file_close(file);
+  }
+
+  if (file) {
+    storage_file_free(file);
+  }
+  furi_record_close(RECORD_STORAGE);
+
+  if (!success) {
+    FURI_LOG_W(TAG, "Failed to export loopback reports");
+  }
+
+  return success;
+}
@@ -2,63 +2,606 @@
 #include "version.h"
 #include <usb_hid_autofire_icons.h>
 
-void usb_hid_autofire_render_callback(Canvas *canvas, void *ctx) {
-  UsbHidAutofireApp *app = ctx;
-  char status_str[24];
-  char mode_str[24];
-  char preset_str[24];
-  char delay_rate_str[40];
-  char cps_str[24];
+#define OPTIONS_VISIBLE_ROWS 4U
 
-  canvas_clear(canvas);
+static void usb_hid_autofire_draw_page_arrows(Canvas *canvas) {
+  canvas_draw_icon(canvas, 115, 2, &I_ButtonLeft_4x7);
+  canvas_draw_icon(canvas, 122, 2, &I_ButtonRight_4x7);
+}
 
-  if (app->show_help) {
-    canvas_set_font(canvas, FontPrimary);
-    canvas_draw_str(canvas, 0, 10, "Autofire Help");
+static void usb_hid_autofire_render_help(Canvas *canvas,
+                                         const AutofireViewModel *view) {
+  canvas_set_font(canvas, FontPrimary);
+  canvas_draw_str(canvas, 0, 10, "Autofire Help");
+  usb_hid_autofire_draw_page_arrows(canvas);
 
-    canvas_set_font(canvas, FontSecondary);
-    canvas_draw_icon(canvas, 0, 14, &I_Ok_btn_9x9);
-    canvas_draw_str(canvas, 12, 22, "start/pause");
+  canvas_set_font(canvas, FontSecondary);
+  canvas_draw_icon(canvas, 0, 14, &I_Ok_btn_9x9);
+  canvas_draw_str(canvas, 12, 22, view->lines[0]);
 
-    canvas_draw_icon(canvas, 0, 24, &I_Ok_btn_9x9);
-    canvas_draw_str(canvas, 12, 32, "long: cycle preset");
+  canvas_draw_icon(canvas, 0, 24, &I_Ok_btn_9x9);
+  canvas_draw_str(canvas, 12, 32, view->lines[1]);
 
-    canvas_draw_icon(canvas, 0, 36, &I_ButtonUp_7x4);
-    canvas_draw_icon(canvas, 9, 36, &I_ButtonDown_7x4);
-    canvas_draw_str(canvas, 20, 42, "tap+hold: mode");
+  canvas_draw_icon(canvas, 0, 36, &I_ButtonUp_7x4);
+  canvas_draw_icon(canvas, 9, 36, &I_ButtonDown_7x4);
+  canvas_draw_str(canvas, 20, 42, "tap+hold: mode");
 
-    canvas_draw_icon(canvas, 0, 45, &I_ButtonLeft_4x7);
-    canvas_draw_icon(canvas, 7, 45, &I_ButtonRight_4x7);
-    canvas_draw_str(canvas, 20, 52, "tap+hold: delay");
+  canvas_draw_icon(canvas, 0, 45, &I_ButtonLeft_4x7);
+  canvas_draw_icon(canvas, 7, 45, &I_ButtonRight_4x7);
+  canvas_draw_str(canvas, 20, 52, "tap+hold: delay");
 
-    canvas_draw_icon(canvas, 0, 55, &I_Pin_back_arrow_10x8);
-    canvas_draw_str(canvas, 13, 63, "close");
-    return;
+  canvas_draw_icon(canvas, 0, 55, &I_Pin_back_arrow_10x8);
+  canvas_draw_str(canvas, 13, 63, "close");
+}
+
+typedef char AutofireViewLine[AUTOFIRE_VIEW_LINE_SIZE];
+
+// A long OK press is part of a hold under hold-to-fire, so it cannot cycle
+// the preset there.
+static void usb_hid_autofire_format_help(AutofireViewLine *lines,
+                                         const UsbHidAutofireApp *app) {
+  if (app->hold_to_fire) {
+    snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "hold: fire");
+    snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "release: stop");
+  } else {
+    snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "start/pause");
+    snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "long: cycle preset");
+  }
+}
+
+// Empty lines are part of the layout but draw nothing.
+static void usb_hid_autofire_draw_line(Canvas *canvas, int32_t x, int32_t y,
+                                       const char *line) {
+  if (line[0] != '\0') {
+    canvas_draw_str(canvas, x, y, line);
+  }
+}
+
+static void usb_hid_autofire_format_stats(AutofireViewLine *lines,
+                                          const UsbHidAutofireApp *app) {
+  const AutofireTraceStats *stats = &app->trace_stats;
+  const AutofireDropStats *drops = &app->drop_stats;
+
+  snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "Clicks:%lu  Late:%lu",
+           (unsigned long)stats->clicks, (unsigned long)drops->ticks);
+  // Queue drops: input / refresh / settings save, then sequence underruns
+  // when one streams from SD.
+  int length = snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "Drop:%lu/%lu/%lu",
+                        (unsigned long)drops->events[EventTypeInput],
+                        (unsigned long)drops->events[EventTypeUiRefresh],
+                        (unsigned long)drops->events[EventTypeSettingsSave]);
+  if (app->sequence.streamed && (length > 0) &&
+      ((size_t)length < AUTOFIRE_VIEW_LINE_SIZE)) {
+    snprintf(&lines[1][length], AUTOFIRE_VIEW_LINE_SIZE - (size_t)length,
+             " SD:%lu", (unsigned long)drops->sequence_underruns);
+  }
+
+  if (stats->intervals == 0U) {
+    snprintf(lines[2], AUTOFIRE_VIEW_LINE_SIZE, "No intervals yet");
+  } else {
+    snprintf(lines[2], AUTOFIRE_VIEW_LINE_SIZE, "Min:%lu  Max:%lu ms",
+             (unsigned long)stats->min_ms, (unsigned long)stats->max_ms);
+    snprintf(lines[3], AUTOFIRE_VIEW_LINE_SIZE, "P50:%lu  P99:%lu ms",
+             (unsigned long)stats->p50_ms, (unsigned long)stats->p99_ms);
+    snprintf(lines[4], AUTOFIRE_VIEW_LINE_SIZE, "Jit:%lu.%lums",
+             (unsigned long)(stats->jitter_x10_ms / 10U),
+             (unsigned long)(stats->jitter_x10_ms % 10U));
+  }
+
+  const char *export_str = "export to SD";
+  if (app->trace_export_result == AutofireExportResultOk) {
+    export_str = "saved to SD";
+  } else if (app->trace_export_result == AutofireExportResultFailed) {
+    export_str = "export failed";
+  }
+  snprintf(lines[5], AUTOFIRE_VIEW_LINE_SIZE, "%s", export_str);
+}
+
+static void usb_hid_autofire_render_stats(Canvas *canvas,
+                                          const AutofireViewModel *view) {
+  canvas_set_font(canvas, FontPrimary);
+  canvas_draw_str(canvas, 0, 10, "Click Stats");
+  usb_hid_autofire_draw_page_arrows(canvas);
+
+  canvas_set_font(canvas, FontSecondary);
+  usb_hid_autofire_draw_line(canvas, 0, 22, view->lines[0]);
+  canvas_draw_str_aligned(canvas, 128, 52, AlignRight, AlignBottom,
+                          view->lines[1]);
+  usb_hid_autofire_draw_line(canvas, 0, 32, view->lines[2]);
+  usb_hid_autofire_draw_line(canvas, 0, 42, view->lines[3]);
+  usb_hid_autofire_draw_line(canvas, 0, 52, view->lines[4]);
+  canvas_draw_icon(canvas, 0, 55, &I_Ok_btn_9x9);
+  usb_hid_autofire_draw_line(canvas, 12, 63, view->lines[5]);
+}
+
+static void usb_hid_autofire_format_option(char *out, size_t out_size,
+                                           const UsbHidAutofireApp *app,
+                                           AutofireOption option) {
+  char value_str[24];
+  const char *cursor = (app->option == option) ? "> " : "  ";
+
+  switch (option) {
+  case AutofireOptionTarget:
+    if (app->target_cps_x10 == 0U) {
+      snprintf(out, out_size, "%sTarget: off", cursor);
+    } else {
+      usb_hid_autofire_format_cps(value_str, sizeof(value_str),
+                                  app->target_cps_x10);
+      snprintf(out, out_size, "%sTarget: %s CPS", cursor, value_str);
+    }
+    break;
+  case AutofireOptionDuty: {
+    uint32_t hold_ms;
+    uint32_t gap_ms;
+    usb_hid_autofire_phase_ms(app->autofire_delay_ms, app->duty_percent,
+                              app->frame_align_ms, &hold_ms, &gap_ms);
+    snprintf(out, out_size, "%sDuty: %lu%%  %lu/%lums", cursor,
+             (unsigned long)app->duty_percent, (unsigned long)hold_ms,
+             (unsigned long)gap_ms);
+    break;
+  }
+  case AutofireOptionLatePolicy:
+    snprintf(out, out_size, "%sLate: %s", cursor,
+             usb_hid_autofire_late_policy_label(app->late_policy));
+    break;
+  case AutofireOptionFrameAlign:
+    if (app->frame_align_ms == 0U) {
+      snprintf(out, out_size, "%sSync: off", cursor);
+    } else {
+      usb_hid_autofire_format_cps(
+          value_str, sizeof(value_str),
+          usb_hid_autofire_max_lossless_cps_x10(app->frame_align_ms));
+      snprintf(out, out_size, "%sSync:%lums Max:%s", cursor,
+               (unsigned long)app->frame_align_ms, value_str);
+    }
+    break;
+  case AutofireOptionKeyCode:
+    usb_hid_autofire_format_key(value_str, sizeof(value_str), app->key_code);
+    snprintf(out, out_size, "%sKey: %s (0x%02lX)", cursor, value_str,
+             (unsigned long)app->key_code);
+    break;
+  case AutofireOptionKeyModifiers:
+    usb_hid_autofire_format_modifiers(value_str, sizeof(value_str),
+                                      app->key_modifiers);
+    snprintf(out, out_size, "%sMods: %s", cursor,
+             (value_str[0] != '\0') ? value_str : "none");
+    break;
+  case AutofireOptionSequence:
+    if (app->sequence.count == 0U) {
+      snprintf(out, out_size, "%sSequence: no file", cursor);
+    } else {
+      usb_hid_autofire_format_channel_delay(value_str, sizeof(value_str),
+                                            app->sequence.period_ms);
+      snprintf(out, out_size, "%sSequence: %s %s", cursor,
+               app->sequence_enabled ? "on" : "off", value_str);
+    }
+    break;
+  case AutofireOptionBurst:
+    if (app->burst_count == 0U) {
+      snprintf(out, out_size, "%sBurst: off", cursor);
+    } else {
+      snprintf(out, out_size, "%sBurst: %lu clicks", cursor,
+               (unsigned long)app->burst_count);
+    }
+    break;
+  case AutofireOptionBurstInterval:
+    if (app->burst_interval_ms == 0U) {
+      snprintf(out, out_size, "%sRepeat: once", cursor);
+    } else {
+      usb_hid_autofire_format_channel_delay(value_str, sizeof(value_str),
+                                            app->burst_interval_ms);
+      snprintf(out, out_size, "%sRepeat: after %s", cursor, value_str);
+    }
+    break;
+  case AutofireOptionTrigger:
+    snprintf(out, out_size, "%sOK: %s", cursor,
+             app->hold_to_fire ? "hold to fire" : "start/pause");
+    break;
+  case AutofireOptionTransport:
+    snprintf(out, out_size, "%sOutput: %s%s", cursor,
+             usb_hid_autofire_transport_label(app->transport_type),
+             (app->transport_type != app->transport.type) ? " (restart)"
+                                                          : "");
+    break;
+  case AutofireOptionCapture:
+    snprintf(out, out_size, "%sCapture: %s%s", cursor,
+             app->capture_enabled ? "on" : "off",
+             (app->capture_enabled != (app->capture.thread != NULL))
+                 ? " (restart)"
+                 : "");
+    break;
+  case AutofireOptionInputLog:
+    snprintf(out, out_size, "%sInput log: %s%s", cursor,
+             app->input_log_enabled ? "on" : "off",
+             (app->input_log_enabled != (app->input_log.file != NULL))
+                 ? " (restart)"
+                 : "");
+    break;
+  default:
+    out[0] = '\0';
+    break;
+  }
+}
+
+static void usb_hid_autofire_format_options(AutofireViewLine *lines,
+                                            const UsbHidAutofireApp *app) {
+  // Scrolls so the selected row stays in view.
+  uint32_t first = (app->option < OPTIONS_VISIBLE_ROWS)
+                       ? 0U
+                       : (app->option - OPTIONS_VISIBLE_ROWS + 1U);
+
+  for (uint32_t row = 0U; row < OPTIONS_VISIBLE_ROWS; row++) {
+    if ((first + row) >= AutofireOptionCount) {
+      break;
+    }
+    usb_hid_autofire_format_option(lines[row], AUTOFIRE_VIEW_LINE_SIZE, app,
+                                   (AutofireOption)(first + row));
+  }
+}
+
+static void usb_hid_autofire_render_options(Canvas *canvas,
+                                            const AutofireViewModel *view) {
+  canvas_set_font(canvas, FontPrimary);
+  canvas_draw_str(canvas, 0, 10, "Options");
+  usb_hid_autofire_draw_page_arrows(canvas);
+
+  canvas_set_font(canvas, FontSecondary);
+  for (uint32_t row = 0U; row < OPTIONS_VISIBLE_ROWS; row++) {
+    usb_hid_autofire_draw_line(canvas, 0, 21 + (row * 9U), view->lines[row]);
+  }
+
+  canvas_draw_icon(canvas, 0, 55, &I_Ok_btn_9x9);
+  canvas_draw_str(canvas, 12, 63, "change");
+  canvas_draw_icon(canvas, 50, 57, &I_ButtonUp_7x4);
+  canvas_draw_icon(canvas, 59, 57, &I_ButtonDown_7x4);
+  canvas_draw_str(canvas, 70, 63, "select");
+}
+
+static void usb_hid_autofire_format_bench(AutofireViewLine *lines,
+                                          const UsbHidAutofireApp *app) {
+  const AutofireRateStats *stats = &app->rate_stats;
+  char cps_str[24];
+
+  usb_hid_autofire_format_cps(cps_str, sizeof(cps_str), stats->target_cps_x10);
+  snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "Target:%s  Loop:%s", cps_str,
+           (app->target_cps_x10 > 0U) ? "PI" : "open");
+
+  if (stats->steady_intervals == 0U) {
+    snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "Not settled yet");
+  } else {
+    uint32_t error_bp = (stats->error_bp < 0) ? (uint32_t)(-stats->error_bp)
+                                              : (uint32_t)stats->error_bp;
+    snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "Rate:%lu.%02lu CPS",
+             (unsigned long)(stats->measured_cps_x100 / 100U),
+             (unsigned long)(stats->measured_cps_x100 % 100U));
+    snprintf(lines[2], AUTOFIRE_VIEW_LINE_SIZE, "Error:%c%lu.%02lu%%",
+             (stats->error_bp < 0) ? '-' : '+',
+             (unsigned long)(error_bp / 100U),
+             (unsigned long)(error_bp % 100U));
   }
+  snprintf(lines[3], AUTOFIRE_VIEW_LINE_SIZE, "Settle:%lums  n:%lu",
+           (unsigned long)stats->settle_ms,
+           (unsigned long)stats->steady_intervals);
 
-  snprintf(status_str, sizeof(status_str), "Status: %s",
-           app->active ? "ACTIVE" : "PAUSED");
-  snprintf(mode_str, sizeof(mode_str), "Mode: %s",
-           usb_hid_autofire_mode_label(app->mode));
-  snprintf(preset_str, sizeof(preset_str), "Preset: %s",
-           usb_hid_autofire_preset_label(app->preset));
+  // Short and long rolling windows side by side.
+  char long_cps_str[24];
   usb_hid_autofire_format_cps(cps_str, sizeof(cps_str), app->realtime_cps_x10);
-  snprintf(delay_rate_str, sizeof(delay_rate_str), "Delay:%lums  Rate:%s",
-           (unsigned long)app->autofire_delay_ms, cps_str);
+  usb_hid_autofire_format_cps(long_cps_str, sizeof(long_cps_str),
+                              app->realtime_long_cps_x10);
+  snprintf(lines[4], AUTOFIRE_VIEW_LINE_SIZE, "Last %u:%s  %u:%s",
+           AUTOFIRE_CPS_SHORT_WINDOW, cps_str, AUTOFIRE_CPS_WINDOW_SIZE,
+           long_cps_str);
+}
 
+static void usb_hid_autofire_render_bench(Canvas *canvas,
+                                          const AutofireViewModel *view) {
+  canvas_set_font(canvas, FontPrimary);
+  canvas_draw_str(canvas, 0, 10, "Rate Bench");
+  usb_hid_autofire_draw_page_arrows(canvas);
+
+  canvas_set_font(canvas, FontSecondary);
+  for (uint32_t line = 0U; line < 5U; line++) {
+    usb_hid_autofire_draw_line(canvas, 0, 22 + (line * 10U),
+                               view->lines[line]);
+  }
+}
+
+// Shows the channel under the cursor, one field per row.
+static void usb_hid_autofire_format_channels(AutofireViewLine *lines,
+                                             const UsbHidAutofireApp *app) {
+  uint32_t index = app->channel_cursor / AutofireChannelFieldCount;
+  uint32_t field = app->channel_cursor % AutofireChannelFieldCount;
+  const AutofireChannelConfig *channel = &app->channels[index];
+  char value_str[32];
+
+  snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "Channels %lu/%u",
+           (unsigned long)(index + 1U), AUTOFIRE_EXTRA_CHANNEL_COUNT);
+  for (uint32_t row = 0U; row < AutofireChannelFieldCount; row++) {
+    const char *cursor = (row == field) ? "> " : "  ";
+    char *line = lines[row + 1U];
+    switch (row) {
+    case AutofireChannelFieldEnabled:
+      snprintf(line, AUTOFIRE_VIEW_LINE_SIZE, "%sFire: %s", cursor,
+               channel->enabled ? "on" : "off");
+      break;
+    case AutofireChannelFieldTarget:
+      usb_hid_autofire_format_target(value_str, sizeof(value_str),
+                                     (AutofireMode)channel->mode,
+                                     app->key_code, app->key_modifiers);
+      snprintf(line, AUTOFIRE_VIEW_LINE_SIZE, "%s%s", cursor, value_str);
+      break;
+    case AutofireChannelFieldDelay:
+      usb_hid_autofire_format_channel_delay(value_str, sizeof(value_str),
+                                            channel->delay_ms);
+      snprintf(line, AUTOFIRE_VIEW_LINE_SIZE, "%sEvery: %s", cursor,
+               value_str);
+      break;
+    case AutofireChannelFieldDuty:
+      snprintf(line, AUTOFIRE_VIEW_LINE_SIZE, "%sDuty: %lu%%", cursor,
+               (unsigned long)channel->duty_percent);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void usb_hid_autofire_render_channels(Canvas *canvas,
+                                             const AutofireViewModel *view) {
+  canvas_set_font(canvas, FontPrimary);
+  canvas_draw_str(canvas, 0, 10, view->lines[0]);
+  usb_hid_autofire_draw_page_arrows(canvas);
+
+  canvas_set_font(canvas, FontSecondary);
+  for (uint32_t row = 0U; row < AutofireChannelFieldCount; row++) {
+    usb_hid_autofire_draw_line(canvas, 0, 21 + (row * 9U),
+                               view->lines[row + 1U]);
+  }
+
+  canvas_draw_icon(canvas, 0, 55, &I_Ok_btn_9x9);
+  canvas_draw_str(canvas, 12, 63, "change");
+  canvas_draw_icon(canvas, 50, 57, &I_ButtonUp_7x4);
+  canvas_draw_icon(canvas, 59, 57, &I_ButtonDown_7x4);
+  canvas_draw_str(canvas, 70, 63, "select");
+}
+
+#ifdef USB_HID_AUTOFIRE_PROFILE
+static void usb_hid_autofire_format_profile(AutofireViewLine *lines,
+                                            const UsbHidAutofireApp *app) {
+  for (uint32_t i = 0U; i < AutofireProfileCount; i++) {
+    usb_hid_autofire_profile_format(lines[i], AUTOFIRE_VIEW_LINE_SIZE,
+                                    &app->profile[i],
+                                    (AutofireProfileSection)i);
+  }
+}
+
+static void usb_hid_autofire_render_profile(Canvas *canvas,
+                                            const AutofireViewModel *view) {
+  canvas_set_font(canvas, FontPrimary);
+  canvas_draw_str(canvas, 0, 10, "Profile");
+  usb_hid_autofire_draw_page_arrows(canvas);
+
+  canvas_set_font(canvas, FontSecondary);
+  canvas_draw_str(canvas, 42, 10, "n min/avg/max us");
+  for (uint32_t row = 0U; row < AutofireProfileCount; row++) {
+    usb_hid_autofire_draw_line(canvas, 0, 22 + (row * 10U), view->lines[row]);
+  }
+}
+#endif
+
+static void usb_hid_autofire_format_main(AutofireViewLine *lines,
+                                         const UsbHidAutofireApp *app,
+                                         uint32_t fields) {
+  if ((fields & AutofireViewStatus) && app->hold_to_fire) {
+    // Input to first report of the last hold, and the worst so far.
+    snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "%s  Lat:%lu/%lums",
+             app->active ? "FIRING" : "Hold OK",
+             (unsigned long)__atomic_load_n(&app->engine.hold_latency_ms,
+                                            __ATOMIC_RELAXED),
+             (unsigned long)__atomic_load_n(&app->engine.hold_latency_max_ms,
+                                            __ATOMIC_RELAXED));
+  } else if ((fields & AutofireViewStatus) && (app->burst_count > 0U) &&
+             !app->sequence_enabled) {
+    snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "Status: %s  Burst:%lu",
+             app->active ? "ACTIVE" : "PAUSED",
+             (unsigned long)app->burst_count);
+  } else if (fields & AutofireViewStatus) {
+    snprintf(lines[0], AUTOFIRE_VIEW_LINE_SIZE, "Status: %s",
+             app->active ? "ACTIVE" : "PAUSED");
+  }
+  if ((fields & AutofireViewMode) && app->sequence_enabled) {
+    snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "Mode: Sequence (%lu ops)",
+             (unsigned long)app->sequence.count);
+  } else if (fields & AutofireViewMode) {
+    char target_str[32];
+    usb_hid_autofire_format_target(target_str, sizeof(target_str), app->mode,
+                                   app->key_code, app->key_modifiers);
+    snprintf(lines[1], AUTOFIRE_VIEW_LINE_SIZE, "Mode: %s", target_str);
+  }
+  if (fields & AutofireViewPreset) {
+    snprintf(lines[2], AUTOFIRE_VIEW_LINE_SIZE, "Preset: %s",
+             usb_hid_autofire_preset_label(app->preset));
+  }
+  if (fields & AutofireViewRate) {
+    char cps_str[24];
+    usb_hid_autofire_format_cps(cps_str, sizeof(cps_str),
+                                app->realtime_cps_x10);
+    if (app->target_cps_x10 > 0U) {
+      char target_str[24];
+      usb_hid_autofire_format_cps(target_str, sizeof(target_str),
+                                  app->target_cps_x10);
+      snprintf(lines[3], AUTOFIRE_VIEW_LINE_SIZE, "Target:%s  Rate:%s",
+               target_str, cps_str);
+    } else {
+      snprintf(lines[3], AUTOFIRE_VIEW_LINE_SIZE, "Delay:%lums  Rate:%s",
+               (unsigned long)app->autofire_delay_ms, cps_str);
+    }
+  }
+}
+
+static void usb_hid_autofire_render_main(Canvas *canvas,
+                                         const AutofireViewModel *view) {
   canvas_set_font(canvas, FontPrimary);
   canvas_draw_str(canvas, 0, 10, "USB HID Autofire");
   canvas_draw_str(canvas, 90, 10, "v");
   canvas_draw_str(canvas, 96, 10, VERSION);
 
   canvas_set_font(canvas, FontSecondary);
-  canvas_draw_str(canvas, 0, 22, status_str);
-  canvas_draw_str(canvas, 0, 32, mode_str);
-  canvas_draw_str(canvas, 0, 42, preset_str);
-  canvas_draw_str(canvas, 0, 52, delay_rate_str);
+  for (uint32_t line = 0U; line < 4U; line++) {
+    canvas_draw_str(canvas, 0, 22 + (line * 10U), view->lines[line]);
+  }
   canvas_draw_icon(canvas, 0, 55, &I_Pin_back_arrow_10x8);
   canvas_draw_str(canvas, 13, 63, "hold:help");
   canvas_draw_icon(canvas, 72, 56, &I_ButtonUp_7x4);
   canvas_draw_icon(canvas, 81, 56, &I_ButtonDown_7x4);
   canvas_draw_str(canvas, 92, 63, "mode");
 }
+
+void usb_hid_autofire_view_invalidate(UsbHidAutofireApp *app,
+                                      uint32_t fields) {
+  app->view.dirty |= fields;
+  app->ui_dirty = true;
+}
+
+// Brings the view model up to date with the app state. Runs on the main
+// loop before each view port update, so draws in between cost no
+// formatting.
+void usb_hid_autofire_view_update(UsbHidAutofireApp *app) {
+  AutofireViewModel *view = &app->view;
+  uint32_t fields = view->dirty;
+  if (app->screen != view->screen) {
+    fields = AutofireViewAll;
+  }
+  if (fields == 0U) {
+    return;
+  }
+
+  furi_mutex_acquire(view->mutex, FuriWaitForever);
+  if (app->screen == AutofireScreenMain) {
+    usb_hid_autofire_format_main(view->lines, app, fields);
+    for (uint32_t field = AutofireViewStatus; field <= AutofireViewRate;
+         field <<= 1U) {
+      view->formats += (fields & field) ? 1U : 0U;
+    }
+  } else {
+    memset(view->lines, 0, sizeof(view->lines));
+    if (app->screen == AutofireScreenHelp) {
+      usb_hid_autofire_format_help(view->lines, app);
+    } else if (app->screen == AutofireScreenStats) {
+      usb_hid_autofire_format_stats(view->lines, app);
+    } else if (app->screen == AutofireScreenOptions) {
+      usb_hid_autofire_format_options(view->lines, app);
+    } else if (app->screen == AutofireScreenBench) {
+      usb_hid_autofire_format_bench(view->lines, app);
+    } else if (app->screen == AutofireScreenChannels) {
+      usb_hid_autofire_format_channels(view->lines, app);
+    }
+#ifdef USB_HID_AUTOFIRE_PROFILE
+    else if (app->screen == AutofireScreenProfile) {
+      usb_hid_autofire_format_profile(view->lines, app);
+    }
+#endif
+    view->formats++;
+  }
+  view->screen = app->screen;
+  view->dirty = 0U;
+  furi_mutex_release(view->mutex);
+}
+
+static bool usb_hid_autofire_ui_display_on(const UsbHidAutofireApp *app) {
+  return (furi_get_tick() - app->ui_last_input_tick) < UI_DISPLAY_OFF_MS;
+}
+
+// Live metrics refresh while firing: fast while they change, slow once
+// they settle, and not at all on pages without live metrics or with the
+// display off. Every input event reprograms the timer, so the key that
+// turns the display on restarts it.
+static uint32_t
+usb_hid_autofire_ui_refresh_period_ms(const UsbHidAutofireApp *app) {
+  if (!app->active || (app->screen == AutofireScreenHelp) ||
+      (app->screen == AutofireScreenOptions) ||
+      (app->screen == AutofireScreenChannels) ||
+      !usb_hid_autofire_ui_display_on(app)) {
+    return 0U;
+  }
+  if (app->ui_quiet_refreshes >= UI_REFRESH_QUIET_LIMIT) {
+    return UI_REFRESH_SLOW_PERIOD_MS;
+  }
+  return UI_REFRESH_PERIOD_MS;
+}
+
+// Reprograms the refresh timer when the policy picks a new period.
+void usb_hid_autofire_ui_refresh_update(UsbHidAutofireApp *app) {
+  uint32_t period_ms = usb_hid_autofire_ui_refresh_period_ms(app);
+  if (!app->ui_refresh_timer || (period_ms == app->ui_refresh_period_ms)) {
+    return;
+  }
+
+  app->ui_refresh_period_ms = period_ms;
+  if (period_ms == 0U) {
+    furi_timer_stop(app->ui_refresh_timer);
+  } else {
+    furi_timer_start(app->ui_refresh_timer, furi_ms_to_ticks(period_ms));
+  }
+}
+
+void usb_hid_autofire_ui_refresh_done(UsbHidAutofireApp *app, bool changed) {
+  app->ui_stats.refresh_wakeups++;
+  app->ui_quiet_refreshes = changed ? 0U : (app->ui_quiet_refreshes + 1U);
+  usb_hid_autofire_ui_refresh_update(app);
+}
+
+// Time left before a pending redraw may run, so bursts of input coalesce
+// into one redraw per interval.
+uint32_t usb_hid_autofire_ui_redraw_wait_ms(const UsbHidAutofireApp *app) {
+  uint32_t elapsed_ms = furi_get_tick() - app->ui_last_redraw_tick;
+  return (elapsed_ms < UI_REDRAW_MIN_INTERVAL_MS)
+             ? (UI_REDRAW_MIN_INTERVAL_MS - elapsed_ms)
+             : 0U;
+}
+
+void usb_hid_autofire_ui_redraw(UsbHidAutofireApp *app) {
+  usb_hid_autofire_view_update(app);
+  view_port_update(app->view_port);
+  app->ui_dirty = false;
+  app->ui_last_redraw_tick = furi_get_tick();
+  app->ui_stats.redraws++;
+}
+
+void usb_hid_autofire_render_callback(Canvas *canvas, void *ctx) {
+  UsbHidAutofireApp *app = ctx;
+  AutofireViewModel *view = &app->view;
+
+  AUTOFIRE_PROFILE_BEGIN(render_start);
+  canvas_clear(canvas);
+
+  furi_mutex_acquire(view->mutex, FuriWaitForever);
+  switch (view->screen) {
+  case AutofireScreenHelp:
+    usb_hid_autofire_render_help(canvas, view);
+    break;
+  case AutofireScreenStats:
+    usb_hid_autofire_render_stats(canvas, view);
+    break;
+  case AutofireScreenOptions:
+    usb_hid_autofire_render_options(canvas, view);
+    break;
+  case AutofireScreenBench:
+    usb_hid_autofire_render_bench(canvas, view);
+    break;
+  case AutofireScreenChannels:
+    usb_hid_autofire_render_channels(canvas, view);
+    break;
+#ifdef USB_HID_AUTOFIRE_PROFILE
+  case AutofireScreenProfile:
+    usb_hid_autofire_render_profile(canvas, view);
+    break;
+#endif
+  case AutofireScreenMain:
+  default:
+    usb_hid_autofire_render_main(canvas, view);
+    break;
+  }
+  furi_mutex_release(view->mutex);
+  AUTOFIRE_PROFILE_END(app, AutofireProfileRender, render_start);
+}